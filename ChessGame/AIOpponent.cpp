@@ -0,0 +1,113 @@
+#include "AIOpponent.h"
+#include "Profiler.h"
+#include "Log.h"
+
+AIOpponent::AIOpponent(int depth) : depth(depth) {
+	engine.onBestMove = [this](const Move& move, optional<Move> expectedReply) {
+		lock_guard<mutex> lock(resultMutex);
+		result = { move, expectedReply };
+	};
+}
+
+void AIOpponent::startSearch(const MoveGenerator& generator) {
+	engine.setPosition(generator); // Stops the ponder search, its result is thrown away below
+
+	{
+		lock_guard<mutex> lock(resultMutex);
+		result.reset();
+	}
+
+	SearchLimits limits;
+	limits.depth = depth;
+
+	engine.go(limits);
+}
+
+void AIOpponent::startPondering(const Move& move, const Move& expectedReply) {
+	MoveGenerator ponderPosition = engine.getPosition();
+
+	makeUciMove(ponderPosition, move);
+	makeUciMove(ponderPosition, expectedReply);
+
+	ponderKey = ponderPosition.getSearchKey();
+
+	engine.setPosition(ponderPosition);
+
+	SearchLimits limits;
+	limits.depth = depth;
+	limits.ponder = true; // Doesn't send a move until the player makes the expected reply
+
+	engine.go(limits);
+	pondering = true;
+}
+
+optional<Move> AIOpponent::update(Game& game) {
+	if (!thinking) {
+		PROFILE_SCOPE("AIOpponent::startThinking");
+
+		MoveGenerator generator(game);
+
+		// Book and tablebase moves don't need a search
+		optional<Move> knownMove = generator.getBookMove();
+		if (!knownMove) knownMove = generator.getTablebaseMove();
+
+		if (knownMove) {
+			stop();
+			return knownMove;
+		}
+
+		// The player made the move we expected, and tiles didn't change anything, so the search is already running or done
+		if (pondering && generator.getSearchKey() == ponderKey) {
+			GAME_LOG("Ponder hit" << endl);
+			ponderHits++;
+			engine.ponderHit();
+		}
+		else {
+			if (pondering) {
+				GAME_LOG("Ponder miss" << endl);
+				ponderMisses++;
+			}
+
+			startSearch(generator); // The transposition table still has what the ponder search found
+		}
+
+		pondering = false;
+		thinking = true;
+	}
+
+	optional<pair<Move, optional<Move>>> found;
+
+	{
+		lock_guard<mutex> lock(resultMutex);
+		found = result;
+		result.reset();
+	}
+
+	if (!found) return nullopt;
+
+	thinking = false;
+
+	auto [move, expectedReply] = found.value();
+
+	if (expectedReply) startPondering(move, expectedReply.value());
+
+	return move;
+}
+
+void AIOpponent::stop() {
+	engine.stop();
+	engine.wait();
+
+	lock_guard<mutex> lock(resultMutex);
+	result.reset();
+	thinking = false;
+	pondering = false;
+}
+
+bool AIOpponent::isThinking() { return thinking; }
+
+bool AIOpponent::isPondering() { return pondering; }
+
+int AIOpponent::getPonderHits() { return ponderHits; }
+
+int AIOpponent::getPonderMisses() { return ponderMisses; }
@@ -0,0 +1,60 @@
+#ifndef AIOPPONENT_H
+#define AIOPPONENT_H
+
+#include <mutex>
+#include <optional>
+#include "Engine.h"
+#include "game.h"
+
+using namespace std;
+
+#define AI_SEARCH_DEPTH 4
+
+/// <summary>
+/// The computer player of a game. It searches on the engine's thread so the game keeps running while it thinks, and after every
+/// move it ponders on the reply it expects, so when the player makes that move the answer is already there
+/// </summary>
+class AIOpponent {
+	private:
+		Engine engine;
+		int depth;
+
+		mutex resultMutex;
+		optional<pair<Move, optional<Move>>> result; // Best move and expected reply, set from the engine's thread
+
+		bool thinking = false;  // Searching for the move to play this turn
+		bool pondering = false; // Searching the position after the expected reply, on the player's time
+		uint64_t ponderKey = 0; // Search key of the position being pondered on
+
+		int ponderHits = 0;
+		int ponderMisses = 0;
+
+		void startSearch(const MoveGenerator& generator);
+
+		void startPondering(const Move& move, const Move& expectedReply);
+
+	public:
+		AIOpponent(int depth = AI_SEARCH_DEPTH);
+
+		/// <summary>
+		/// Thinks about the move for the current turn, call it every frame while it's the AI's turn
+		/// </summary>
+		/// <param name="game">The game the AI is playing in</param>
+		/// <returns>The move to play once the search is done, nullopt while it's still thinking</returns>
+		optional<Move> update(Game& game);
+
+		/// <summary>
+		/// Stops thinking and pondering, for when the position changes without a move (like loading a FEN)
+		/// </summary>
+		void stop();
+
+		bool isThinking();
+
+		bool isPondering();
+
+		int getPonderHits();
+
+		int getPonderMisses();
+};
+
+#endif
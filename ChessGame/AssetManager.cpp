@@ -0,0 +1,155 @@
+#include "AssetManager.h"
+#include <iostream>
+#include "Profiler.h"
+#include "AssetPack.h"
+
+static double millisecondsSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+AssetManager& AssetManager::get() {
+	static AssetManager manager;
+	return manager;
+}
+
+AssetManager::~AssetManager() { stop(); }
+
+void AssetManager::loadImage(const string& path, function<void(Image)> onLoaded) {
+	AssetJob job;
+	job.kind = AssetKind::IMAGE;
+	job.path = path;
+	job.onImage = move(onLoaded);
+
+	request(move(job));
+}
+
+void AssetManager::loadWave(const string& path, function<void(Wave)> onLoaded) {
+	AssetJob job;
+	job.kind = AssetKind::WAVE;
+	job.path = path;
+	job.onWave = move(onLoaded);
+
+	request(move(job));
+}
+
+void AssetManager::request(AssetJob job) {
+	job.requested = chrono::steady_clock::now();
+
+	if (requestedCount == finishedCount) firstRequest = job.requested; // Start of a new batch
+
+	requestedCount++;
+
+	{
+		lock_guard<mutex> lock(jobMutex);
+
+		stopping = false;
+		pending.push_back(move(job));
+	}
+
+	jobAvailable.notify_one();
+
+	// Nothing that runs without a window loads assets, so the threads are only started once they're needed
+	while (workers.size() < ASSET_WORKERS) workers.push_back(thread(&AssetManager::workerLoop, this));
+}
+
+void AssetManager::workerLoop() {
+	while (true) {
+		AssetJob job;
+
+		{
+			unique_lock<mutex> lock(jobMutex);
+
+			jobAvailable.wait(lock, [&]() { return stopping || !pending.empty(); });
+
+			if (stopping) return;
+
+			job = move(pending.front());
+			pending.pop_front();
+		}
+
+		{
+			PROFILE_SCOPE("AssetManager::decode");
+
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+			// Decoded straight out of the mapped pack if it's in there, otherwise from the loose file.
+			// Only reads and decodes, nothing here touches the window or audio device
+			AssetBlob blob = AssetPack::get().find(job.path);
+
+			if (blob.data) {
+				const char* fileType = GetFileExtension(job.path.c_str());
+
+				if (job.kind == AssetKind::IMAGE) job.image = LoadImageFromMemory(fileType, blob.data, (int)blob.size);
+				else job.wave = LoadWaveFromMemory(fileType, blob.data, (int)blob.size);
+			} else {
+				if (job.kind == AssetKind::IMAGE) job.image = LoadImage(job.path.c_str());
+				else job.wave = LoadWave(job.path.c_str());
+			}
+
+			job.decodeMilliseconds = millisecondsSince(start);
+		}
+
+		lock_guard<mutex> lock(jobMutex);
+		decoded.push_back(move(job));
+	}
+}
+
+void AssetManager::update() {
+	if (requestedCount == finishedCount) return;
+
+	deque<AssetJob> finished;
+
+	{
+		lock_guard<mutex> lock(jobMutex);
+		finished.swap(decoded);
+	}
+
+	for (AssetJob& job : finished) {
+		PROFILE_SCOPE("AssetManager::update");
+
+		if (job.kind == AssetKind::IMAGE) {
+			if (!job.image.data) cout << "Failed to load image: " << job.path << endl;
+
+			job.onImage(job.image);
+		} else {
+			if (!job.wave.data) cout << "Failed to load sound: " << job.path << endl;
+
+			job.onWave(job.wave);
+		}
+
+		finishedCount++;
+
+		cout << "Loaded " << job.path << " in " << millisecondsSince(job.requested) << " ms (decoding took " << job.decodeMilliseconds << " ms)" << endl;
+	}
+
+	if (!finished.empty() && requestedCount == finishedCount) {
+		cout << "Loaded " << requestedCount << " assets in " << millisecondsSince(firstRequest) << " ms" << endl;
+	}
+}
+
+void AssetManager::stop() {
+	{
+		lock_guard<mutex> lock(jobMutex);
+		stopping = true;
+	}
+
+	jobAvailable.notify_all();
+
+	for (thread& worker : workers) worker.join();
+	workers.clear();
+
+	for (AssetJob& job : decoded) {
+		if (job.kind == AssetKind::IMAGE) UnloadImage(job.image);
+		else UnloadWave(job.wave);
+	}
+
+	pending.clear();
+	decoded.clear();
+
+	requestedCount = 0;
+	finishedCount = 0;
+}
+
+bool AssetManager::isLoading() { return finishedCount < requestedCount; }
+
+float AssetManager::getProgress() { return requestedCount > 0 ? (float)finishedCount / requestedCount : 1.0f; }
@@ -0,0 +1,109 @@
+#ifndef ASSETMANAGER_H
+#define ASSETMANAGER_H
+
+#include "raylib.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+using namespace std;
+
+#define ASSET_WORKERS 2 // Threads decoding assets, the disk is usually the limit rather than the CPU
+
+enum class AssetKind {
+	IMAGE,
+	WAVE
+};
+
+/// <summary>
+/// Decodes images and sounds on worker threads so the window doesn't wait for the disk. Anything that needs the window or the
+/// audio device (uploading a texture, creating a sound) happens in the callback, which runs on the main thread in update()
+/// </summary>
+class AssetManager {
+	private:
+		struct AssetJob {
+			AssetKind kind;
+			string path;
+
+			function<void(Image)> onImage;
+			function<void(Wave)> onWave;
+
+			Image image = { 0 };
+			Wave wave = { 0 };
+
+			chrono::steady_clock::time_point requested;
+			double decodeMilliseconds = 0.0;
+		};
+
+		vector<thread> workers;
+		bool stopping = false;
+
+		mutex jobMutex;
+		condition_variable jobAvailable;
+
+		deque<AssetJob> pending;  // Waiting for a worker
+		deque<AssetJob> decoded;  // Waiting for update() to hand them out
+
+		// Only touched on the main thread
+		int requestedCount = 0;
+		int finishedCount = 0;
+		chrono::steady_clock::time_point firstRequest;
+
+		AssetManager() = default;
+
+		void request(AssetJob job);
+
+		/// <summary>
+		/// Decodes jobs until the manager stops, runs on each worker
+		/// </summary>
+		void workerLoop();
+
+	public:
+		static AssetManager& get();
+
+		~AssetManager();
+
+		AssetManager(const AssetManager&) = delete;
+		AssetManager& operator=(const AssetManager&) = delete;
+
+		/// <summary>
+		/// Decodes an image on a worker, the workers are started by the first request
+		/// </summary>
+		/// <param name="path">The image file, read from the asset pack if it's in there</param>
+		/// <param name="onLoaded">Called from update() with the image, which it has to unload. The image has no data if it failed to load</param>
+		void loadImage(const string& path, function<void(Image)> onLoaded);
+
+		/// <summary>
+		/// Decodes a sound on a worker, the workers are started by the first request
+		/// </summary>
+		/// <param name="path">The sound file, read from the asset pack if it's in there</param>
+		/// <param name="onLoaded">Called from update() with the wave, which it has to unload. The wave has no data if it failed to load</param>
+		void loadWave(const string& path, function<void(Wave)> onLoaded);
+
+		/// <summary>
+		/// Hands the assets that finished decoding to their callbacks, call it every frame on the main thread
+		/// </summary>
+		void update();
+
+		/// <summary>
+		/// Stops the workers, assets that haven't been handed out are thrown away. Call it before the window closes
+		/// </summary>
+		void stop();
+
+		/// <summary>
+		/// If an asset has been requested and not handed out yet
+		/// </summary>
+		bool isLoading();
+
+		/// <summary>
+		/// Gets how many of the requested assets have been handed out, from 0 to 1
+		/// </summary>
+		float getProgress();
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "AssetPack.h"
+#include "raylib.h"
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+static const char PACK_MAGIC[4] = { 'C', 'G', 'P', 'K' };
+
+// Files the window loads, anything else in the resource directory (the book, tablebases, editor files) stays loose
+static const char* packedExtensions[] = { ".png", ".wav", ".qoa", ".ogg", ".mp3" };
+
+/************************************|
+			   PACK
+|************************************/
+
+AssetPack& AssetPack::get() {
+	static AssetPack pack;
+	return pack;
+}
+
+bool AssetPack::open(const string& path) {
+	close();
+
+	if (!file.open(path)) return false;
+
+	AssetPackHeader header;
+
+	if (file.getSize() < sizeof(header)) {
+		close();
+		return false;
+	}
+
+	memcpy(&header, file.getData(), sizeof(header));
+
+	if (memcmp(header.magic, PACK_MAGIC, 4) != 0 || header.version != ASSET_PACK_VERSION ||
+		header.entries > (file.getSize() - sizeof(header)) / sizeof(AssetPackEntry)) {
+		cout << "Asset pack " << path << " is not a valid pack" << endl;
+		close();
+		return false;
+	}
+
+	const AssetPackEntry* packEntries = (const AssetPackEntry*)(file.getData() + sizeof(header));
+
+	for (uint32_t i = 0; i < header.entries; i++) {
+		const AssetPackEntry& entry = packEntries[i];
+
+		if (entry.offset > file.getSize() || entry.size > file.getSize() - entry.offset || entry.name[ASSET_PACK_NAME_LENGTH - 1] != '\0') {
+			cout << "Asset pack " << path << " is not a valid pack" << endl;
+			close();
+			return false;
+		}
+	}
+
+	// The map is page aligned and the header is 16 bytes, so the entries can be used in place
+	entries = packEntries;
+	entryCount = header.entries;
+
+	cout << "Loaded asset pack " << path << " with " << entryCount << " assets" << endl;
+
+	return true;
+}
+
+void AssetPack::close() {
+	file.close();
+	entries = nullptr;
+	entryCount = 0;
+}
+
+bool AssetPack::isOpen() { return entries != nullptr; }
+
+size_t AssetPack::getEntryCount() { return entryCount; }
+
+AssetBlob AssetPack::find(const string& name) {
+	if (!entries) return {};
+
+	const AssetPackEntry* end = entries + entryCount;
+
+	const AssetPackEntry* entry = lower_bound(entries, end, name, [](const AssetPackEntry& entry, const string& name) {
+		return strcmp(entry.name, name.c_str()) < 0;
+	});
+
+	if (entry == end || name != entry->name) return {};
+
+	return { file.getData() + entry->offset, (size_t)entry->size };
+}
+
+string getDefaultAssetPackPath() { return string(GetApplicationDirectory()) + ASSET_PACK_PATH; }
+
+/************************************|
+			  BUILDER
+|************************************/
+
+PackBuildOptions parsePackBuildOptions(int argc, char** argv) {
+	PackBuildOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--build-pack" && hasValue && strncmp(argv[i + 1], "--", 2) != 0) options.outputPath = argv[++i];
+		else if (argument == "--pack-resources" && hasValue) options.resourceDirectory = argv[++i];
+	}
+
+	return options;
+}
+
+int buildAssetPack(const PackBuildOptions& options) {
+	error_code error;
+
+	vector<pair<string, filesystem::path>> files; // Name in the pack, file it comes from
+
+	for (filesystem::recursive_directory_iterator it(options.resourceDirectory, error), last; !error && it != last; it.increment(error)) {
+		if (!it->is_regular_file()) continue;
+
+		string extension = it->path().extension().string();
+		transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+		if (find(begin(packedExtensions), end(packedExtensions), extension) == end(packedExtensions)) continue;
+
+		string name = "resources/" + filesystem::relative(it->path(), options.resourceDirectory).generic_string();
+
+		if (name.size() >= ASSET_PACK_NAME_LENGTH) {
+			cerr << "Asset name is too long to pack: " << name << endl;
+			return 1;
+		}
+
+		files.push_back({ name, it->path() });
+	}
+
+	if (error) {
+		cerr << "Unable to read resource directory: " << options.resourceDirectory << endl;
+		return 1;
+	}
+
+	// Looked up by binary search
+	sort(files.begin(), files.end(), [](const pair<string, filesystem::path>& a, const pair<string, filesystem::path>& b) {
+		return strcmp(a.first.c_str(), b.first.c_str()) < 0;
+	});
+
+	FILE* pack = fopen(options.outputPath.c_str(), "wb");
+
+	if (!pack) {
+		cerr << "Unable to create asset pack: " << options.outputPath << endl;
+		return 1;
+	}
+
+	AssetPackHeader header = {};
+	memcpy(header.magic, PACK_MAGIC, 4);
+	header.version = ASSET_PACK_VERSION;
+	header.entries = (uint32_t)files.size();
+
+	vector<AssetPackEntry> entries(files.size());
+
+	uint64_t offset = sizeof(header) + files.size() * sizeof(AssetPackEntry);
+
+	// Lay the blobs out first so the entries can be written before them
+	for (size_t i = 0; i < files.size(); i++) {
+		uint64_t size = filesystem::file_size(files[i].second, error);
+
+		if (error) {
+			cerr << "Unable to read asset: " << files[i].second.string() << endl;
+			fclose(pack);
+			return 1;
+		}
+
+		offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+
+		memset(entries[i].name, 0, ASSET_PACK_NAME_LENGTH);
+		memcpy(entries[i].name, files[i].first.c_str(), files[i].first.size());
+		entries[i].offset = offset;
+		entries[i].size = size;
+
+		offset += size;
+	}
+
+	fwrite(&header, sizeof(header), 1, pack);
+	if (!entries.empty()) fwrite(entries.data(), sizeof(AssetPackEntry), entries.size(), pack);
+
+	vector<uint8_t> contents;
+	uint64_t written = sizeof(header) + entries.size() * sizeof(AssetPackEntry);
+
+	for (size_t i = 0; i < files.size(); i++) {
+		FILE* asset = fopen(files[i].second.string().c_str(), "rb");
+
+		contents.resize(entries[i].size);
+
+		if (!asset || fread(contents.data(), 1, contents.size(), asset) != contents.size()) {
+			cerr << "Unable to read asset: " << files[i].second.string() << endl;
+			if (asset) fclose(asset);
+			fclose(pack);
+			return 1;
+		}
+
+		fclose(asset);
+
+		// Pad up to the blob's page
+		vector<uint8_t> padding(entries[i].offset - written, 0);
+
+		fwrite(padding.data(), 1, padding.size(), pack);
+		fwrite(contents.data(), 1, contents.size(), pack);
+
+		written = entries[i].offset + entries[i].size;
+	}
+
+	fclose(pack);
+
+	cout << "Built asset pack " << options.outputPath << " with " << files.size() << " assets, " << written << " bytes" << endl;
+
+	return 0;
+}
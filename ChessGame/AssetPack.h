@@ -0,0 +1,115 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "MemoryMappedFile.h"
+
+using namespace std;
+
+/*
+	Pack files hold every asset the window loads, so they can be mapped once instead of opened one by one:
+
+		AssetPackHeader             16 bytes
+		AssetPackEntry...           64 bytes each, sorted by name
+		Blobs...                    Each starting on an ASSET_PACK_ALIGNMENT boundary
+
+	Entries are named by the path the game loads them from (like "resources/Tiles.png"), so anything missing from the pack
+	falls back to the loose file.
+*/
+
+#define ASSET_PACK_VERSION 1
+
+#define ASSET_PACK_PATH "assets.pack" // In the application directory (see getDefaultAssetPackPath), so it's found from any working directory
+#define ASSET_PACK_ALIGNMENT 4096     // Blobs start on a page, so reading one only touches its own pages
+
+#define ASSET_PACK_NAME_LENGTH 48
+
+struct AssetPackHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t entries;
+	uint32_t reserved;
+};
+
+struct AssetPackEntry {
+	char name[ASSET_PACK_NAME_LENGTH]; // Null terminated
+	uint64_t offset;                   // From the start of the file
+	uint64_t size;
+};
+
+static_assert(sizeof(AssetPackHeader) == 16, "AssetPackHeader has to match the file layout");
+static_assert(sizeof(AssetPackEntry) == 64, "AssetPackEntry has to match the file layout");
+
+/// <summary>
+/// An asset's bytes in the mapped pack, valid until the pack is closed
+/// </summary>
+struct AssetBlob {
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+};
+
+/// <summary>
+/// Every asset in one mapped file, read straight from the mapping by the loaders
+/// </summary>
+class AssetPack {
+	private:
+		MemoryMappedFile file;
+
+		const AssetPackEntry* entries = nullptr;
+		size_t entryCount = 0;
+
+		AssetPack() = default;
+
+	public:
+		static AssetPack& get();
+
+		AssetPack(const AssetPack&) = delete;
+		AssetPack& operator=(const AssetPack&) = delete;
+
+		/// <summary>
+		/// Maps a pack file, replacing the pack that was open. Nothing should be loading from the old pack
+		/// </summary>
+		/// <returns>true if the pack was opened, false if the file doesn't exist or isn't a pack</returns>
+		bool open(const string& path);
+
+		void close();
+
+		bool isOpen();
+
+		size_t getEntryCount();
+
+		/// <summary>
+		/// Finds an asset by the path it would be loaded from, by binary searching the entries
+		/// </summary>
+		/// <returns>The asset, or one with no data if it isn't in the pack</returns>
+		AssetBlob find(const string& name);
+};
+
+/// <summary>
+/// Gets where the game opens the pack from, and where the builder writes it unless told otherwise
+/// </summary>
+string getDefaultAssetPackPath();
+
+/************************************|
+			  BUILDER
+|************************************/
+
+struct PackBuildOptions {
+	string outputPath = getDefaultAssetPackPath();
+	string resourceDirectory = "resources"; // Packed under the same names the game loads them by
+};
+
+/// <summary>
+/// Reads the options of the --build-pack mode: --build-pack [output] [--pack-resources directory]
+/// </summary>
+PackBuildOptions parsePackBuildOptions(int argc, char** argv);
+
+/// <summary>
+/// Builds an asset pack from the images and sounds in the resource directory
+/// </summary>
+/// <returns>The exit code of the program</returns>
+int buildAssetPack(const PackBuildOptions& options);
+
+#endif
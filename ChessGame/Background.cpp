@@ -2,17 +2,12 @@
 #include <iostream>
 #include "isometric.h"
 
-float random_float(float min, float max) {
-	random_device rd;
-	mt19937 gen(rd());
-	uniform_real_distribution<> dis(min, max);
-	return dis(gen);
-}
+void Background::seed(uint64_t seed) { random.seed(seed, RANDOM_STREAM_BACKGROUND); }
 
-Star::Star() {
-	position = raylib::Vector3(random_float(-5, 15), -10, 0);
-	speed = random_float(0.01f, 0.1f);
-	radius = random_float(0.5f, 3.0f);
+Star::Star(Random& random) {
+	position = raylib::Vector3(random.nextFloat(-5, 15), -10, 0);
+	speed = random.nextFloat(0.01f, 0.1f);
+	radius = random.nextFloat(0.5f, 3.0f);
 	color = WHITE;
 }
 
@@ -26,8 +21,8 @@ void SpaceBackground::draw() {
 }
 
 void SpaceBackground::update() {
-	if (rand() % 3 == 0) {
-		stars.push_back(Star());
+	if (random.nextInt(3) == 0) {
+		stars.push_back(Star(random));
 	}
 
 	for (Star& star : stars) {
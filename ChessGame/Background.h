@@ -3,16 +3,22 @@
 
 #include "include/raylib-cpp.hpp"
 #include <vector>
-#include <random>
+#include "Random.h"
 
 using namespace std;
 
-float random_float(float min, float max);
+class Background {
+	protected:
+		Random random;
 
+	public:
+		virtual ~Background() {}
 
+		/// <summary>
+		/// Seeds the random numbers used by the background
+		/// </summary>
+		void seed(uint64_t seed);
 
-class Background {
-	public:
 		virtual void draw() = 0;
 		virtual void update() = 0;
 };
@@ -22,7 +28,7 @@ struct Star {
 	float speed;
 	int radius;
 	Color color;
-	Star();
+	Star(Random& random);
 };
 
 class SpaceBackground : public Background {
@@ -8,6 +8,19 @@
 #include "MoveGenerator.h"
 #include "textures.h"
 #include "PromotionMenu.h"
+#include "Profiler.h"
+#include "Simulation.h"
+#include "GameRecord.h"
+#include "OpeningBook.h"
+#include "Tablebase.h"
+#include "Uci.h"
+#include "AIOpponent.h"
+#include "GameLoop.h"
+#include "Replay.h"
+#include "Server.h"
+#include "Sync.h"
+#include "AssetManager.h"
+#include "AssetPack.h"
 
 using namespace std;
 
@@ -22,27 +35,32 @@ raylib::Vector3 interpolatedCursorIsoPositionFloat = { 0.0f, 0.0f, 0.0f };
 Tile* selectedTile = nullptr;
 Piece* selectedPiece = nullptr;
 
+ReplayViewer* replayViewer = nullptr; // Set in the --replay mode
+
 void UpdateDrawFrame(Camera2D camera, Game& game) {
     float time = GetTime(); // Get elapsed time
 
     Board& board = game.getBoard();
 
-    BeginDrawing();
-
-    BeginMode2D(camera);
-
     raylib::Vector2 cursorPosition = GetMousePosition(); // Get the cursor position
 
     raylib::Vector3 cursorIsoPositionFloat = ScreenToISOFloat(cursorPosition - camera.offset, 2.0f);
 
     interpolatedCursorIsoPositionFloat = interpolatedCursorIsoPositionFloat.Lerp(cursorIsoPositionFloat, 0.2f);
 
+    // Selected before prerendering, the static layer leaves out the highlighted cells
     if (selectedTile) {
         game.setSelectedCell(board.getCell(selectedTile));
     } else {
         game.setSelectedCell(board.getCellAtScreenPosition(cursorPosition, camera));
     }
 
+    game.prerender(); // Off-screen rendering has to happen before the frame starts
+
+    BeginDrawing();
+
+    BeginMode2D(camera);
+
     game.draw(atlas);
 
     if (selectedPiece) {
@@ -73,19 +91,134 @@ void UpdateDrawFrame(Camera2D camera, Game& game) {
         p2DiscardedPieces[i]->drawIcon(SCREEN_WIDTH - 64 + (i % 2) * 32 - 32, 50 + (16 * i));
     }
 
+    float timeScale = AnimationTimeline::get().getTimeScale();
+
+    if (timeScale != 1.0f) {
+        const char* speed = timeScale > 0.0f ? (const char*)TextFormat("Speed %gx", timeScale) : "Speed instant";
+
+        DrawText(speed, SCREEN_WIDTH - MeasureText(speed, 10) - 10, SCREEN_HEIGHT - 20, 10, WHITE);
+    }
+
+    if (replayViewer) replayViewer->draw(10, SCREEN_HEIGHT - 42, SCREEN_WIDTH - 20);
+
+    Profiler::get().drawOverlay(10, 10);
+
+    EndDrawing();
+}
+
+void DrawLoadingFrame(float progress) {
+    BeginDrawing();
+
+    ClearBackground(BLACK);
+
+    const char* text = "Loading...";
+
+    DrawText(text, (SCREEN_WIDTH / 2) - (MeasureText(text, 20) / 2), SCREEN_HEIGHT / 2 - 20, 20, WHITE);
+
+    DrawRectangle(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 + 10, SCREEN_WIDTH / 2, 4, Fade(WHITE, 0.3f));
+    DrawRectangle(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 + 10, (int)(SCREEN_WIDTH / 2 * progress), 4, WHITE);
+
     EndDrawing();
 }
 
-int main() {
+int main(int argc, char** argv) {
+    string recordPath = "";
+    string startFEN = "";
+    string bookPath = OPENING_BOOK_PATH;
+    string tablebasePath = TABLEBASE_PATH;
+    string replayPath = "";
+    size_t replayGame = 0;
+    float animationSpeed = 1.0f;
+
+    // Modes that run without a window
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (argument == "--selfplay") return runSelfPlay(parseSimulationOptions(argc, argv));
+        if (argument == "--uci") return runUci();
+        if (argument == "--server") return runServer(parseServerOptions(argc, argv));
+        if (argument == "--loadgen") return runLoadGen(parseLoadGenOptions(argc, argv));
+        if (argument == "--sync-bench") return runSyncBench(argc, argv);
+        if (argument == "--print-record" && hasValue) return printGameRecord(argv[i + 1]);
+        if (argument == "--build-book") return buildOpeningBook(parseBookBuildOptions(argc, argv));
+        if (argument == "--build-pack") return buildAssetPack(parsePackBuildOptions(argc, argv));
+        if (argument == "--convert-audio") return convertAudio(parseAudioConvertOptions(argc, argv));
+        if (argument == "--generate-tablebases") return generateTablebases(parseTablebaseOptions(argc, argv));
+        if (argument == "--book" && hasValue) bookPath = argv[++i];
+        if (argument == "--tablebases" && hasValue) tablebasePath = argv[++i];
+        if (argument == "--record" && hasValue) recordPath = argv[++i];
+        if (argument == "--fen" && hasValue) startFEN = argv[++i];
+        if (argument == "--animation-speed" && hasValue) animationSpeed = stof(argv[++i]); // 0 plays every turn instantly
+        if (argument == "--replay" && hasValue) replayPath = argv[++i];
+        if (argument == "--replay-game" && hasValue) replayGame = stoul(argv[++i]);
+    }
+
+    // Review a recorded game instead of playing one
+    Replay replay;
+
+    if (!replayPath.empty() && !replay.load(replayPath, replayGame)) {
+        cerr << "Unable to load game " << replayGame << " of the game record: " << replayPath << endl;
+        return 1;
+    }
+
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Chess");
     
     InitAudioDevice();
 
-    SetTargetFPS(60);
+    SetTargetFPS(GAME_FPS);
+
+    AssetPack::get().open(getDefaultAssetPackPath()); // Assets are loaded from the loose files without a pack
+
+    AssetManager& assets = AssetManager::get();
+
+    // The atlas is decoded on the asset workers and uploaded once it arrives, the board can't be drawn until then
+    atlas = new raylib::Texture2D();
+
+    bool atlasLoaded = false;
+
+    assets.loadImage("resources/Tiles.png", [&](Image image) {
+        if (image.data) *atlas = raylib::Texture2D(LoadTextureFromImage(image));
+
+        UnloadImage(image);
+        atlasLoaded = true;
+    });
+
+    OpeningBook::get().open(bookPath); // The AI searches every move without a book
+    Tablebases::get().open(tablebasePath); // Or plays endings by evaluation without tablebases
+
+    AnimationTimeline::get().setTimeScale(animationSpeed);
+
+    Game game = Game(atlas, false, replayPath.empty() ? Random::createSeed() : replay.getSeed()); // A replay spawns tiles from the seed it was played with
+
+    if (!startFEN.empty() && replayPath.empty()) game.loadFEN(startFEN); // Start from a position instead of the start of a game
+
+    // Sound effects keep loading after the board shows up, they're only needed once something happens
+    while (!atlasLoaded && !WindowShouldClose()) {
+        assets.update();
+
+        DrawLoadingFrame(assets.getProgress());
+    }
+
+    cout << "Board ready " << GetTime() * 1000.0 << " ms after the window opened" << endl;
+
+    // Record the game as it's played, flushing every entry so nothing is lost if the game is closed
+    GameRecordWriter recordWriter;
+
+    if (!recordPath.empty() && replayPath.empty()) {
+        if (recordWriter.open(recordPath)) {
+            recordWriter.beginGame(game.getSeed());
 
-    atlas = new raylib::Texture2D(LoadTexture("resources/Tiles.png"));
+            recordGame(game, [&](RecordEntry entry) {
+                recordWriter.write(entry);
+                recordWriter.flush();
+            });
+        } else {
+            cout << "Unable to open game record: " << recordPath << endl;
+        }
+    }
 
-    Game game = Game(atlas);
+    AIOpponent ai; // Ponders on the player's time, so it's created once for the whole game
 
     Camera2D camera = { 0 };
     camera.target = raylib::Vector2{ 0.0f, 0.0f };
@@ -105,103 +238,196 @@ int main() {
     /*
         LOOP
     */ 
+    Profiler& profiler = Profiler::get();
+
+    // Nothing is simulated unless an event needs it, and the frame rate drops while the player is idle
+    GameLoop loop(game);
+
+    game.onStateUpdate = [&]() { loop.push({ GameLoopEventType::STATE_UPDATED }); };
+    game.getBoard().onAnimationsFinished = [&]() { loop.push({ GameLoopEventType::ANIMATIONS_FINISHED }); };
+
+    // Left and right step through the replay, home and end jump to either end, the bar at the bottom scrubs
+    ReplayViewer viewer(replay);
+
+    if (!replayPath.empty()) {
+        replayViewer = &viewer;
+
+        loop.review();
+        viewer.seek(game, loop, 0);
+
+        cout << "Replaying " << replay.getPlyCount() << " plies: " << getOutcomeString(replay.getOutcome()) << endl;
+    }
+
     while (!exitWindow && !WindowShouldClose()) {
-        game.updateMusicStreams();
+        profiler.beginFrame();
+
+        profiler.handleInput(); // F3 toggles the overlay, F4 exports a trace
+
+        assets.update(); // Hands over the sounds that finished loading
+
+        AnimationTimeline& timeline = AnimationTimeline::get();
+
+        // F5 cycles the animation speed, space skips the animations that are playing
+        if (IsKeyPressed(KEY_F5)) {
+            int speed = 0;
+            while (speed < ANIMATION_SPEED_COUNT && ANIMATION_SPEEDS[speed] != timeline.getTimeScale()) speed++;
+
+            timeline.setTimeScale(ANIMATION_SPEEDS[(speed + 1) % ANIMATION_SPEED_COUNT]);
+        }
+
+        if (IsKeyPressed(KEY_SPACE)) timeline.skipToEnd();
+
+        loop.pollInput();
 
 		Board& board = game.getBoard();
 
         raylib::Vector2 mousePosition = GetMousePosition();
 
-        cameraMouseOffset = cameraMouseOffset.Lerp(raylib::Vector2(((mousePosition.x - HALF_SCREEN_WIDTH) / HALF_SCREEN_WIDTH) * mouseOffsetMultiplier, ((mousePosition.y - HALF_SCREEN_HEIGHT) / HALF_SCREEN_HEIGHT) * mouseOffsetMultiplier), 0.02f);
+        if (loop.getState() == GameLoopState::AI_TURN) {
+            // The AI searches on its own thread, its move comes in like any other event once it's found
+            optional<Move> aiMove = ai.update(game);
+
+            optional<Move> move = aiMove ? game.getLegalMove(aiMove->from, aiMove->to) : nullopt; // Get the move, with flags
+
+            if (move) {
+                cout << "Setting AI Move: " << move->getAlgebraicNotation(board) << endl;
+                loop.push({ GameLoopEventType::MOVE_CHOSEN, move });
+            } else if (aiMove) {
+				cout << "AI move is illegal! Attempting to make move: " << endl;
+            }
+        }
+
+        GameLoopEvent event;
 
-        camera.target = cameraMouseOffset;
+        while (loop.poll(event)) {
+            switch (event.type) {
+                case GameLoopEventType::INPUT: {
+                    if (replayViewer) {
+                        if (loop.getState() != GameLoopState::REVIEWING) break;
 
-        Player& currentPlayer = game.getCurrentPlayer();
+                        optional<Move> move = replayViewer->handleInput(game, loop);
 
-        if (game.isPlayable()) {
-            if (game.getPlayerTurn() == 1) {
+                        if (move) loop.push({ GameLoopEventType::MOVE_CHOSEN, move });
+                        break;
+                    }
 
-                // LEFT CLICK
-                if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-                    Cell targetCell = board.getCellAtScreenPosition(mousePosition, camera);
-                    Tile* targetTile = board.getTile(targetCell);
+                    if (loop.getState() != GameLoopState::PLAYER_TURN || !game.isPlayable()) break;
 
-                    // Check if tile exists
-                    if (targetTile) {
-                        Piece* targetPiece = targetTile->getPiece();
+                    // Z takes back the last move and the AI's reply, Y plays them again. Not while recording, a record only goes forwards
+                    if ((IsKeyPressed(KEY_Z) || IsKeyPressed(KEY_Y)) && !recordWriter.isOpen()) {
+                        bool undoing = IsKeyPressed(KEY_Z);
+                        bool changed = false;
 
-                        // Check if piece exists on tile and if it is the current player's
-                        if (targetPiece && targetPiece->isSelectable() && targetPiece->getPlayer() == game.getPlayerTurn() && !targetPiece->getLegalMoves(game.getBoard()).empty()) {
-                            selectedTile = targetTile;
-                            selectedPiece = targetPiece;
+                        do {
+                            changed |= undoing ? game.undo() : game.redo();
+                        } while (game.getPlayerTurn() != 1 && (undoing ? game.canUndo() : game.canRedo()));
 
-							Vector2 position = game.getBoard().getTilePosition(selectedTile);
+                        if (changed) {
+                            ai.stop(); // Whatever it was pondering on is gone
 
-                            interpolatedCursorIsoPositionFloat = { position.x, position.y, 0.0f };
+                            selectedTile = nullptr; // The tiles were replaced
+                            selectedPiece = nullptr;
 
-                            Sound fxPickup = LoadSound("resources/pickup.wav");
-                            PlaySound(fxPickup);
+                            loop.push({ GameLoopEventType::STATE_UPDATED }); // The turn changed without being played
                         }
+                        break;
                     }
-                }
 
-                /* This looks ugly at low resolution
-                if (selectedPiece) {
-					camera.zoom = Lerp(camera.zoom, 1.2f, 0.1f);
-                } else {
-                    camera.zoom = Lerp(camera.zoom, 1.0f, 0.1f);
-                }
-                */
+                    // LEFT CLICK
+                    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+                        Cell targetCell = board.getCellAtScreenPosition(mousePosition, camera);
+                        Tile* targetTile = board.getTile(targetCell);
 
-                // LEFT RELEASE
-                if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && (selectedTile)) {
-					// Get the cell at the mouse position
-                    Cell destinationCell = board.getCellAtScreenPosition(mousePosition, camera);
+                        // Check if tile exists
+                        if (targetTile) {
+                            Piece* targetPiece = targetTile->getPiece();
 
-					Cell selectedCell = Cell(game.getBoard().getCell(selectedTile)); // Cell the user selected the piece from
+                            // Check if piece exists on tile and if it is the current player's
+                            if (targetPiece && targetPiece->isSelectable() && targetPiece->getPlayer() == game.getPlayerTurn() && !targetPiece->getLegalMoves(game.getBoard()).empty()) {
+                                selectedTile = targetTile;
+                                selectedPiece = targetPiece;
 
-					raylib::Vector3 differencePosition = game.getBoard().getIsoPositionAtCell(destinationCell) - game.getBoard().getIsoPositionAtCell(selectedCell);
+								Vector2 position = game.getBoard().getTilePosition(selectedTile);
 
-                    if (board.isLegalMove(game.getPlayerTurn(), selectedCell, destinationCell)) {
-						Move move = board.getMove(selectedCell, destinationCell); // Get the move, with flags
-                                
-                        cout << "Setting Player Move: " << move.getAlgebraicNotation(board) << endl;
-                        currentPlayer.setMove(move);
-                    }
+                                interpolatedCursorIsoPositionFloat = { position.x, position.y, 0.0f };
 
-                    selectedTile = nullptr;
-                    selectedPiece = nullptr;
+                                game.getSoundBank().play(SOUND_PICKUP);
+                            }
+                        }
+                    }
 
-                    Sound fxPutdown = LoadSound("resources/putdown.wav");
+                    /* This looks ugly at low resolution
+                    if (selectedPiece) {
+						camera.zoom = Lerp(camera.zoom, 1.2f, 0.1f);
+                    } else {
+                        camera.zoom = Lerp(camera.zoom, 1.0f, 0.1f);
+                    }
+                    */
 
-                    PlaySound(fxPutdown);
-                }
+                    // LEFT RELEASE
+                    if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && (selectedTile)) {
+						// Get the cell at the mouse position
+                        Cell destinationCell = board.getCellAtScreenPosition(mousePosition, camera);
 
-            } else { // AI's turn
+						Cell selectedCell = Cell(game.getBoard().getCell(selectedTile)); // Cell the user selected the piece from
 
-                MoveGenerator generator = MoveGenerator(game);
+                        optional<Move> move = game.getLegalMove(selectedCell, destinationCell); // Get the move, with flags
 
-                Move aiMove = generator.chooseMove(4);
+                        if (move) {
+                            cout << "Setting Player Move: " << move->getAlgebraicNotation(board) << endl;
+                            loop.push({ GameLoopEventType::MOVE_CHOSEN, move });
+                        }
 
-                if (board.isLegalMove(game.getPlayerTurn(), aiMove.from, aiMove.to)) {
-                    Move move = board.getMove(aiMove.from, aiMove.to); // Get the move, with flags
-                    // NOTE: this might not be necessary now that i changed from cellmove to move, idk yet
+                        selectedTile = nullptr;
+                        selectedPiece = nullptr;
 
-                    cout << "Setting AI Move: " << move.getAlgebraicNotation(board) << endl;
-                    currentPlayer.setMove(move);
-                } else {
-					cout << "AI move is illegal! Attempting to make move: " << endl;
+                        game.getSoundBank().play(SOUND_PUTDOWN);
+                    }
+                    break;
                 }
+                case GameLoopEventType::MOVE_CHOSEN:
+                    game.getCurrentPlayer().setMove(event.move.value());
+                    break;
+                default:
+                    break;
             }
+
+            loop.transition(event, game);
         }
 
-        game.update(atlas);
+        // Idle frames only draw, nothing on the board can change until the player does something
+        if (!loop.isIdle()) {
+            game.updateMusicStreams();
+
+            cameraMouseOffset = cameraMouseOffset.Lerp(raylib::Vector2(((mousePosition.x - HALF_SCREEN_WIDTH) / HALF_SCREEN_WIDTH) * mouseOffsetMultiplier, ((mousePosition.y - HALF_SCREEN_HEIGHT) / HALF_SCREEN_HEIGHT) * mouseOffsetMultiplier), 0.02f);
+
+            camera.target = cameraMouseOffset;
+
+            if (replayViewer) replayViewer->promote(game); // Pawns promote like they did in the record
+
+            game.update();
+        }
 
         UpdateDrawFrame(camera, game);
 
-        exitWindow = game.getGameEnd();
+        exitWindow = !replayViewer && game.getGameEnd(); // A replay stays open at the end of the game
+
+        loop.pace();
+
+        profiler.endFrame();
     }
 
+    ai.stop();
+
+    GAME_LOG("AI ponder hits: " << ai.getPonderHits() << ", misses: " << ai.getPonderMisses() << endl);
+
+    recordWriter.endGame(game.getOutcome());
+    recordWriter.close();
+
+    assets.stop(); // Before the window and audio device go away
+
+    game.getBoard().releaseStaticLayer(); // The game outlives the window, but its render texture can't
+
     CloseWindow();
 
     return 0;
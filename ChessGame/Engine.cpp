@@ -0,0 +1,413 @@
+#include "Engine.h"
+#include <algorithm>
+
+#define SEARCH_INFINITY (ENGINE_MATE_SCORE + 1)
+
+/// <summary>
+/// Mate scores are stored relative to the position they were found in, so they stay right when reached from another ply
+/// </summary>
+static int scoreToTable(int score, int ply) {
+	if (isMateScore(score)) return score > 0 ? score + ply : score - ply;
+	return score;
+}
+
+static int scoreFromTable(int score, int ply) {
+	if (isMateScore(score)) return score > 0 ? score - ply : score + ply;
+	return score;
+}
+
+/************************************|
+			   WORKER
+|************************************/
+
+/// <summary>
+/// One search thread with its own copy of the position
+/// </summary>
+class Engine::Worker {
+	private:
+		Engine& engine;
+		int index;
+
+		MoveGenerator generator;
+
+		uint64_t localNodes = 0;
+		bool aborted = false;
+
+		Move rootMove;
+
+		/// <summary>
+		/// Puts the transposition table's move first, then captures of the most valuable pieces by the least valuable ones
+		/// </summary>
+		void orderMoves(vector<Move>& moves, uint16_t tableMove) {
+			vector<pair<int, Move>> scored;
+			scored.reserve(moves.size());
+
+			for (const Move& move : moves) {
+				int score = 0;
+
+				if (tableMove != 0 && encodeBookMove(move) == tableMove) score = INT_MAX;
+				else {
+					PieceType captured = generator.getPiece(move.to).type;
+
+					if (captured != PieceType::NO_PIECE) score = 10 * getPieceValue(captured) - getPieceValue(generator.getPiece(move.from).type);
+				}
+
+				scored.push_back({ score, move });
+			}
+
+			stable_sort(scored.begin(), scored.end(), [](const pair<int, Move>& a, const pair<int, Move>& b) { return a.first > b.first; });
+
+			for (size_t i = 0; i < moves.size(); i++) moves[i] = scored[i].second;
+		}
+
+		int search(int depth, int alpha, int beta, int ply) {
+			if ((++localNodes & 1023) == 0) {
+				nodes.store(localNodes, memory_order_relaxed);
+
+				if (engine.shouldStop()) engine.stop();
+			}
+
+			if (engine.stopping) {
+				aborted = true;
+				return 0;
+			}
+
+			if (depth <= 0) {
+				optional<int> tablebaseScore = generator.getTablebaseScore();
+				return tablebaseScore ? tablebaseScore.value() : generator.evaluateBoard();
+			}
+
+			uint64_t key = generator.getSearchKey();
+			uint16_t tableMove = 0;
+			TranspositionData entry;
+
+			if (engine.table.probe(key, entry)) {
+				tableMove = entry.move;
+
+				// The root always searches, so there is a move to play
+				if (ply > 0 && entry.depth >= depth) {
+					int score = scoreFromTable(entry.score, ply);
+
+					if (entry.bound == TranspositionBound::EXACT) return score;
+					if (entry.bound == TranspositionBound::LOWER && score >= beta) return score;
+					if (entry.bound == TranspositionBound::UPPER && score <= alpha) return score;
+				}
+			}
+
+			int player = generator.getCurrentPlayer();
+			vector<Move> moves = generator.getAllLegalMoves(player);
+
+			if (moves.empty()) return generator.isInCheck(player) ? -ENGINE_MATE_SCORE + ply : 0;
+
+			orderMoves(moves, tableMove);
+
+			int originalAlpha = alpha;
+			int bestScore = -SEARCH_INFINITY;
+			Move bestMove = moves[0];
+
+			for (const Move& move : moves) {
+				generator.makeMove(move);
+				int score = -search(depth - 1, -beta, -alpha, ply + 1);
+				generator.undoMove();
+
+				if (aborted) return 0;
+
+				if (score > bestScore) {
+					bestScore = score;
+					bestMove = move;
+				}
+
+				alpha = max(alpha, score);
+
+				if (alpha >= beta) break; // Beta cut-off
+			}
+
+			TranspositionBound bound = TranspositionBound::EXACT;
+			if (bestScore <= originalAlpha) bound = TranspositionBound::UPPER;
+			else if (bestScore >= beta) bound = TranspositionBound::LOWER;
+
+			engine.table.store(key, { scoreToTable(bestScore, ply), depth, bound, encodeBookMove(bestMove) });
+
+			if (ply == 0) rootMove = bestMove;
+
+			return bestScore;
+		}
+
+	public:
+		atomic<uint64_t> nodes = 0;
+
+		int completedDepth = 0;
+		int bestScore = 0;
+		optional<Move> bestMove;
+
+		Worker(Engine& engine, int index, const MoveGenerator& position) : engine(engine), index(index), generator(position) {}
+
+		/// <summary>
+		/// Searches one ply deeper at a time until the depth limit or until stopped
+		/// </summary>
+		void iterate() {
+			// Half of the helper threads start a ply deeper, so the threads aren't all searching the same thing
+			for (int depth = 1 + (index % 2); depth <= engine.limits.depth; depth++) {
+				int score = search(depth, -SEARCH_INFINITY, SEARCH_INFINITY, 0);
+
+				if (aborted) break;
+
+				completedDepth = depth;
+				bestScore = score;
+				bestMove = rootMove;
+
+				if (index != 0) continue;
+
+				nodes.store(localNodes, memory_order_relaxed);
+
+				if (engine.onInfo) {
+					SearchInfo info;
+					info.depth = depth;
+					info.score = score;
+					info.nodes = engine.getNodes();
+					info.time = (int)engine.getElapsed();
+					info.nps = info.nodes * 1000 / max(1, info.time);
+					info.hashfull = engine.table.getHashfull();
+					info.pv = engine.getPV(generator, depth);
+
+					engine.onInfo(info);
+				}
+
+				// Don't start a depth that won't finish in time, and stop once a mate is found
+				int64_t deadline = engine.deadline;
+				if (deadline > 0 && engine.getElapsed() * 2 > deadline) break;
+				if (isMateScore(score) && !engine.limits.infinite && !engine.pondering) break;
+			}
+
+			nodes.store(localNodes, memory_order_relaxed);
+		}
+};
+
+/************************************|
+			   ENGINE
+|************************************/
+
+Engine::Engine() {}
+
+Engine::~Engine() {
+	stop();
+	wait();
+}
+
+void Engine::setHashSize(int megabytes) {
+	stop();
+	wait();
+
+	table.resize(clamp(megabytes, 1, TRANSPOSITION_TABLE_MAX_SIZE));
+}
+
+void Engine::setThreads(int threads) {
+	stop();
+	wait();
+
+	threadCount = clamp(threads, 1, ENGINE_MAX_THREADS);
+}
+
+void Engine::clear() {
+	stop();
+	wait();
+
+	table.clear();
+}
+
+void Engine::setPosition(const MoveGenerator& generator) {
+	stop();
+	wait();
+
+	position = make_unique<MoveGenerator>(generator);
+}
+
+MoveGenerator& Engine::getPosition() { return *position; }
+
+void Engine::go(const SearchLimits& searchLimits) {
+	stop();
+	wait();
+
+	limits = searchLimits;
+	limits.depth = clamp(limits.depth, 1, ENGINE_MAX_DEPTH);
+
+	stopping = false;
+	pondering = limits.ponder;
+	searching = true;
+
+	startTime = chrono::steady_clock::now();
+	deadline = getTimeBudget();
+
+	searchThread = thread(&Engine::run, this);
+}
+
+void Engine::stop() {
+	{
+		lock_guard<mutex> lock(waitMutex);
+		stopping = true;
+	}
+
+	waitCondition.notify_all();
+}
+
+void Engine::ponderHit() {
+	{
+		lock_guard<mutex> lock(waitMutex);
+		pondering = false;
+
+		// Our own clock starts now
+		int64_t budget = getTimeBudget();
+		deadline = budget > 0 ? getElapsed() + budget : 0;
+	}
+
+	waitCondition.notify_all();
+}
+
+void Engine::wait() {
+	if (searchThread.joinable()) searchThread.join();
+}
+
+bool Engine::isSearching() { return searching; }
+
+int64_t Engine::getTimeBudget() {
+	int side = position->getCurrentPlayer() == 1 ? 0 : 1;
+	int64_t budget = 0;
+
+	if (pondering || limits.infinite) budget = 0;
+	else if (limits.moveTime > 0) budget = limits.moveTime;
+	else if (limits.time[side] > 0) {
+		int movesLeft = limits.movesToGo > 0 ? limits.movesToGo : 30;
+
+		budget = limits.time[side] / movesLeft + limits.increment[side] * 3 / 4;
+		budget = max<int64_t>(1, min<int64_t>(budget, limits.time[side] - 50)); // Leave some time to send the move
+	}
+
+	return budget;
+}
+
+int64_t Engine::getElapsed() const {
+	return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+}
+
+uint64_t Engine::getNodes() const {
+	uint64_t total = 0;
+
+	for (const unique_ptr<Worker>& worker : workers) total += worker->nodes.load(memory_order_relaxed);
+
+	return total;
+}
+
+bool Engine::shouldStop() {
+	if (limits.nodes > 0 && getNodes() >= limits.nodes) return true;
+
+	int64_t limit = deadline;
+
+	return limit > 0 && getElapsed() >= limit;
+}
+
+vector<Move> Engine::getPV(MoveGenerator& generator, int depth) {
+	vector<Move> pv;
+	TranspositionData entry;
+
+	// Follow the best moves through the table, checking each is legal since entries can be overwritten
+	while ((int)pv.size() < depth && table.probe(generator.getSearchKey(), entry) && entry.move != 0) {
+		vector<Move> legalMoves = generator.getAllLegalMoves(generator.getCurrentPlayer());
+
+		auto move = find_if(legalMoves.begin(), legalMoves.end(), [&](const Move& legalMove) { return encodeBookMove(legalMove) == entry.move; });
+
+		if (move == legalMoves.end()) break;
+
+		pv.push_back(*move);
+		generator.makeMove(*move);
+	}
+
+	for (size_t i = 0; i < pv.size(); i++) generator.undoMove();
+
+	return pv;
+}
+
+void Engine::run() {
+	table.newSearch();
+
+	workers.clear();
+
+	for (int i = 0; i < threadCount; i++) workers.push_back(make_unique<Worker>(*this, i, *position));
+
+	vector<thread> helpers;
+
+	for (int i = 1; i < threadCount; i++) helpers.emplace_back(&Worker::iterate, workers[i].get());
+
+	workers[0]->iterate();
+
+	// Infinite and ponder searches only finish when they're told to
+	{
+		unique_lock<mutex> lock(waitMutex);
+		waitCondition.wait(lock, [&]() { return stopping || (!limits.infinite && !pondering); });
+		stopping = true;
+	}
+
+	for (thread& helper : helpers) helper.join();
+
+	// Use the deepest search that finished, the main thread's if there's a tie
+	Worker* best = workers[0].get();
+
+	for (const unique_ptr<Worker>& worker : workers) {
+		if (worker->bestMove && (!best->bestMove || worker->completedDepth > best->completedDepth)) best = worker.get();
+	}
+
+	optional<Move> bestMove = best->bestMove;
+	optional<Move> ponderMove;
+
+	if (bestMove) {
+		MoveGenerator generator = *position;
+		vector<Move> pv = getPV(generator, 2);
+
+		if (pv.size() == 2 && encodeBookMove(pv[0]) == encodeBookMove(*bestMove)) ponderMove = pv[1];
+	}
+	else {
+		// Stopped before the first depth finished
+		vector<Move> legalMoves = position->getAllLegalMoves(position->getCurrentPlayer());
+
+		if (!legalMoves.empty()) bestMove = legalMoves[0];
+	}
+
+	searching = false;
+
+	if (onBestMove && bestMove) onBestMove(bestMove.value(), ponderMove);
+}
+
+/************************************|
+				UCI
+|************************************/
+
+string getUciMove(MoveGenerator& generator, const Move& move) {
+	string text = move.from.getAlgebraicNotation() + move.to.getAlgebraicNotation();
+
+	if (generator.getPiece(move.from).type == PieceType::PAWN && (move.to.rank == 0 || move.to.rank == 7)) text += "q";
+
+	return text;
+}
+
+optional<Move> parseUciMove(MoveGenerator& generator, const string& text) {
+	if (text.size() < 4) return nullopt;
+
+	Cell from(text[1] - '1', text[0] - 'a');
+	Cell to(text[3] - '1', text[2] - 'a');
+
+	if (!from.isInBounds() || !to.isInBounds()) return nullopt;
+
+	for (const Move& move : generator.getAllLegalMoves(generator.getCurrentPlayer())) {
+		if (move.from == from && move.to == to) return move;
+	}
+
+	return nullopt;
+}
+
+void makeUciMove(MoveGenerator& generator, const Move& move, PieceType promotion) {
+	PieceRepr piece = generator.getPiece(move.from);
+
+	generator.makeMove(move);
+
+	// makeMove already made a queen
+	if (piece.type == PieceType::PAWN && (move.to.rank == 0 || move.to.rank == 7) && promotion != PieceType::QUEEN) generator.setPiece(move.to, { promotion, piece.player, true });
+}
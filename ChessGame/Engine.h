@@ -0,0 +1,174 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "MoveGenerator.h"
+#include "TranspositionTable.h"
+
+using namespace std;
+
+#define ENGINE_MAX_DEPTH 64
+
+#define ENGINE_MAX_THREADS 64
+
+// Mate in n plies scores ENGINE_MATE_SCORE - n, above any evaluation or tablebase score
+#define ENGINE_MATE_SCORE 1000000
+
+struct SearchLimits {
+	int depth = ENGINE_MAX_DEPTH;
+	uint64_t nodes = 0;             // 0 for no limit
+	int moveTime = 0;               // Milliseconds to search for, 0 to work it out from the clock
+	int time[2] = { 0, 0 };         // Milliseconds left on each player's clock, 0 if there is no clock
+	int increment[2] = { 0, 0 };    // Milliseconds added to each player's clock after every move
+	int movesToGo = 0;              // Moves until the next time control, 0 if the rest of the game has to be played in the time
+	bool infinite = false;          // Search until stopped
+	bool ponder = false;            // Search the opponent's time until ponderHit or stop
+};
+
+struct SearchInfo {
+	int depth;
+	int score;       // For the side to move, in centipawns or a mate score
+	uint64_t nodes;
+	int time;        // Milliseconds since the search started
+	uint64_t nps;
+	int hashfull;    // Permille of the transposition table used
+	vector<Move> pv; // The moves the search expects to be played
+};
+
+/// <summary>
+/// Checks if a search score is a forced mate
+/// </summary>
+inline bool isMateScore(int score) { return abs(score) > ENGINE_MATE_SCORE - 1000; }
+
+/// <summary>
+/// Gets the number of moves to a mate score like UCI's "score mate", negative when the side to move gets mated
+/// </summary>
+inline int getMateMoves(int score) { return score > 0 ? (ENGINE_MATE_SCORE - score + 1) / 2 : -(ENGINE_MATE_SCORE + score) / 2; }
+
+/// <summary>
+/// Searches a position on its own threads with iterative deepening and a shared transposition table, so it can be stopped at any time
+/// </summary>
+class Engine {
+	private:
+		class Worker;
+
+		TranspositionTable table;
+		int threadCount = 1;
+
+		unique_ptr<MoveGenerator> position;
+
+		thread searchThread;
+		atomic<bool> searching = false;
+		atomic<bool> stopping = false;
+		atomic<bool> pondering = false;
+
+		SearchLimits limits;
+		chrono::steady_clock::time_point startTime;
+		atomic<int64_t> deadline = 0; // Milliseconds after the start the search has to stop at, 0 for none
+
+		mutex waitMutex;
+		condition_variable waitCondition; // Wakes a finished infinite or ponder search when it's stopped
+
+		vector<unique_ptr<Worker>> workers;
+
+		void run();
+
+		int64_t getTimeBudget();
+
+		int64_t getElapsed() const;
+
+		uint64_t getNodes() const;
+
+		bool shouldStop();
+
+		vector<Move> getPV(MoveGenerator& generator, int depth);
+
+	public:
+		/// <summary>
+		/// Called from the search thread after every depth that finished
+		/// </summary>
+		function<void(const SearchInfo&)> onInfo;
+
+		/// <summary>
+		/// Called from the search thread when the search is done, with the move it expects the opponent to reply with (for pondering)
+		/// </summary>
+		function<void(const Move&, optional<Move>)> onBestMove;
+
+		Engine();
+		~Engine();
+
+		Engine(const Engine&) = delete;
+		Engine& operator=(const Engine&) = delete;
+
+		/// <summary>
+		/// Sets the size of the transposition table in megabytes (1 to TRANSPOSITION_TABLE_MAX_SIZE), the table is cleared
+		/// </summary>
+		void setHashSize(int megabytes);
+
+		/// <summary>
+		/// Sets how many threads search at once, they share the transposition table
+		/// </summary>
+		void setThreads(int threads);
+
+		/// <summary>
+		/// Forgets everything from earlier searches, for a new game
+		/// </summary>
+		void clear();
+
+		/// <summary>
+		/// Sets the position to search, stopping any search that is running.
+		/// Turn off the position's evaluation noise when searching on more than one thread, so the threads agree on scores
+		/// </summary>
+		void setPosition(const MoveGenerator& generator);
+
+		MoveGenerator& getPosition();
+
+		/// <summary>
+		/// Starts searching the position on another thread, onBestMove is called when it's done
+		/// </summary>
+		void go(const SearchLimits& searchLimits);
+
+		/// <summary>
+		/// Stops the search, the best move found so far is sent to onBestMove
+		/// </summary>
+		void stop();
+
+		/// <summary>
+		/// The opponent played the move being pondered on, so the search continues on our own clock
+		/// </summary>
+		void ponderHit();
+
+		/// <summary>
+		/// Waits until the search is done
+		/// </summary>
+		void wait();
+
+		bool isSearching();
+};
+
+/// <summary>
+/// Gets a move in UCI notation (like "e2e4" or "e7e8q"), the move has to be legal in the generator's position
+/// </summary>
+string getUciMove(MoveGenerator& generator, const Move& move);
+
+/// <summary>
+/// Finds the legal move a UCI move stands for
+/// </summary>
+/// <returns>The move, or nullopt if it isn't legal</returns>
+optional<Move> parseUciMove(MoveGenerator& generator, const string& text);
+
+/// <summary>
+/// Plays a move, promoting the pawn to the given piece instead of a queen if it reaches the last rank
+/// </summary>
+/// <param name="promotion">The piece to promote to</param>
+void makeUciMove(MoveGenerator& generator, const Move& move, PieceType promotion = PieceType::QUEEN);
+
+#endif
@@ -0,0 +1,71 @@
+#include "GameLoop.h"
+
+GameLoop::GameLoop(Game& game) {
+	if (game.getGameEnd()) state = GameLoopState::GAME_OVER;
+	else if (!game.isPlayable()) state = GameLoopState::PLAYING_TURN;
+	else state = game.getPlayerTurn() == 1 ? GameLoopState::PLAYER_TURN : GameLoopState::AI_TURN;
+
+	lastEventTime = GetTime();
+}
+
+void GameLoop::push(const GameLoopEvent& event) {
+	events.push(event);
+
+	lastEventTime = GetTime();
+}
+
+bool GameLoop::poll(GameLoopEvent& event) {
+	if (events.empty()) return false;
+
+	event = events.front();
+	events.pop();
+
+	return true;
+}
+
+void GameLoop::pollInput() {
+	Vector2 mouseDelta = GetMouseDelta();
+
+	bool mouse = mouseDelta.x != 0.0f || mouseDelta.y != 0.0f || GetMouseWheelMove() != 0.0f ||
+		IsMouseButtonPressed(MOUSE_BUTTON_LEFT) || IsMouseButtonReleased(MOUSE_BUTTON_LEFT) || IsMouseButtonDown(MOUSE_BUTTON_LEFT);
+
+	if (mouse || GetKeyPressed() != 0 || IsWindowResized()) push({ GameLoopEventType::INPUT });
+}
+
+void GameLoop::transition(const GameLoopEvent& event, Game& game) {
+	switch (event.type) {
+		case GameLoopEventType::MOVE_CHOSEN:
+			state = GameLoopState::PLAYING_TURN;
+			break;
+		case GameLoopEventType::STATE_UPDATED:
+			if (reviewing) state = GameLoopState::REVIEWING;
+			else if (game.getGameEnd()) state = GameLoopState::GAME_OVER;
+			else state = game.getPlayerTurn() == 1 ? GameLoopState::PLAYER_TURN : GameLoopState::AI_TURN;
+			break;
+		default: // Input and animations don't change the turn
+			break;
+	}
+}
+
+void GameLoop::review() {
+	reviewing = true;
+
+	if (state != GameLoopState::PLAYING_TURN) state = GameLoopState::REVIEWING;
+}
+
+GameLoopState GameLoop::getState() { return state; }
+
+bool GameLoop::isIdle() {
+	if (state == GameLoopState::PLAYING_TURN || state == GameLoopState::AI_TURN) return false;
+
+	return events.empty() && GetTime() - lastEventTime > GAME_IDLE_DELAY;
+}
+
+void GameLoop::pace() {
+	int fps = isIdle() ? GAME_IDLE_FPS : GAME_FPS;
+
+	if (fps == targetFPS) return;
+
+	SetTargetFPS(fps);
+	targetFPS = fps;
+}
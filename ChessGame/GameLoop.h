@@ -0,0 +1,99 @@
+#ifndef GAMELOOP_H
+#define GAMELOOP_H
+
+#include <queue>
+#include <optional>
+#include "game.h"
+
+using namespace std;
+
+#define GAME_FPS 60
+#define GAME_IDLE_FPS 10       // Frame rate while nothing is happening, so an idle window barely uses the CPU
+#define GAME_IDLE_DELAY 2.0    // Seconds without events before the window counts as idle
+
+enum class GameLoopState {
+	PLAYER_TURN,  // Waiting for the player to pick a move
+	AI_TURN,      // Waiting for the AI's search
+	PLAYING_TURN, // The move, tile effects and promotions are animating
+	GAME_OVER,
+	REVIEWING     // Stepping through a replay, nobody picks moves
+};
+
+enum class GameLoopEventType {
+	INPUT,               // The mouse or keyboard did something
+	MOVE_CHOSEN,         // The player or the AI picked the move to play
+	ANIMATIONS_FINISHED, // A phase of the turn finished animating
+	STATE_UPDATED        // The turn ended, it's the next player's turn or the game is over
+};
+
+struct GameLoopEvent {
+	GameLoopEventType type;
+
+	optional<Move> move; // MOVE_CHOSEN only
+};
+
+/// <summary>
+/// Queues what happens in the game and moves between the states of a turn, so a frame only does the work its events need
+/// and the frame rate drops while nothing happens
+/// </summary>
+class GameLoop {
+	private:
+		queue<GameLoopEvent> events;
+
+		GameLoopState state;
+
+		double lastEventTime = 0.0;
+
+		int targetFPS = 0;
+
+		bool reviewing = false;
+
+	public:
+		/// <summary>
+		/// Starts in the state of the game's current turn
+		/// </summary>
+		GameLoop(Game& game);
+
+		/// <summary>
+		/// Adds an event to the end of the queue
+		/// </summary>
+		void push(const GameLoopEvent& event);
+
+		/// <summary>
+		/// Takes the next event off the queue
+		/// </summary>
+		/// <param name="event">Set to the event</param>
+		/// <returns>true if there was an event, false if the queue is empty</returns>
+		bool poll(GameLoopEvent& event);
+
+		/// <summary>
+		/// Queues an INPUT event if the mouse or keyboard did anything since the last frame
+		/// </summary>
+		void pollInput();
+
+		/// <summary>
+		/// Moves to the state an event leads to, call it after the event is handled
+		/// </summary>
+		/// <param name="event">The event that was handled</param>
+		/// <param name="game">The game being played</param>
+		void transition(const GameLoopEvent& event, Game& game);
+
+		/// <summary>
+		/// Turns end in REVIEWING instead of waiting for the players, used when viewing a replay
+		/// </summary>
+		void review();
+
+		GameLoopState getState();
+
+		/// <summary>
+		/// If the frame has no simulation work, waiting for a player who hasn't touched anything in a while, after the game ended or between the plies of a replay
+		/// </summary>
+		bool isIdle();
+
+		/// <summary>
+		/// Sets the target frame rate for the next frame, lower while idle
+		/// </summary>
+		void pace();
+};
+
+#endif
@@ -0,0 +1,459 @@
+#include "GameRecord.h"
+#include "Log.h"
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+static const char HEADER_MAGIC[4] = { 'C', 'G', 'R', 'C' };
+static const char FOOTER_MAGIC[4] = { 'C', 'G', 'R', 'I' };
+
+// Kinds of RECORD_SPAWN
+#define SPAWN_ICE 0
+#define SPAWN_BREAK 1
+#define SPAWN_CONVEYOR_ROW 2
+#define SPAWN_CONVEYOR_LOOP 3
+
+/************************************|
+			 ENTRIES
+|************************************/
+
+static uint16_t packCell(Cell cell) { return (uint16_t)(cell.rank * 8 + cell.file); }
+
+static Cell unpackCell(uint16_t bits) { return Cell(bits / 8, bits % 8); }
+
+static RecordEntry createEntry(RecordTag tag, uint16_t payload) {
+	RecordEntry entry;
+	entry.bits = (uint16_t)((tag << 13) | (payload & 0x1FFF));
+	return entry;
+}
+
+RecordEntry RecordEntry::move(const Move& move) {
+	return createEntry(RECORD_MOVE, (packCell(move.from) << 7) | (packCell(move.to) << 1));
+}
+
+RecordEntry RecordEntry::tileMove(const Move& move) {
+	bool portal = move.type == MoveType::PORTAL_MOVE;
+	return createEntry(RECORD_TILE_MOVE, (packCell(move.from) << 7) | (packCell(move.to) << 1) | (portal ? 1 : 0));
+}
+
+RecordEntry RecordEntry::promotion(Cell cell, PieceType type) {
+	return createEntry(RECORD_PROMOTION, (packCell(cell) << 7) | ((int)type << 4));
+}
+
+RecordEntry RecordEntry::spawn(const TileSpawn& spawn) {
+	switch (spawn.type) {
+		case TileSpawnType::PORTAL_SPAWN:
+			return createEntry(RECORD_PORTAL_SPAWN, (packCell(spawn.first) << 7) | (packCell(spawn.second) << 1));
+		case TileSpawnType::ICE_SPAWN:
+			return createEntry(RECORD_SPAWN, (SPAWN_ICE << 11) | (packCell(spawn.first) << 5));
+		case TileSpawnType::BREAK_SPAWN:
+			return createEntry(RECORD_SPAWN, (SPAWN_BREAK << 11) | (packCell(spawn.first) << 5));
+		case TileSpawnType::CONVEYOR_ROW_SPAWN:
+			return createEntry(RECORD_SPAWN, (SPAWN_CONVEYOR_ROW << 11) | (packCell(spawn.first) << 5));
+		case TileSpawnType::CONVEYOR_LOOP_SPAWN:
+			// Loops are 2 - 4 tiles wide and long, so the sizes fit in 2 bits each
+			return createEntry(RECORD_SPAWN, (SPAWN_CONVEYOR_LOOP << 11) | (packCell(spawn.first) << 5) | ((spawn.width - 2) << 3) | ((spawn.length - 2) << 1));
+	}
+
+	throw runtime_error("Unknown tile spawn!");
+}
+
+RecordEntry RecordEntry::end(GameOutcome outcome) { return createEntry(RECORD_END, (uint16_t)outcome); }
+
+Move RecordEntry::getMove() const {
+	Cell from = unpackCell((bits >> 7) & 63);
+	Cell to = unpackCell((bits >> 1) & 63);
+
+	if (getTag() == RECORD_TILE_MOVE) {
+		return Move(from, to, false, nullopt, (bits & 1) ? MoveType::PORTAL_MOVE : MoveType::CONVEYOR_MOVE);
+	}
+
+	return Move(from, to);
+}
+
+Cell RecordEntry::getPromotionCell() const { return unpackCell((bits >> 7) & 63); }
+
+PieceType RecordEntry::getPromotionType() const { return (PieceType)((bits >> 4) & 7); }
+
+TileSpawn RecordEntry::getSpawn() const {
+	TileSpawn spawn;
+
+	if (getTag() == RECORD_PORTAL_SPAWN) {
+		spawn.type = TileSpawnType::PORTAL_SPAWN;
+		spawn.first = unpackCell((bits >> 7) & 63);
+		spawn.second = unpackCell((bits >> 1) & 63);
+		return spawn;
+	}
+
+	spawn.first = unpackCell((bits >> 5) & 63);
+
+	switch ((bits >> 11) & 3) {
+		case SPAWN_ICE:           spawn.type = TileSpawnType::ICE_SPAWN; break;
+		case SPAWN_BREAK:         spawn.type = TileSpawnType::BREAK_SPAWN; break;
+		case SPAWN_CONVEYOR_ROW:  spawn.type = TileSpawnType::CONVEYOR_ROW_SPAWN; break;
+		case SPAWN_CONVEYOR_LOOP:
+			spawn.type = TileSpawnType::CONVEYOR_LOOP_SPAWN;
+			spawn.width = ((bits >> 3) & 3) + 2;
+			spawn.length = ((bits >> 1) & 3) + 2;
+			break;
+	}
+
+	return spawn;
+}
+
+GameOutcome RecordEntry::getOutcome() const { return (GameOutcome)(bits & 7); }
+
+string RecordEntry::toString() const {
+	switch (getTag()) {
+		case RECORD_MOVE: {
+			Move move = getMove();
+			return move.from.getAlgebraicNotation() + move.to.getAlgebraicNotation();
+		}
+
+		case RECORD_TILE_MOVE: {
+			Move move = getMove();
+			return "~" + move.from.getAlgebraicNotation() + move.to.getAlgebraicNotation();
+		}
+
+		case RECORD_PROMOTION:
+			return "=" + getPieceString(getPromotionType()) + "@" + getPromotionCell().getAlgebraicNotation();
+
+		case RECORD_SPAWN:
+		case RECORD_PORTAL_SPAWN: {
+			TileSpawn spawn = getSpawn();
+
+			switch (spawn.type) {
+				case TileSpawnType::ICE_SPAWN:
+					return "I@" + spawn.first.getAlgebraicNotation();
+				case TileSpawnType::BREAK_SPAWN:
+					return "B@" + spawn.first.getAlgebraicNotation();
+				case TileSpawnType::PORTAL_SPAWN:
+					return "P@" + spawn.first.getAlgebraicNotation() + "," + spawn.second.getAlgebraicNotation();
+				case TileSpawnType::CONVEYOR_ROW_SPAWN:
+					return "R@" + to_string(spawn.first.rank + 1);
+				case TileSpawnType::CONVEYOR_LOOP_SPAWN:
+					return "L@" + spawn.first.getAlgebraicNotation() + ":" + to_string(spawn.width) + "x" + to_string(spawn.length);
+			}
+			break;
+		}
+
+		case RECORD_END:
+			return getOutcomeString(getOutcome());
+	}
+
+	return "?";
+}
+
+string getOutcomeString(GameOutcome outcome) {
+	switch (outcome) {
+		case GameOutcome::PLAYER_1_WIN: return "1-0";
+		case GameOutcome::PLAYER_2_WIN: return "0-1";
+		case GameOutcome::STALEMATE:    return "1/2";
+		default:                        return "*";
+	}
+}
+
+void recordGame(Game& game, function<void(RecordEntry)> record) {
+	Board& board = game.getBoard();
+
+	game.onPlayerMove = [record](const Move& move) { record(RecordEntry::move(move)); };
+	board.onTileMove = [record](const Move& move) { record(RecordEntry::tileMove(move)); };
+	board.onPromotion = [record](Cell cell, PieceType type) { record(RecordEntry::promotion(cell, type)); };
+	board.onTileSpawn = [record](const TileSpawn& spawn) { record(RecordEntry::spawn(spawn)); };
+}
+
+/************************************|
+			  WRITER
+|************************************/
+
+GameRecordWriter::~GameRecordWriter() { close(); }
+
+bool GameRecordWriter::open(const string& path) {
+	close();
+
+	file = fopen(path.c_str(), "wb");
+
+	if (!file) return false;
+
+	setvbuf(file, nullptr, _IOFBF, 1 << 20); // Entries are tiny, so only hit the disk in large blocks
+
+	offset = 0;
+	totalPlies = 0;
+	index.clear();
+
+	return true;
+}
+
+bool GameRecordWriter::isOpen() { return file != nullptr; }
+
+void GameRecordWriter::writeBytes(const void* bytes, size_t count) {
+	// Not thrown since this also runs when closing from the destructor
+	if (fwrite(bytes, 1, count, file) != count) GAME_LOG("Failed to write to the game record!" << endl);
+
+	offset += count;
+}
+
+void GameRecordWriter::beginGame(uint64_t seed, uint16_t ruleset) {
+	if (!file) return;
+
+	if (inGame) endGame(GameOutcome::UNFINISHED);
+
+	GameRecordHeader header;
+	memcpy(header.magic, HEADER_MAGIC, 4);
+	header.version = GAME_RECORD_VERSION;
+	header.ruleset = ruleset;
+	header.seed = seed;
+
+	current = { offset, totalPlies, 0, 0 };
+
+	writeBytes(&header, sizeof(header));
+
+	inGame = true;
+}
+
+void GameRecordWriter::write(RecordEntry entry) {
+	if (!file || !inGame) return;
+
+	writeBytes(&entry.bits, sizeof(entry.bits));
+
+	current.entries++;
+
+	if (entry.getTag() == RECORD_MOVE) current.plies++;
+}
+
+void GameRecordWriter::endGame(GameOutcome outcome) {
+	if (!file || !inGame) return;
+
+	write(RecordEntry::end(outcome));
+
+	index.push_back(current);
+	totalPlies += current.plies;
+
+	inGame = false;
+}
+
+void GameRecordWriter::writeGame(uint64_t seed, const vector<RecordEntry>& entries, GameOutcome outcome) {
+	beginGame(seed);
+
+	for (RecordEntry entry : entries) write(entry);
+
+	endGame(outcome);
+}
+
+void GameRecordWriter::flush() {
+	if (file) fflush(file);
+}
+
+void GameRecordWriter::close() {
+	if (!file) return;
+
+	if (inGame) endGame(GameOutcome::UNFINISHED);
+
+	if (!index.empty()) writeBytes(index.data(), index.size() * sizeof(GameRecordIndex));
+
+	GameRecordFooter footer;
+	footer.games = index.size();
+	footer.plies = totalPlies;
+	memcpy(footer.magic, FOOTER_MAGIC, 4);
+	footer.version = GAME_RECORD_VERSION;
+
+	writeBytes(&footer, sizeof(footer));
+
+	fclose(file);
+	file = nullptr;
+}
+
+/************************************|
+			  READER
+|************************************/
+
+RecordEntry RecordedGame::getEntry(size_t i) const {
+	RecordEntry entry;
+	memcpy(&entry.bits, entries + i * 2, 2); // Entries are only 2 byte aligned relative to the header
+	return entry;
+}
+
+size_t RecordedGame::findPly(uint32_t ply) const {
+	if (ply >= plies) return entryCount;
+
+	uint32_t moves = 0;
+
+	for (size_t i = 0; i < entryCount; i++) {
+		if (getEntry(i).getTag() == RECORD_MOVE && moves++ == ply) return i;
+	}
+
+	return entryCount;
+}
+
+bool GameRecordReader::open(const string& path) {
+	close();
+
+	if (!file.open(path)) return false;
+
+	GameRecordHeader header;
+
+	if (file.getSize() < sizeof(header)) {
+		close();
+		return false;
+	}
+
+	memcpy(&header, file.getData(), sizeof(header));
+
+	if (memcmp(header.magic, HEADER_MAGIC, 4) != 0 || header.version > GAME_RECORD_VERSION) {
+		close();
+		return false;
+	}
+
+	if (!readFooter()) {
+		GAME_LOG("Game record " << path << " has no index, it was probably not closed. Scanning it instead..." << endl);
+		scan();
+	}
+
+	return true;
+}
+
+void GameRecordReader::close() {
+	file.close();
+	index.clear();
+	totalPlies = 0;
+}
+
+bool GameRecordReader::readFooter() {
+	size_t size = file.getSize();
+
+	GameRecordFooter footer;
+
+	if (size < sizeof(footer)) return false;
+
+	memcpy(&footer, file.getData() + size - sizeof(footer), sizeof(footer));
+
+	if (memcmp(footer.magic, FOOTER_MAGIC, 4) != 0 || footer.version > GAME_RECORD_VERSION) return false;
+
+	uint64_t indexSize = footer.games * sizeof(GameRecordIndex);
+
+	if (footer.games > size / sizeof(GameRecordIndex) || indexSize + sizeof(footer) > size) return false;
+
+	size_t indexOffset = size - sizeof(footer) - (size_t)indexSize;
+
+	index.resize((size_t)footer.games);
+	if (!index.empty()) memcpy(index.data(), file.getData() + indexOffset, (size_t)indexSize);
+
+	// Don't trust an index that points outside of the games
+	for (const GameRecordIndex& game : index) {
+		if (game.offset + sizeof(GameRecordHeader) + game.entries * 2ull > indexOffset) {
+			index.clear();
+			return false;
+		}
+	}
+
+	totalPlies = footer.plies;
+
+	return true;
+}
+
+void GameRecordReader::scan() {
+	const uint8_t* data = file.getData();
+	size_t size = file.getSize();
+	size_t offset = 0;
+
+	index.clear();
+	totalPlies = 0;
+
+	while (offset + sizeof(GameRecordHeader) <= size) {
+		GameRecordHeader header;
+		memcpy(&header, data + offset, sizeof(header));
+
+		if (memcmp(header.magic, HEADER_MAGIC, 4) != 0) break;
+
+		GameRecordIndex game = { offset, totalPlies, 0, 0 };
+
+		size_t position = offset + sizeof(header);
+
+		// A game cut off before its end entry keeps everything that was written
+		while (position + 2 <= size) {
+			RecordEntry entry;
+			memcpy(&entry.bits, data + position, 2);
+
+			position += 2;
+			game.entries++;
+
+			if (entry.getTag() == RECORD_MOVE) game.plies++;
+			if (entry.getTag() == RECORD_END) break;
+		}
+
+		index.push_back(game);
+		totalPlies += game.plies;
+
+		offset = position;
+	}
+}
+
+size_t GameRecordReader::getGameCount() { return index.size(); }
+
+uint64_t GameRecordReader::getPlyCount() { return totalPlies; }
+
+RecordedGame GameRecordReader::getGame(size_t game) {
+	if (game >= index.size()) throw runtime_error("Game record doesn't have that many games!");
+
+	const GameRecordIndex& entry = index[game];
+
+	GameRecordHeader header;
+	memcpy(&header, file.getData() + entry.offset, sizeof(header));
+
+	RecordedGame recordedGame;
+	recordedGame.seed = header.seed;
+	recordedGame.ruleset = header.ruleset;
+	recordedGame.firstPly = entry.firstPly;
+	recordedGame.plies = entry.plies;
+	recordedGame.entries = file.getData() + entry.offset + sizeof(header);
+	recordedGame.entryCount = entry.entries;
+
+	return recordedGame;
+}
+
+bool GameRecordReader::findPly(uint64_t ply, size_t& game, size_t& entry) {
+	if (ply >= totalPlies) return false;
+
+	// The last game that starts at or before the ply
+	auto it = upper_bound(index.begin(), index.end(), ply, [](uint64_t ply, const GameRecordIndex& game) {
+		return ply < game.firstPly;
+	});
+
+	game = (it - index.begin()) - 1;
+	entry = getGame(game).findPly((uint32_t)(ply - index[game].firstPly));
+
+	return true;
+}
+
+int printGameRecord(const string& path) {
+	GameRecordReader reader;
+
+	if (!reader.open(path)) {
+		cerr << "Unable to open game record: " << path << endl;
+		return 1;
+	}
+
+	cout << "# " << reader.getGameCount() << " games, " << reader.getPlyCount() << " plies" << endl;
+
+	for (size_t i = 0; i < reader.getGameCount(); i++) {
+		RecordedGame game = reader.getGame(i);
+
+		GameOutcome outcome = GameOutcome::UNFINISHED;
+
+		if (game.entryCount > 0 && game.getEntry(game.entryCount - 1).getTag() == RECORD_END) {
+			outcome = game.getEntry(game.entryCount - 1).getOutcome();
+		}
+
+		cout << i << " seed=" << game.seed << " " << getOutcomeString(outcome) << " " << game.plies << ":";
+
+		for (size_t j = 0; j < game.entryCount; j++) {
+			RecordEntry entry = game.getEntry(j);
+
+			if (entry.getTag() != RECORD_END) cout << " " << entry.toString();
+		}
+
+		cout << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,268 @@
+#ifndef GAMERECORD_H
+#define GAMERECORD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <functional>
+#include "game.h"
+#include "MemoryMappedFile.h"
+
+using namespace std;
+
+/*
+	Layout of a record file, all numbers are little endian:
+
+	For every game:
+		GameRecordHeader            16 bytes, seed and ruleset
+		RecordEntry...              2 bytes each, a ply is a RECORD_MOVE followed by everything it caused
+		RECORD_END entry            2 bytes, the outcome
+	After the last game (written when the file is closed):
+		GameRecordIndex...          24 bytes for every game
+		GameRecordFooter            24 bytes
+
+	Games are appended while they are played, so a file cut off by a crash is still readable up to where it stopped
+	by scanning it, the footer only makes opening large files instant.
+*/
+
+#define GAME_RECORD_VERSION 1
+
+// Rules a game was played with, so old records can still be replayed if the rules change
+#define GAME_RULESET_TILE_CHESS 1 // Standard chess with random tile spawns
+
+typedef enum {
+	RECORD_MOVE,         // A player's move
+	RECORD_TILE_MOVE,    // A piece moved by a conveyor or a portal
+	RECORD_PROMOTION,    // A pawn promoted to another piece
+	RECORD_SPAWN,        // Ice, breaking or conveyor tiles spawned
+	RECORD_PORTAL_SPAWN, // A pair of linked portals spawned
+	RECORD_END           // The end of a game
+} RecordTag;
+
+/// <summary>
+/// A single event of a game packed into 16 bits, the top 3 bits are its tag
+/// </summary>
+struct RecordEntry {
+	uint16_t bits = 0;
+
+	RecordTag getTag() const { return (RecordTag)(bits >> 13); }
+
+	static RecordEntry move(const Move& move);
+
+	static RecordEntry tileMove(const Move& move);
+
+	static RecordEntry promotion(Cell cell, PieceType type);
+
+	static RecordEntry spawn(const TileSpawn& spawn);
+
+	static RecordEntry end(GameOutcome outcome);
+
+	/// <summary>
+	/// Gets the move of a RECORD_MOVE or RECORD_TILE_MOVE, flags aren't stored since the board can work them out again
+	/// </summary>
+	Move getMove() const;
+
+	/// <summary>
+	/// Gets the cell of the pawn of a RECORD_PROMOTION
+	/// </summary>
+	Cell getPromotionCell() const;
+
+	/// <summary>
+	/// Gets the piece of a RECORD_PROMOTION
+	/// </summary>
+	PieceType getPromotionType() const;
+
+	/// <summary>
+	/// Gets the tiles of a RECORD_SPAWN or RECORD_PORTAL_SPAWN
+	/// </summary>
+	TileSpawn getSpawn() const;
+
+	/// <summary>
+	/// Gets the outcome of a RECORD_END
+	/// </summary>
+	GameOutcome getOutcome() const;
+
+	/// <summary>
+	/// Describes the entry for printing, e.g. "e2e4", "~e4e5", "=Q@e8", "I@e4", "P@a3,f6" or "1-0"
+	/// </summary>
+	string toString() const;
+};
+
+struct GameRecordHeader {
+	char magic[4];
+	uint16_t version;
+	uint16_t ruleset;
+	uint64_t seed;
+};
+
+struct GameRecordIndex {
+	uint64_t offset;   // Where the game's header starts in the file
+	uint64_t firstPly; // Number of plies played in all the games before this one
+	uint32_t plies;
+	uint32_t entries;  // Number of entries, including the RECORD_END
+};
+
+struct GameRecordFooter {
+	uint64_t games;
+	uint64_t plies;
+	char magic[4];
+	uint32_t version;
+};
+
+static_assert(sizeof(GameRecordHeader) == 16, "GameRecordHeader has to match the file layout");
+static_assert(sizeof(GameRecordIndex) == 24, "GameRecordIndex has to match the file layout");
+static_assert(sizeof(GameRecordFooter) == 24, "GameRecordFooter has to match the file layout");
+
+/// <summary>
+/// Gets the result of a game as it's written in chess notation, "1-0", "0-1", "1/2" or "*" if nobody won
+/// </summary>
+string getOutcomeString(GameOutcome outcome);
+
+/// <summary>
+/// Sends everything that happens in a game to a function as record entries, until the game is destroyed
+/// </summary>
+/// <param name="game">The game to record</param>
+/// <param name="record">Called with every entry as it happens</param>
+void recordGame(Game& game, function<void(RecordEntry)> record);
+
+/// <summary>
+/// Writes games to a record file as they are played
+/// </summary>
+class GameRecordWriter {
+	private:
+		FILE* file = nullptr;
+
+		uint64_t offset = 0;
+		uint64_t totalPlies = 0;
+
+		vector<GameRecordIndex> index;
+
+		/// <summary>
+		/// Index of the game being written
+		/// </summary>
+		GameRecordIndex current;
+
+		bool inGame = false;
+
+		void writeBytes(const void* bytes, size_t count);
+
+	public:
+		GameRecordWriter() = default;
+		~GameRecordWriter();
+
+		GameRecordWriter(const GameRecordWriter&) = delete;
+		GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+		/// <summary>
+		/// Creates a record file, replacing it if it exists
+		/// </summary>
+		/// <returns>true if the file was created, false if not</returns>
+		bool open(const string& path);
+
+		bool isOpen();
+
+		/// <summary>
+		/// Starts a new game, ending the current one as unfinished if it wasn't ended
+		/// </summary>
+		void beginGame(uint64_t seed, uint16_t ruleset = GAME_RULESET_TILE_CHESS);
+
+		/// <summary>
+		/// Adds an entry to the current game
+		/// </summary>
+		void write(RecordEntry entry);
+
+		/// <summary>
+		/// Ends the current game
+		/// </summary>
+		void endGame(GameOutcome outcome);
+
+		/// <summary>
+		/// Writes a whole game at once, for games recorded somewhere else (like on another thread)
+		/// </summary>
+		void writeGame(uint64_t seed, const vector<RecordEntry>& entries, GameOutcome outcome);
+
+		/// <summary>
+		/// Pushes everything written so far to the file, so it survives a crash
+		/// </summary>
+		void flush();
+
+		/// <summary>
+		/// Ends the current game, writes the index and closes the file
+		/// </summary>
+		void close();
+};
+
+/// <summary>
+/// A game inside a mapped record file, only valid while the reader that returned it is open
+/// </summary>
+struct RecordedGame {
+	uint64_t seed;
+	uint16_t ruleset;
+
+	uint64_t firstPly;
+	uint32_t plies;
+
+	const uint8_t* entries;
+	size_t entryCount;
+
+	RecordEntry getEntry(size_t i) const;
+
+	/// <summary>
+	/// Finds where a ply starts
+	/// </summary>
+	/// <param name="ply">The ply in this game, starting from 0</param>
+	/// <returns>The index of the ply's RECORD_MOVE, or entryCount if the game is shorter</returns>
+	size_t findPly(uint32_t ply) const;
+};
+
+/// <summary>
+/// Reads a record file in place through a memory map
+/// </summary>
+class GameRecordReader {
+	private:
+		MemoryMappedFile file;
+
+		vector<GameRecordIndex> index;
+
+		uint64_t totalPlies = 0;
+
+		bool readFooter();
+
+		/// <summary>
+		/// Builds the index by walking through every game, for files that were never closed
+		/// </summary>
+		void scan();
+
+	public:
+		/// <summary>
+		/// Opens a record file
+		/// </summary>
+		/// <returns>true if the file is a record file, false if not</returns>
+		bool open(const string& path);
+
+		void close();
+
+		size_t getGameCount();
+
+		uint64_t getPlyCount();
+
+		RecordedGame getGame(size_t game);
+
+		/// <summary>
+		/// Finds a ply counting from the start of the first game
+		/// </summary>
+		/// <param name="ply">The ply to find</param>
+		/// <param name="game">Set to the game the ply is in</param>
+		/// <param name="entry">Set to the index of the ply's RECORD_MOVE in that game</param>
+		/// <returns>true if the file has that many plies, false if not</returns>
+		bool findPly(uint64_t ply, size_t& game, size_t& entry);
+};
+
+/// <summary>
+/// Prints every game of a record file, used by the --print-record mode
+/// </summary>
+/// <returns>The exit code of the program</returns>
+int printGameRecord(const string& path);
+
+#endif
@@ -0,0 +1,197 @@
+#include "GameState.h"
+#include <algorithm>
+#include <cstring>
+
+GameState::GameState() {
+	fill(begin(lifetimes), end(lifetimes), (int8_t)-1);
+}
+
+PositionPiece GameState::getPiece(Cell cell) const {
+	uint8_t bits = pieces[cell.rank * 8 + cell.file];
+
+	PositionPiece piece;
+
+	piece.type = (PieceType)(bits & GAME_STATE_PIECE_TYPE);
+
+	if (piece.type == PieceType::NO_PIECE) return piece;
+
+	piece.player = bits & GAME_STATE_PIECE_PLAYER_2 ? 2 : 1;
+	piece.hasMoved = bits & GAME_STATE_PIECE_MOVED;
+	piece.frozen = frozen[cell.rank * 8 + cell.file];
+
+	return piece;
+}
+
+void GameState::setPiece(Cell cell, const PositionPiece& piece) {
+	int index = cell.rank * 8 + cell.file;
+
+	if (piece.type == PieceType::NO_PIECE) {
+		pieces[index] = 0;
+		frozen[index] = 0;
+		return;
+	}
+
+	pieces[index] = (uint8_t)piece.type | (piece.player == 2 ? GAME_STATE_PIECE_PLAYER_2 : 0) | (piece.hasMoved ? GAME_STATE_PIECE_MOVED : 0);
+	frozen[index] = (uint8_t)clamp(piece.frozen, 0, 255);
+}
+
+PositionTile GameState::getTile(Cell cell) const {
+	int index = cell.rank * 8 + cell.file;
+
+	PositionTile tile;
+
+	tile.kind = (TileKind)tiles[index];
+	tile.lifetime = lifetimes[index];
+
+	if (tile.kind == TileKind::CONVEYOR) tile.direction = (Direction)tileData[index];
+	if (tile.kind == TileKind::PORTAL) tile.portalNumber = tileData[index];
+
+	return tile;
+}
+
+void GameState::setTile(Cell cell, const PositionTile& tile) {
+	int index = cell.rank * 8 + cell.file;
+
+	tiles[index] = (uint8_t)tile.kind;
+	lifetimes[index] = tile.kind == TileKind::BASIC ? -1 : (int8_t)clamp(tile.lifetime, -1, 127);
+
+	if (tile.kind == TileKind::CONVEYOR) tileData[index] = (uint8_t)tile.direction;
+	else if (tile.kind == TileKind::PORTAL) tileData[index] = (uint8_t)tile.portalNumber;
+	else tileData[index] = 0;
+}
+
+optional<Cell> GameState::getEnPassantableCell() const {
+	if (enPassantableCell == GAME_STATE_NO_CELL) return nullopt;
+
+	return Cell(enPassantableCell / 8, enPassantableCell % 8);
+}
+
+void GameState::setEnPassantableCell(optional<Cell> cell) {
+	enPassantableCell = cell ? (uint8_t)(cell->rank * 8 + cell->file) : GAME_STATE_NO_CELL;
+}
+
+Random GameState::getRandom() const {
+	Random random;
+	random.setState(randomState, randomIncrement);
+
+	return random;
+}
+
+void GameState::setRandom(const Random& random) { random.getState(randomState, randomIncrement); }
+
+Position GameState::toPosition() const {
+	Position position;
+
+	for (int rank = 0; rank < 8; rank++) {
+		for (int file = 0; file < 8; file++) {
+			position.pieces[rank][file] = getPiece(Cell(rank, file));
+			position.tiles[rank][file] = getTile(Cell(rank, file));
+		}
+	}
+
+	// A player can castle to a side while their king and that rook haven't moved
+	for (int player = 1; player <= 2; player++) {
+		int homeRank = player == 1 ? 0 : 7;
+		int castleOffset = player == 1 ? 0 : 2;
+
+		PositionPiece& king = position.pieces[homeRank][4];
+
+		if (king.type != PieceType::KING || king.player != player || king.hasMoved) continue;
+
+		PositionPiece& kingRook = position.pieces[homeRank][7];
+		PositionPiece& queenRook = position.pieces[homeRank][0];
+
+		position.castling[castleOffset] = kingRook.type == PieceType::ROOK && kingRook.player == player && !kingRook.hasMoved;
+		position.castling[castleOffset + 1] = queenRook.type == PieceType::ROOK && queenRook.player == player && !queenRook.hasMoved;
+	}
+
+	position.enPassantableCell = getEnPassantableCell();
+	position.sideToMove = sideToMove;
+	position.halfmoveClock = halfmoveClock;
+	position.fullmoveNumber = fullmoveNumber;
+
+	return position;
+}
+
+GameState GameState::fromPosition(const Position& position) {
+	GameState state;
+
+	for (int rank = 0; rank < 8; rank++) {
+		for (int file = 0; file < 8; file++) {
+			const PositionTile& tile = position.tiles[rank][file];
+
+			state.setPiece(Cell(rank, file), position.pieces[rank][file]);
+			state.setTile(Cell(rank, file), tile);
+
+			if (tile.kind == TileKind::PORTAL) state.portalCounter = max<int>(state.portalCounter, tile.portalNumber + 1);
+		}
+	}
+
+	state.setEnPassantableCell(position.enPassantableCell);
+	state.sideToMove = (uint8_t)position.sideToMove;
+	state.halfmoveClock = (uint16_t)position.halfmoveClock;
+	state.fullmoveNumber = (uint16_t)position.fullmoveNumber;
+
+	return state;
+}
+
+bool GameState::operator==(const GameState& other) const { return memcmp(this, &other, sizeof(GameState)) == 0; }
+
+/************************************|
+			   DIFFS
+|************************************/
+
+bool GameStateCell::operator==(const GameStateCell& other) const {
+	return piece == other.piece && frozen == other.frozen && tile == other.tile && tileData == other.tileData && lifetime == other.lifetime;
+}
+
+GameStateCell getStateCell(const GameState& state, int index) {
+	return { state.pieces[index], state.frozen[index], state.tiles[index], state.tileData[index], state.lifetimes[index] };
+}
+
+void setStateCell(GameState& state, int index, const GameStateCell& cell) {
+	state.pieces[index] = cell.piece;
+	state.frozen[index] = cell.frozen;
+	state.tiles[index] = cell.tile;
+	state.tileData[index] = cell.tileData;
+	state.lifetimes[index] = cell.lifetime;
+}
+
+GameStateDiff GameStateDiff::between(const GameState& before, const GameState& after) {
+	GameStateDiff diff;
+
+	for (int index = 0; index < 64; index++) {
+		GameStateCell beforeCell = getStateCell(before, index);
+		GameStateCell afterCell = getStateCell(after, index);
+
+		if (beforeCell != afterCell) diff.cells.push_back({ (uint8_t)index, beforeCell, afterCell });
+	}
+
+	memcpy(diff.scalarsBefore, (const uint8_t*)&before + GAME_STATE_SCALARS_OFFSET, GAME_STATE_SCALARS_SIZE);
+	memcpy(diff.scalarsAfter, (const uint8_t*)&after + GAME_STATE_SCALARS_OFFSET, GAME_STATE_SCALARS_SIZE);
+
+	return diff;
+}
+
+void GameStateDiff::undo(GameState& state) const {
+	for (const CellChange& change : cells) setStateCell(state, change.cell, change.before);
+
+	memcpy((uint8_t*)&state + GAME_STATE_SCALARS_OFFSET, scalarsBefore, GAME_STATE_SCALARS_SIZE);
+}
+
+void GameStateDiff::redo(GameState& state) const {
+	for (const CellChange& change : cells) setStateCell(state, change.cell, change.after);
+
+	memcpy((uint8_t*)&state + GAME_STATE_SCALARS_OFFSET, scalarsAfter, GAME_STATE_SCALARS_SIZE);
+}
+
+vector<Cell> GameStateDiff::getCells() const {
+	vector<Cell> changed;
+	changed.reserve(cells.size());
+
+	for (const CellChange& change : cells) changed.push_back(Cell(change.cell / 8, change.cell % 8));
+
+	return changed;
+}
+
+size_t GameStateDiff::getSize() const { return sizeof(GameStateDiff) + cells.capacity() * sizeof(CellChange); }
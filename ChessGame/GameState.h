@@ -0,0 +1,147 @@
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <optional>
+#include <type_traits>
+#include "Position.h"
+#include "Random.h"
+
+using namespace std;
+
+#define GAME_STATE_NO_CELL 0xFF
+
+// Bits of GameState::pieces
+#define GAME_STATE_PIECE_TYPE 0x07 // PieceType, NO_PIECE for an empty cell
+#define GAME_STATE_PIECE_PLAYER_2 0x08
+#define GAME_STATE_PIECE_MOVED 0x10
+
+/// <summary>
+/// Everything about a game that the rules play out from, in flat arrays so it can be copied, compared and sent as plain bytes.
+/// Unlike Position it also has the board's random numbers and portal counter, so tiles spawn the same from a copy.
+/// Cells are indexed rank * 8 + file
+/// </summary>
+struct GameState {
+	uint8_t pieces[64] = {};    // GAME_STATE_PIECE_ bits
+	uint8_t frozen[64] = {};    // Turns the piece stays frozen for
+	uint8_t tiles[64] = {};     // TileKind
+	uint8_t tileData[64] = {};  // Direction of a conveyor, number of a portal
+	int8_t lifetimes[64] = {};  // Turns a special tile lasts for, -1 for basic tiles
+
+	uint8_t enPassantableCell = GAME_STATE_NO_CELL;
+	uint8_t sideToMove = 1;
+
+	uint16_t halfmoveClock = 0;
+	uint16_t fullmoveNumber = 1;
+	uint16_t portalCounter = 0;
+
+	uint64_t randomState = 0;
+	uint64_t randomIncrement = 1;
+
+	GameState();
+
+	PositionPiece getPiece(Cell cell) const;
+
+	void setPiece(Cell cell, const PositionPiece& piece);
+
+	PositionTile getTile(Cell cell) const;
+
+	void setTile(Cell cell, const PositionTile& tile);
+
+	optional<Cell> getEnPassantableCell() const;
+
+	void setEnPassantableCell(optional<Cell> cell);
+
+	Random getRandom() const;
+
+	void setRandom(const Random& random);
+
+	/// <summary>
+	/// Gets the ply of the state, 0 being white's first move
+	/// </summary>
+	int getPly() const { return (fullmoveNumber - 1) * 2 + (sideToMove == 2 ? 1 : 0); }
+
+	/// <summary>
+	/// Converts to a position, working out the castling rights from the pieces that moved
+	/// </summary>
+	Position toPosition() const;
+
+	/// <summary>
+	/// Converts from a position, the portal counter is set past the highest portal and the random numbers are left at their default
+	/// </summary>
+	static GameState fromPosition(const Position& position);
+
+	bool operator==(const GameState& other) const;
+
+	bool operator!=(const GameState& other) const { return !(*this == other); }
+};
+
+static_assert(is_trivially_copyable<GameState>::value, "GameState has to be copyable as plain bytes");
+static_assert(sizeof(GameState) == 344, "GameState has padding, which would break comparing it as bytes");
+
+// Everything after the cell arrays, the side to move, clocks and random numbers are stored whole in every diff
+#define GAME_STATE_SCALARS_OFFSET offsetof(GameState, enPassantableCell)
+#define GAME_STATE_SCALARS_SIZE (sizeof(GameState) - GAME_STATE_SCALARS_OFFSET)
+
+/// <summary>
+/// A cell's piece, frozen counter, tile, tile data and lifetime
+/// </summary>
+struct GameStateCell {
+	uint8_t piece;
+	uint8_t frozen;
+	uint8_t tile;
+	uint8_t tileData;
+	int8_t lifetime;
+
+	bool operator==(const GameStateCell& other) const;
+	bool operator!=(const GameStateCell& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// The difference between two states, only the cells that changed and the scalars, so it can be played backwards and forwards
+/// </summary>
+struct GameStateDiff {
+	struct CellChange {
+		uint8_t cell;
+		GameStateCell before;
+		GameStateCell after;
+	};
+
+	vector<CellChange> cells;
+
+	uint8_t scalarsBefore[GAME_STATE_SCALARS_SIZE];
+	uint8_t scalarsAfter[GAME_STATE_SCALARS_SIZE];
+
+	/// <summary>
+	/// Gets what changed from one state to another
+	/// </summary>
+	static GameStateDiff between(const GameState& before, const GameState& after);
+
+	/// <summary>
+	/// Turns the state after the diff back into the state before it
+	/// </summary>
+	void undo(GameState& state) const;
+
+	/// <summary>
+	/// Turns the state before the diff into the state after it
+	/// </summary>
+	void redo(GameState& state) const;
+
+	/// <summary>
+	/// Gets the cells the diff changes
+	/// </summary>
+	vector<Cell> getCells() const;
+
+	/// <summary>
+	/// Gets the memory the diff takes up, in bytes
+	/// </summary>
+	size_t getSize() const;
+};
+
+GameStateCell getStateCell(const GameState& state, int index);
+
+void setStateCell(GameState& state, int index, const GameStateCell& cell);
+
+#endif
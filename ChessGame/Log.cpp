@@ -0,0 +1,14 @@
+#include "Log.h"
+#include <atomic>
+#include "Profiler.h"
+
+static atomic<bool> gameLogEnabled{ true }; // Read by every search thread
+
+bool isGameLogEnabled() { return gameLogEnabled.load(memory_order_relaxed); }
+
+void setGameLogEnabled(bool enabled) { gameLogEnabled.store(enabled, memory_order_relaxed); }
+
+void silenceGameLog() {
+	setGameLogEnabled(false);
+	Profiler::get().setEnabled(false);
+}
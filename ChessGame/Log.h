@@ -0,0 +1,26 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <iostream>
+
+using namespace std;
+
+/// <summary>
+/// Writes a message to cout if the game log is enabled, like GAME_LOG("Castled!" << endl)
+/// </summary>
+#define GAME_LOG(message) do { if (isGameLogEnabled()) cout << message; } while (0)
+
+/// <summary>
+/// If the board, search and asset loaders log what they're doing, on by default
+/// </summary>
+bool isGameLogEnabled();
+
+void setGameLogEnabled(bool enabled);
+
+/// <summary>
+/// Turns off the game log and the profiler, for modes that play games without a window.
+/// Their own output still goes to cout and cerr as usual
+/// </summary>
+void silenceGameLog();
+
+#endif
@@ -0,0 +1,111 @@
+#include "MemoryMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MemoryMappedFile::~MemoryMappedFile() { close(); }
+
+#ifdef _WIN32
+
+bool MemoryMappedFile::open(const string& path) {
+	close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = (const uint8_t*)view;
+	size = (size_t)fileSize.QuadPart;
+
+	return true;
+}
+
+void MemoryMappedFile::close() {
+	if (data) UnmapViewOfFile(data);
+	if (mappingHandle) CloseHandle(mappingHandle);
+	if (fileHandle) CloseHandle(fileHandle);
+
+	data = nullptr;
+	size = 0;
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+}
+
+#else
+
+bool MemoryMappedFile::open(const string& path) {
+	close();
+
+	int file = ::open(path.c_str(), O_RDONLY);
+
+	if (file < 0) return false;
+
+	struct stat status;
+
+	if (fstat(file, &status) != 0 || status.st_size == 0) {
+		::close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	if (view == MAP_FAILED) {
+		::close(file);
+		return false;
+	}
+
+	descriptor = file;
+	data = (const uint8_t*)view;
+	size = (size_t)status.st_size;
+
+	return true;
+}
+
+void MemoryMappedFile::close() {
+	if (data) munmap((void*)data, size);
+	if (descriptor >= 0) ::close(descriptor);
+
+	data = nullptr;
+	size = 0;
+	descriptor = -1;
+}
+
+#endif
+
+bool MemoryMappedFile::isOpen() const { return data != nullptr; }
+
+const uint8_t* MemoryMappedFile::getData() const { return data; }
+
+size_t MemoryMappedFile::getSize() const { return size; }
@@ -0,0 +1,52 @@
+#ifndef MEMORYMAPPEDFILE_H
+#define MEMORYMAPPEDFILE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+/// <summary>
+/// Read-only view of a whole file mapped into memory, pages are only loaded by the OS when they are touched
+/// </summary>
+class MemoryMappedFile {
+	private:
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+
+		// Handles are kept as plain types so windows.h doesn't leak into everything (it clashes with raylib)
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		int descriptor = -1;
+#endif
+
+	public:
+		MemoryMappedFile() = default;
+		~MemoryMappedFile();
+
+		MemoryMappedFile(const MemoryMappedFile&) = delete;
+		MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+		/// <summary>
+		/// Maps a file, closing any file that was mapped before
+		/// </summary>
+		/// <param name="path">The file to map</param>
+		/// <returns>true if the file was mapped, false if it couldn't be opened or is empty</returns>
+		bool open(const string& path);
+
+		/// <summary>
+		/// Unmaps the file, any pointers into it become invalid
+		/// </summary>
+		void close();
+
+		bool isOpen() const;
+
+		const uint8_t* getData() const;
+
+		size_t getSize() const;
+};
+
+#endif
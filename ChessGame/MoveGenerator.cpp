@@ -1,4 +1,7 @@
 #include "MoveGenerator.h"
+#include "Profiler.h"
+#include "Log.h"
+#include "Zobrist.h"
 
 MoveGenerator::MoveGenerator(Game& game) {
 	Personality personality = Personality{ 50, 50, 50, 50 };
@@ -35,97 +38,117 @@ MoveGenerator::MoveGenerator(Game& game) {
 
 	currentPlayer = game.getPlayerTurn();
 
+	random.seed(game.getSearchRandom().next(), RANDOM_STREAM_SEARCH);
+
+	updatePieceKey();
+
 	printBoard();
 }
 
-MoveGenerator::MoveGenerator(string fen) {
-	// I might use this for unit testing with stockfish later
-	cout << "Constructing board representation from FEN: " << fen << endl;
+MoveGenerator::MoveGenerator(string fen) : MoveGenerator(parseFEN(fen)) {}
 
-	int rank = 7;
-	int file = 0;
+MoveGenerator::MoveGenerator(const Position& position) {
+	// I might use this for unit testing with stockfish later
+	for (int rank = 0; rank < 8; rank++) {
+		for (int file = 0; file < 8; file++) {
+			const PositionPiece& piece = position.pieces[rank][file];
 
-	for (char c : fen) {
-		if (isdigit(c)) { // Number = skip that many files
-			int spaces = c - '0';
-			while (spaces > 0) {
-				board[rank][file] = { PieceType::NO_PIECE, -1, false };
-				file++;
-				spaces--;
-			}
-		}
-		else if (c == '/') { // Slash = next rank
-			rank--;
-			file = 0;
+			board[rank][file] = { piece.type, (int8_t)piece.player, piece.hasMoved };
 		}
-		else {
-			PieceType type = PieceType::NO_PIECE;
-			int8_t player = -1;
-			switch (c) {
-			case 'p': type = PieceType::PAWN;   player = 2; break;
-			case 'r': type = PieceType::ROOK;   player = 2; break;
-			case 'n': type = PieceType::KNIGHT; player = 2; break;
-			case 'b': type = PieceType::BISHOP; player = 2; break;
-			case 'q': type = PieceType::QUEEN;  player = 2; break;
-			case 'k': type = PieceType::KING;   player = 2; break;
-			case 'P': type = PieceType::PAWN;   player = 1; break;
-			case 'R': type = PieceType::ROOK;   player = 1; break;
-			case 'N': type = PieceType::KNIGHT; player = 1; break;
-			case 'B': type = PieceType::BISHOP; player = 1; break;
-			case 'Q': type = PieceType::QUEEN;  player = 1; break;
-			case 'K': type = PieceType::KING;   player = 1; break;
-			}
-			board[rank][file] = { type, player, false };
-			file++;
+	}
+
+	enPassantableCell = position.enPassantableCell;
+	currentPlayer = position.sideToMove;
+	halfmoveClock = position.halfmoveClock;
+	fullmoveNumber = position.fullmoveNumber;
+
+	updatePieceKey();
+
+	printBoard();
+}
+
+void MoveGenerator::updatePieceKey() {
+	pieceKey = 0;
+
+	for (int rank = 0; rank < 8; rank++) {
+		for (int file = 0; file < 8; file++) {
+			const PieceRepr& piece = board[rank][file];
+
+			if (piece.type != PieceType::NO_PIECE) pieceKey ^= getZobristPieceKey(piece.type, piece.player, Cell(rank, file));
 		}
 	}
+}
+
+Position MoveGenerator::getPosition() {
+	Position position;
 
-	// Set moved for any piece out of place
 	for (int rank = 0; rank < 8; rank++) {
 		for (int file = 0; file < 8; file++) {
-			switch (board[rank][file].type) {
-			case PieceType::PAWN: {
-				if ((board[rank][file].player == 1 && rank != 1) || (board[rank][file].player == 2 && rank != 6))
-					board[rank][file].hasMoved = true;
-				break;
-			}
-			case PieceType::ROOK: {
-				if ((board[rank][file].player == 1 && (rank != 0 && file != 0) && (rank != 0 && file != 7)) ||
-					(board[rank][file].player == 2 && (rank != 7 && file != 0) && (rank != 7 && file != 7)))
-					board[rank][file].hasMoved = true;
-				break;
-			}
-			case PieceType::KNIGHT: {
-				if ((board[rank][file].player == 1 && (rank != 0 && file != 1) && (rank != 0 && file != 6)) ||
-					(board[rank][file].player == 2 && (rank != 7 && file != 1) && (rank != 7 && file != 6)))
-					board[rank][file].hasMoved = false;
-				break;
-			}
-			case PieceType::BISHOP: {
-				if ((board[rank][file].player == 1 && (rank != 0 && file != 2) && (rank != 0 && file != 5)) ||
-					(board[rank][file].player == 2 && (rank != 7 && file != 2) && (rank != 7 && file != 5)))
-					board[rank][file].hasMoved = false;
-				break;
-			}
-			case PieceType::QUEEN: {
-				if ((board[rank][file].player == 1 && rank != 0 && file != 3) ||
-					(board[rank][file].player == 2 && rank != 7 && file != 3))
-					board[rank][file].hasMoved = false;
-				break;
-			}
-			case PieceType::KING: {
-				if ((board[rank][file].player == 1 && rank != 0 && file != 4) ||
-					(board[rank][file].player == 2 && rank != 7 && file != 4))
-					board[rank][file].hasMoved = false;
-				break;
-			}
-			}
+			PieceRepr& piece = board[rank][file];
+
+			position.pieces[rank][file].type = piece.type;
+			position.pieces[rank][file].player = piece.player;
+			position.pieces[rank][file].hasMoved = piece.hasMoved;
 		}
 	}
 
-	printBoard();
+	// A side can castle to a side while its king and that rook haven't moved
+	for (int player = 1; player <= 2; player++) {
+		int homeRank = player == 1 ? 0 : 7;
+		int castleOffset = player == 1 ? 0 : 2;
+
+		PieceRepr& king = board[homeRank][4];
+
+		if (king.type != PieceType::KING || king.player != player || king.hasMoved) continue;
+
+		PieceRepr& kingRook = board[homeRank][7];
+		PieceRepr& queenRook = board[homeRank][0];
+
+		position.castling[castleOffset] = kingRook.type == PieceType::ROOK && kingRook.player == player && !kingRook.hasMoved;
+		position.castling[castleOffset + 1] = queenRook.type == PieceType::ROOK && queenRook.player == player && !queenRook.hasMoved;
+	}
+
+	position.sideToMove = currentPlayer;
+	position.enPassantableCell = enPassantableCell;
+	position.halfmoveClock = halfmoveClock;
+	position.fullmoveNumber = fullmoveNumber;
+
+	return position;
+}
+
+string MoveGenerator::getFEN() { return writeFEN(getPosition(), false); }
+
+uint64_t MoveGenerator::getZobristKey() { return ::getZobristKey(getPosition()); }
+
+int MoveGenerator::getCurrentPlayer() { return currentPlayer; }
+
+uint64_t MoveGenerator::getSearchKey() {
+	uint64_t key = pieceKey;
+
+	if (currentPlayer == 2) key ^= getZobristSideKey();
+	if (enPassantableCell) key ^= getZobristEnPassantKey(enPassantableCell->file);
+
+	// Same castling rights as getPosition, without building the whole position
+	for (int player = 1; player <= 2; player++) {
+		int homeRank = player == 1 ? 0 : 7;
+		int castleOffset = player == 1 ? 0 : 2;
+
+		const PieceRepr& king = board[homeRank][4];
+
+		if (king.type != PieceType::KING || king.player != player || king.hasMoved) continue;
+
+		const PieceRepr& kingRook = board[homeRank][7];
+		const PieceRepr& queenRook = board[homeRank][0];
+
+		if (kingRook.type == PieceType::ROOK && kingRook.player == player && !kingRook.hasMoved) key ^= getZobristCastlingKey(castleOffset);
+		if (queenRook.type == PieceType::ROOK && queenRook.player == player && !queenRook.hasMoved) key ^= getZobristCastlingKey(castleOffset + 1);
+	}
+
+	return key;
 }
 
+void MoveGenerator::setEvaluationNoise(int noise) { evaluationNoise = noise; }
+
 int MoveGenerator::evaluateBoard() {
 	int evaluation = 0;
 
@@ -147,19 +170,19 @@ int MoveGenerator::evaluateBoard() {
 		}
 	}
 
-	return evaluation + rand() % 50;
+	return evaluationNoise > 0 ? evaluation + random.nextInt(evaluationNoise) : evaluation;
 }
 
 void MoveGenerator::printBoard() {
-	cout << endl << "BOARD REPRESENTATION: " << endl;
+	GAME_LOG(endl << "BOARD REPRESENTATION: " << endl);
 
 	for (int rank = 7; rank >= 0; rank--) {
 		for (int file = 0; file < 8; file++) {
-			cout << " " << getPieceString(board[rank][file].type, board[rank][file].player);
+			GAME_LOG(" " << getPieceString(board[rank][file].type, board[rank][file].player));
 		}
-		cout << endl;
+		GAME_LOG(endl);
 	}
-	cout << endl;
+	GAME_LOG(endl);
 }
 
 bool MoveGenerator::isInsideBoard(int rank, int file) const { return rank >= 0 && rank <= 7 && file >= 0 && file <= 7; }
@@ -382,16 +405,16 @@ vector<Move> MoveGenerator::getAllLegalMoves(int player) {
 		opponentAttackingCells.push_back(attackingMove.to);
 	}
 
-	bool hasPinnedCells = cellData.hasPinnedCells();
-	bool hasCheckBlockCells = cellData.hasCheckBlockCells();
-
-	if (!hasPinnedCells && !hasCheckBlockCells) return pseudoLegalMoves;
+	auto isAttacked = [&](const Cell& cell) { return find(opponentAttackingCells.begin(), opponentAttackingCells.end(), cell) != opponentAttackingCells.end(); };
 
 	for (Move& move : pseudoLegalMoves) {
 		Cell from = move.from;
 		Cell to = move.to;
 		bool isKingMove = (from == kingCell); // This move is the king moving
 
+		// Can't castle out of check or through an attacked cell
+		if (move.flag == MoveFlag::CASTLE && (checkingPieces > 0 || isAttacked(Cell(from.rank, (from.file + to.file) / 2)))) continue;
+
 		if (checkingPieces > 1) { // Double check forces king to move to an unattacked cell
 
 			if (!isKingMove) continue; // Only allow king moves
@@ -425,6 +448,8 @@ vector<Move> MoveGenerator::getAllLegalMoves(int player) {
 		}
 		else {
 
+			if (isKingMove && isAttacked(to)) continue; // The king can't move into check
+
 			if (find(cellData.pinnedCells.begin(), cellData.pinnedCells.end(), from) != cellData.pinnedCells.end()) { // Piece we're trying to move is pinned
 				if (find(cellData.pinnedCells.begin(), cellData.pinnedCells.end(), to) == cellData.pinnedCells.end()) {
 					continue; // Skip this move, it puts the king in check
@@ -438,6 +463,16 @@ vector<Move> MoveGenerator::getAllLegalMoves(int player) {
 	return legalMoves;
 }
 
+bool MoveGenerator::isInCheck(int player) {
+	Cell kingCell = findKing(player);
+
+	for (const Move& move : getAllMoves((player % 2) + 1, true)) {
+		if (move.to == kingCell) return true;
+	}
+
+	return false;
+}
+
 PinAndCheckBlockCell MoveGenerator::getPinnedAndCheckBlockingCells(int player) {
 	PinAndCheckBlockCell result;
 
@@ -454,8 +489,11 @@ PinAndCheckBlockCell MoveGenerator::getPinnedAndCheckBlockingCells(int player) {
 
 		bool foundFriendly = false;
 
-		while (newCell.isInBounds()) {
+		while (true) {
 			newCell += dir;
+
+			if (!newCell.isInBounds()) break;
+
 			PieceRepr piece = getPiece(newCell);
 
 			if (piece.player == player) {
@@ -494,10 +532,16 @@ PinAndCheckBlockCell MoveGenerator::getPinnedAndCheckBlockingCells(int player) {
 }
 
 void MoveGenerator::makeMove(Move move) {
-	MoveMemory moveMemory = { move, getPiece(move.from), getPiece(move.to), enPassantableCell };
+	MoveMemory moveMemory = { move, getPiece(move.from), getPiece(move.to), enPassantableCell, halfmoveClock };
 
 	moveHistory.push(moveMemory); // Add the move history to the stack
 
+	bool resetsClock = getPiece(move.from).type == PieceType::PAWN || getPiece(move.to).type != PieceType::NO_PIECE;
+
+	halfmoveClock = resetsClock ? 0 : halfmoveClock + 1;
+
+	if (currentPlayer == 2) fullmoveNumber++;
+
 	movePiece(move.from, move.to, true);
 
 	// Mark the piece as moved if necessary
@@ -505,6 +549,11 @@ void MoveGenerator::makeMove(Move move) {
 		getPiece(move.to).hasMoved = true;
 	}
 
+	// Pawns reaching the last rank become queens, like the board does for the AI
+	if (getPiece(move.to).type == PieceType::PAWN && (move.to.rank == 0 || move.to.rank == 7)) {
+		setPiece(move.to, { PieceType::QUEEN, getPiece(move.to).player, true });
+	}
+
 	if (move.flag.has_value()) {
 		switch (move.flag.value()) {
 		case MoveFlag::EN_PASSANTABLE: {
@@ -552,10 +601,11 @@ void MoveGenerator::undoMove() {
 	PieceRepr previousTo = moveMemory.to;
 	optional<Cell> previousEnPassant = moveMemory.enPassantableCell;
 
-	setPiece(move.from, previousFrom);
+	setPiece(move.from, previousFrom); // Also turns a promoted queen back into the pawn
 	setPiece(move.to, previousTo);
 
 	enPassantableCell = previousEnPassant;
+	halfmoveClock = moveMemory.halfmoveClock;
 
 	if (move.flag.has_value()) {
 		switch (move.flag.value()) {
@@ -582,6 +632,8 @@ void MoveGenerator::undoMove() {
 	}
 
 	currentPlayer = (currentPlayer % 2) + 1; // Switch players
+
+	if (currentPlayer == 2) fullmoveNumber--;
 }
 
 void MoveGenerator::movePiece(Cell from, Cell to, bool moved) {
@@ -590,9 +642,16 @@ void MoveGenerator::movePiece(Cell from, Cell to, bool moved) {
 	removePiece(from);
 }
 
-void MoveGenerator::removePiece(Cell cell) { board[cell.rank][cell.file] = { PieceType::NO_PIECE, -1, false }; }
+void MoveGenerator::removePiece(Cell cell) { setPiece(cell, { PieceType::NO_PIECE, -1, false }); }
 
-void MoveGenerator::setPiece(Cell cell, PieceRepr tile) { board[cell.rank][cell.file] = tile; }
+void MoveGenerator::setPiece(Cell cell, PieceRepr tile) {
+	PieceRepr& current = board[cell.rank][cell.file];
+
+	if (current.type != PieceType::NO_PIECE) pieceKey ^= getZobristPieceKey(current.type, current.player, cell);
+	if (tile.type != PieceType::NO_PIECE) pieceKey ^= getZobristPieceKey(tile.type, tile.player, cell);
+
+	current = tile;
+}
 
 PieceRepr& MoveGenerator::getPiece(Cell cell) { return board[cell.rank][cell.file]; }
 
@@ -614,7 +673,10 @@ void MoveGenerator::sortMoves(vector<Move>& moves) {
 }
 
 int MoveGenerator::search(int depth, int alpha, int beta) {
-	if (depth == 0) return evaluateBoard();
+	if (depth == 0) {
+		optional<int> tablebaseScore = getTablebaseScore();
+		return tablebaseScore ? tablebaseScore.value() : evaluateBoard();
+	}
 
 	vector<Move> moves = getAllMoves(currentPlayer);
 	if (moves.empty()) {
@@ -643,8 +705,136 @@ int MoveGenerator::search(int depth, int alpha, int beta) {
 	return bestScore;
 }
 
+optional<Move> MoveGenerator::getBookMove() {
+	OpeningBook& book = OpeningBook::get();
+
+	if (!book.isOpen()) return nullopt;
+
+	vector<BookEntry> entries = book.getEntries(getZobristKey());
+
+	if (entries.empty()) return nullopt;
+
+	// Keys can collide, so only moves that are legal here count
+	vector<Move> legalMoves = getAllLegalMoves(currentPlayer);
+	vector<pair<Move, int>> bookMoves;
+	int totalWeight = 0;
+
+	for (const BookEntry& entry : entries) {
+		for (const Move& move : legalMoves) {
+			if (move.from == getBookMoveFrom(entry.move) && move.to == getBookMoveTo(entry.move)) {
+				bookMoves.push_back({ move, entry.weight });
+				totalWeight += entry.weight;
+				break;
+			}
+		}
+	}
+
+	if (totalWeight == 0) return nullopt;
+
+	int pick = random.nextInt(totalWeight);
+
+	for (const auto& [move, weight] : bookMoves) {
+		if (pick < weight) return move;
+		pick -= weight;
+	}
+
+	return nullopt;
+}
+
+bool MoveGenerator::getTablebasePosition(TablebasePosition& position) {
+	position.count = 0;
+	position.sideToMove = currentPlayer;
+
+	for (int rank = 0; rank < 8; rank++) {
+		for (int file = 0; file < 8; file++) {
+			const PieceRepr& piece = board[rank][file];
+
+			if (piece.type == PieceType::NO_PIECE) continue;
+			if (position.count == TABLEBASE_MAX_PIECES) return false;
+
+			position.pieces[position.count++] = { piece.type, piece.player, Cell(rank, file) };
+		}
+	}
+
+	return true;
+}
+
+optional<int> MoveGenerator::getTablebaseScore() {
+	Tablebases& tablebases = Tablebases::get();
+	TablebasePosition position;
+
+	if (!tablebases.isOpen() || !getTablebasePosition(position)) return nullopt;
+
+	optional<TablebaseWDL> wdl = tablebases.probeWDL(position);
+
+	if (!wdl) return nullopt;
+
+	switch (wdl.value()) {
+		case TablebaseWDL::WIN: return TABLEBASE_WIN_SCORE;
+		case TablebaseWDL::LOSS: return -TABLEBASE_WIN_SCORE;
+		default: return 0;
+	}
+}
+
+optional<Move> MoveGenerator::getTablebaseMove() {
+	Tablebases& tablebases = Tablebases::get();
+	TablebasePosition position;
+
+	if (!tablebases.isOpen() || !getTablebasePosition(position) || !tablebases.probeWDL(position)) return nullopt;
+
+	optional<Move> bestMove;
+	int bestScore = INT_MIN;
+
+	int player = currentPlayer;
+
+	for (const Move& move : getAllLegalMoves(player)) {
+		makeMove(move);
+
+		// The legal moves can walk the king into an attack when it isn't in check, the tablebases would see that as a draw
+		vector<Move> replies = getAllMoves(currentPlayer, true);
+		Cell kingCell = findKing(player);
+		bool exposesKing = any_of(replies.begin(), replies.end(), [&](const Move& reply) { return reply.to == kingCell; });
+
+		optional<TablebaseResult> result;
+		if (!exposesKing && getTablebasePosition(position)) result = tablebases.probeDTM(position);
+
+		undoMove();
+
+		if (exposesKing) continue;
+		if (!result) return nullopt; // The move leads somewhere the tablebases don't cover
+
+		// The result is for the opponent, so their loss is our win: mate as fast as possible, and lose as slowly as possible
+		int score = 0;
+		if (result->wdl == TablebaseWDL::LOSS) score = TABLEBASE_WIN_SCORE - result->dtm;
+		else if (result->wdl == TablebaseWDL::WIN) score = -TABLEBASE_WIN_SCORE + result->dtm;
+
+		if (score > bestScore) {
+			bestScore = score;
+			bestMove = move;
+		}
+	}
+
+	return bestMove;
+}
+
 Move MoveGenerator::chooseMove(int ply) {
-	cout << "Searching moves for player #" << currentPlayer << "..." << endl;
+	PROFILE_SCOPE("MoveGenerator::chooseMove");
+
+	optional<Move> bookMove = getBookMove();
+
+	if (bookMove) {
+		GAME_LOG("Book move: " << bookMove->from.getAlgebraicNotation() << " to " << bookMove->to.getAlgebraicNotation() << endl);
+		return bookMove.value();
+	}
+
+	optional<Move> tablebaseMove = getTablebaseMove();
+
+	if (tablebaseMove) {
+		GAME_LOG("Tablebase move: " << tablebaseMove->from.getAlgebraicNotation() << " to " << tablebaseMove->to.getAlgebraicNotation() << endl);
+		return tablebaseMove.value();
+	}
+
+	GAME_LOG("Searching moves for player #" << currentPlayer << "..." << endl);
 	vector<Move> allMoves = getAllLegalMoves(currentPlayer);
 
 	sortMoves(allMoves);
@@ -652,8 +842,8 @@ Move MoveGenerator::chooseMove(int ply) {
 	Move bestMove;
 	int bestScore = INT_MIN;
 
-	cout << "Number of possible moves: " << allMoves.size() << endl;
-	cout << "Checking follow-up moves (with a depth of " << ply << " plies)..." << endl;
+	GAME_LOG("Number of possible moves: " << allMoves.size() << endl);
+	GAME_LOG("Checking follow-up moves (with a depth of " << ply << " plies)..." << endl);
 
 	double startTime = GetTime();
 
@@ -671,9 +861,9 @@ Move MoveGenerator::chooseMove(int ply) {
 
 	double elapsedTime = GetTime() - startTime;
 
-	cout << " Done! Took: " << elapsedTime << " seconds" << endl;
+	GAME_LOG(" Done! Took: " << elapsedTime << " seconds" << endl);
 
-	cout << "Move chosen: " << bestMove.from.getAlgebraicNotation() << " to " << bestMove.to.getAlgebraicNotation() << endl;
+	GAME_LOG("Move chosen: " << bestMove.from.getAlgebraicNotation() << " to " << bestMove.to.getAlgebraicNotation() << endl);
 
 	return bestMove;
 }
\ No newline at end of file
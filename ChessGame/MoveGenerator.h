@@ -10,6 +10,10 @@
 #include <string>
 #include <optional>
 #include <stack>
+#include "Random.h"
+#include "Position.h"
+#include "OpeningBook.h"
+#include "Tablebase.h"
 
 using namespace std;
 
@@ -32,6 +36,7 @@ struct MoveMemory {
 	PieceRepr from;
 	PieceRepr to;
 	optional<Cell> enPassantableCell;
+	int halfmoveClock;
 };
 
 struct PinAndCheckBlockCell {
@@ -47,6 +52,8 @@ class MoveGenerator {
 	private:
 		PieceRepr board[8][8];
 		Personality personality;
+
+		Random random; // Noise added to evaluations, so equal moves aren't always picked the same way
 		float knightPositionalStrength[8][8] = {
 			0.0, 0.2, 0.4, 0.4, 0.4, 0.4, 0.2, 0.0,
 			0.2, 0.5, 0.6, 0.6, 0.6, 0.6, 0.5, 0.2,
@@ -118,8 +125,17 @@ class MoveGenerator {
 
 		int currentPlayer;
 
+		int halfmoveClock = 0; // Plies since the last capture or pawn move
+		int fullmoveNumber = 1;
+
 		stack<MoveMemory> moveHistory;
 
+		uint64_t pieceKey = 0; // Zobrist key of the pieces alone, kept up to date by setPiece so the search doesn't hash the board
+
+		int evaluationNoise = 50; // Largest random amount added to evaluations
+
+		void updatePieceKey();
+
 		void addSlidingMoves(const Cell& start, const vector<Cell>& directions, int player, vector<Move>& moves, bool attacksOnly = false);
 
 		void addOffsetMoves(const Cell& start, const vector<Cell>& offsets, int player, vector<Move>& moves, bool attacksOnly = false);
@@ -127,8 +143,44 @@ class MoveGenerator {
 	public:
 		MoveGenerator(Game& game);
 
+		/// <summary>
+		/// Creates a search position from a FEN, tiles are ignored since the search doesn't know about them
+		/// </summary>
 		MoveGenerator(string fen);
 
+		MoveGenerator(const Position& position);
+
+		/// <summary>
+		/// Gets the search position, with the moves made so far
+		/// </summary>
+		Position getPosition();
+
+		/// <summary>
+		/// Gets the search position as a standard FEN
+		/// </summary>
+		string getFEN();
+
+		/// <summary>
+		/// Gets the Zobrist key of the search position, used to look it up in the opening book
+		/// </summary>
+		uint64_t getZobristKey();
+
+		/// <summary>
+		/// Gets the player who's turn it is in the search position
+		/// </summary>
+		int getCurrentPlayer();
+
+		/// <summary>
+		/// Gets a key of the search position for the transposition table, cheaper than getZobristKey since it isn't rebuilt from the board.
+		/// En passant is hashed whenever a pawn just moved two cells, so it doesn't always match the book key
+		/// </summary>
+		uint64_t getSearchKey();
+
+		/// <summary>
+		/// Sets the largest random amount added to evaluations, 0 makes the search deterministic
+		/// </summary>
+		void setEvaluationNoise(int noise);
+
 		/************************************|
 				 BOARD STATE FUNCTIONS
 		|************************************/
@@ -237,6 +289,11 @@ class MoveGenerator {
 		/// <returns>The Cell of the player's king, or {-1, -1} if not found</returns>
 		Cell findKing(int player);
 
+		/// <summary>
+		/// Checks if a player's king is attacked
+		/// </summary>
+		bool isInCheck(int player);
+
 		/// <summary>
 		/// Gets a list of moves for a piece on the board
 		/// </summary>
@@ -307,11 +364,35 @@ class MoveGenerator {
 		/// <returns>The best score achievable from the current position</returns>
 		int search(int depth, int alpha, int beta);
 
+		/// <summary>
+		/// Picks a move from the opening book, weighted by how well each move did
+		/// </summary>
+		/// <returns>A legal book move, or nullopt if the position isn't in the book</returns>
+		optional<Move> getBookMove();
+
+		/// <summary>
+		/// Gets the search position for the endgame tablebases, piece for piece as it is on the board
+		/// </summary>
+		/// <returns>false if there are too many pieces left to look up</returns>
+		bool getTablebasePosition(TablebasePosition& position);
+
+		/// <summary>
+		/// Scores the position from the tablebases, for the leaves of the search
+		/// </summary>
+		/// <returns>The score for the current player, or nullopt if the position isn't in the tablebases</returns>
+		optional<int> getTablebaseScore();
+
+		/// <summary>
+		/// Picks the move that mates fastest, holds the draw, or lasts longest when lost, from the tablebases
+		/// </summary>
+		/// <returns>The best move, or nullopt if the position isn't in the tablebases</returns>
+		optional<Move> getTablebaseMove();
+
 		/// <summary>
 		/// Searches all possible moves and chooses a move to play
 		/// </summary>
 		/// <param name="ply">The number of plies (half-turns) to search ahead</param>
-		/// <returns>The move to make on the board</returns>
+		/// <returns>The move to make on the board, straight from the opening book or tablebases if the position is in them</returns>
 		Move chooseMove(int ply);
 
 		/************************************|
@@ -321,7 +402,7 @@ class MoveGenerator {
 		void printShannonNumber(int calculatedMoves, int plies) { // https://en.wikipedia.org/wiki/Shannon_number
 			vector<long long> shannonNumbers = { 20, 400, 8902, 197281, 4865609, 119060324, 2863350967, 69586103104, 1669531250000 };
 
-			cout << endl << "Total moves calculated: " << calculatedMoves << endl;
+			GAME_LOG(endl << "Total moves calculated: " << calculatedMoves << endl);
 
 			int expectedMoves = 0;
 				
@@ -329,7 +410,7 @@ class MoveGenerator {
 				expectedMoves += shannonNumbers[i];
 			}
 
-			cout << "Expected moves calculated: " << expectedMoves << endl;
+			GAME_LOG("Expected moves calculated: " << expectedMoves << endl);
 		}
 
 		void printBoard();
@@ -0,0 +1,689 @@
+#include "MusicMixer.h"
+#include "AssetPack.h"
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+
+#define WAVE_FORMAT_PCM 1
+#define WAVE_FORMAT_IEEE_FLOAT 3
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+static uint16_t readU16(const uint8_t* bytes) { return bytes[0] | (bytes[1] << 8); }
+
+static uint32_t readU32(const uint8_t* bytes) { return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24); }
+
+// QOA is big endian
+static uint64_t readU64BigEndian(const uint8_t* bytes) {
+	uint64_t value = 0;
+
+	for (int i = 0; i < 8; i++) value = (value << 8) | bytes[i];
+
+	return value;
+}
+
+/// <summary>
+/// Residuals of each QOA scale factor and quantized value, the scale factor is (s + 1) ^ 2.75 times 0.75, 2.5, 4.5 or 7
+/// </summary>
+static const array<array<int, 8>, 16> qoaDequantTable = []() {
+	const float steps[8] = { 0.75f, -0.75f, 2.5f, -2.5f, 4.5f, -4.5f, 7.0f, -7.0f };
+
+	array<array<int, 8>, 16> table;
+
+	for (int scaleFactor = 0; scaleFactor < 16; scaleFactor++) {
+		float scale = roundf(powf(scaleFactor + 1.0f, 2.75f));
+
+		for (int quantized = 0; quantized < 8; quantized++) table[scaleFactor][quantized] = (int)roundf(scale * steps[quantized]);
+	}
+
+	return table;
+}();
+
+/************************************|
+		   WAV STEM READER
+|************************************/
+
+StemReader::~StemReader() { close(); }
+
+size_t StemReader::readBytes(void* output, size_t size) {
+	if (file) return fread(output, 1, size, file);
+
+	size = min(size, memorySize - memoryPosition);
+
+	memcpy(output, memory + memoryPosition, size);
+	memoryPosition += size;
+
+	return size;
+}
+
+const uint8_t* StemReader::readData(size_t size, size_t& bytesRead) {
+	// Mapped stems are read in place
+	if (!file) {
+		bytesRead = min(size, memorySize - memoryPosition);
+
+		const uint8_t* data = memory + memoryPosition;
+		memoryPosition += bytesRead;
+
+		return data;
+	}
+
+	readBuffer.resize(size);
+	bytesRead = fread(readBuffer.data(), 1, size, file);
+
+	return readBuffer.data();
+}
+
+void StemReader::seekBytes(long position) {
+	if (file) fseek(file, position, SEEK_SET);
+	else memoryPosition = min((size_t)max(position, 0L), memorySize);
+}
+
+long StemReader::tellBytes() { return file ? ftell(file) : (long)memoryPosition; }
+
+bool StemReader::open(const string& path) {
+	close();
+
+	// Read from the mapped pack if the stem is in there, otherwise from the loose file
+	AssetBlob blob = AssetPack::get().find(path);
+
+	if (blob.data) {
+		memory = blob.data;
+		memorySize = blob.size;
+		memoryPosition = 0;
+	} else {
+		file = fopen(path.c_str(), "rb");
+
+		if (!file) return false;
+	}
+
+	uint8_t header[12];
+
+	if (readBytes(header, 12) == 12 && memcmp(header, "qoaf", 4) == 0) return openQoa(header);
+
+	if (memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+		close();
+		return false;
+	}
+
+	format = StemFormat::WAV;
+
+	bool foundFormat = false;
+	int blockAlign = 0;
+
+	// Walk the chunks until the sample data is found
+	uint8_t chunkHeader[8];
+
+	while (readBytes(chunkHeader, 8) == 8) {
+		uint32_t chunkSize = readU32(chunkHeader + 4);
+
+		if (memcmp(chunkHeader, "fmt ", 4) == 0) {
+			uint8_t format[40] = { 0 };
+
+			if (chunkSize < 16 || readBytes(format, min<uint32_t>(chunkSize, 40)) != min<uint32_t>(chunkSize, 40)) break;
+
+			formatTag     = readU16(format);
+			channels      = readU16(format + 2);
+			sampleRate    = readU32(format + 4);
+			blockAlign    = readU16(format + 12);
+			bitsPerSample = readU16(format + 14);
+
+			// The actual format of extensible files is the start of the sub format GUID
+			if (formatTag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 40) formatTag = readU16(format + 24);
+
+			if (chunkSize > 40) seekBytes(tellBytes() + chunkSize - 40);
+
+			foundFormat = true;
+		} else if (memcmp(chunkHeader, "data", 4) == 0) {
+			if (!foundFormat || blockAlign == 0) break;
+
+			dataStart = tellBytes();
+			dataFrames = chunkSize / blockAlign;
+
+			bool supported = channels > 0 &&
+				((formatTag == WAVE_FORMAT_PCM && (bitsPerSample == 8 || bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32)) ||
+				 (formatTag == WAVE_FORMAT_IEEE_FLOAT && bitsPerSample == 32));
+
+			if (!supported || dataFrames == 0) break;
+
+			framePosition = 0;
+			return true;
+		} else {
+			seekBytes(tellBytes() + chunkSize + (chunkSize & 1)); // Chunks are padded to an even size
+		}
+	}
+
+	close();
+	return false;
+}
+
+bool StemReader::openQoa(const uint8_t* header) {
+	format = StemFormat::QOA;
+
+	dataFrames = (header[4] << 24) | (header[5] << 16) | (header[6] << 8) | header[7];
+	dataStart = 8;
+
+	// The first frame has the channels and sample rate, every frame has to match it
+	uint8_t frameHeader[8];
+
+	seekBytes(dataStart);
+
+	if (dataFrames == 0 || readBytes(frameHeader, 8) != 8 || frameHeader[0] == 0 || frameHeader[0] > QOA_MAX_CHANNELS) {
+		close();
+		return false;
+	}
+
+	channels = frameHeader[0];
+	sampleRate = (frameHeader[1] << 16) | (frameHeader[2] << 8) | frameHeader[3];
+
+	seekBytes(dataStart);
+
+	framePosition = 0;
+	decodedFrames = 0;
+	decodedPosition = 0;
+
+	return true;
+}
+
+bool StemReader::decodeQoaFrame() {
+	uint8_t frameHeader[8];
+
+	if (readBytes(frameHeader, 8) != 8) return false;
+
+	int frameChannels = frameHeader[0];
+	int frameSamples = (frameHeader[4] << 8) | frameHeader[5];
+	int frameSize = (frameHeader[6] << 8) | frameHeader[7];
+
+	int slices = (frameSamples + QOA_SLICE_LENGTH - 1) / QOA_SLICE_LENGTH;
+
+	if (frameChannels != channels || frameSamples == 0 || frameSamples > QOA_FRAME_LENGTH || frameSize != 8 + channels * 16 + slices * channels * 8) return false;
+
+	size_t bytesRead;
+	const uint8_t* bytes = readData(frameSize - 8, bytesRead);
+
+	if (bytesRead != (size_t)(frameSize - 8)) return false;
+
+	// Each channel predicts its samples from the last four, with weights that adapt as it goes
+	int history[QOA_MAX_CHANNELS][4];
+	int weights[QOA_MAX_CHANNELS][4];
+
+	for (int channel = 0; channel < channels; channel++) {
+		uint64_t packedHistory = readU64BigEndian(bytes);
+		uint64_t packedWeights = readU64BigEndian(bytes + 8);
+		bytes += 16;
+
+		for (int i = 0; i < 4; i++) {
+			history[channel][i] = (int16_t)(packedHistory >> 48);
+			weights[channel][i] = (int16_t)(packedWeights >> 48);
+
+			packedHistory <<= 16;
+			packedWeights <<= 16;
+		}
+	}
+
+	decoded.resize(frameSamples * channels);
+
+	// Slices of 20 samples, interleaved by channel. Each is a 4 bit scale factor followed by 3 bits per sample
+	for (int sliceStart = 0; sliceStart < frameSamples; sliceStart += QOA_SLICE_LENGTH) {
+		int sliceEnd = min(sliceStart + QOA_SLICE_LENGTH, frameSamples);
+
+		for (int channel = 0; channel < channels; channel++) {
+			uint64_t slice = readU64BigEndian(bytes);
+			bytes += 8;
+
+			const array<int, 8>& dequant = qoaDequantTable[(slice >> 60) & 0xF];
+			slice <<= 4;
+
+			int* sampleHistory = history[channel];
+			int* sampleWeights = weights[channel];
+
+			for (int sample = sliceStart; sample < sliceEnd; sample++) {
+				int predicted = (sampleWeights[0] * sampleHistory[0] + sampleWeights[1] * sampleHistory[1] +
+				                 sampleWeights[2] * sampleHistory[2] + sampleWeights[3] * sampleHistory[3]) >> 13;
+
+				int residual = dequant[(slice >> 61) & 0x7];
+				slice <<= 3;
+
+				int reconstructed = clamp(predicted + residual, -32768, 32767);
+
+				decoded[sample * channels + channel] = (int16_t)reconstructed;
+
+				int delta = residual >> 4;
+
+				for (int i = 0; i < 4; i++) sampleWeights[i] += sampleHistory[i] < 0 ? -delta : delta;
+
+				sampleHistory[0] = sampleHistory[1];
+				sampleHistory[1] = sampleHistory[2];
+				sampleHistory[2] = sampleHistory[3];
+				sampleHistory[3] = reconstructed;
+			}
+		}
+	}
+
+	decodedFrames = frameSamples;
+	decodedPosition = 0;
+
+	return true;
+}
+
+void StemReader::readQoa(float* output, int frameCount) {
+	while (frameCount > 0) {
+		if (decodedPosition >= decodedFrames) {
+			if (framePosition >= dataFrames) { // Loop back to the start
+				seekBytes(dataStart);
+				framePosition = 0;
+			}
+
+			if (!decodeQoaFrame()) { // File ended early or is broken, play silence until it loops
+				memset(output, 0, frameCount * 2 * sizeof(float));
+				framePosition = dataFrames;
+				decodedFrames = 0;
+				decodedPosition = 0;
+				return;
+			}
+		}
+
+		int framesToCopy = min(frameCount, decodedFrames - decodedPosition);
+
+		for (int frame = 0; frame < framesToCopy; frame++) {
+			const int16_t* samples = decoded.data() + (decodedPosition + frame) * channels;
+
+			output[0] = samples[0] / 32768.0f;
+			output[1] = samples[min(1, channels - 1)] / 32768.0f;
+			output += 2;
+		}
+
+		decodedPosition += framesToCopy;
+		framePosition += framesToCopy;
+		frameCount -= framesToCopy;
+	}
+}
+
+void StemReader::close() {
+	if (file) fclose(file);
+	file = nullptr;
+
+	memory = nullptr;
+	memorySize = 0;
+	memoryPosition = 0;
+}
+
+bool StemReader::isOpen() const { return file || memory; }
+
+void StemReader::read(float* output, int frameCount) {
+	if (!isOpen()) {
+		memset(output, 0, frameCount * 2 * sizeof(float));
+		return;
+	}
+
+	if (format == StemFormat::QOA) {
+		readQoa(output, frameCount);
+		return;
+	}
+
+	int bytesPerSample = bitsPerSample / 8;
+	int frameSize = bytesPerSample * channels;
+
+	while (frameCount > 0) {
+		if (framePosition >= dataFrames) { // Loop back to the start
+			seekBytes(dataStart);
+			framePosition = 0;
+		}
+
+		int framesToRead = min<uint32_t>(frameCount, dataFrames - framePosition);
+
+		size_t bytesRead;
+		const uint8_t* frames = readData(framesToRead * frameSize, bytesRead);
+
+		int framesRead = (int)(bytesRead / frameSize);
+
+		if (framesRead <= 0) { // File ended early, play silence until it loops
+			memset(output, 0, frameCount * 2 * sizeof(float));
+			framePosition = dataFrames;
+			return;
+		}
+
+		for (int frame = 0; frame < framesRead; frame++) {
+			const uint8_t* frameBytes = frames + frame * frameSize;
+
+			float samples[2];
+
+			for (int channel = 0; channel < 2; channel++) {
+				const uint8_t* sample = frameBytes + min(channel, channels - 1) * bytesPerSample;
+
+				if (formatTag == WAVE_FORMAT_IEEE_FLOAT) {
+					uint32_t bits = readU32(sample);
+					memcpy(&samples[channel], &bits, sizeof(float));
+				} else if (bitsPerSample == 8) {
+					samples[channel] = (sample[0] - 128) / 128.0f;
+				} else if (bitsPerSample == 16) {
+					samples[channel] = (int16_t)readU16(sample) / 32768.0f;
+				} else if (bitsPerSample == 24) {
+					int32_t value = (int32_t)((sample[0] << 8) | (sample[1] << 16) | ((uint32_t)sample[2] << 24)) >> 8;
+					samples[channel] = value / 8388608.0f;
+				} else {
+					samples[channel] = (int32_t)readU32(sample) / 2147483648.0f;
+				}
+			}
+
+			output[0] = samples[0];
+			output[1] = samples[1];
+			output += 2;
+		}
+
+		framePosition += framesRead;
+		frameCount -= framesRead;
+	}
+}
+
+void StemReader::seek(uint64_t frame) {
+	if (!isOpen()) return;
+
+	framePosition = (uint32_t)(frame % dataFrames);
+
+	if (format == StemFormat::WAV) {
+		seekBytes(dataStart + (long)framePosition * (bitsPerSample / 8) * channels);
+		return;
+	}
+
+	// Every QOA frame but the last is full, so the one the position is in can be found without reading the others
+	int frameIndex = framePosition / QOA_FRAME_LENGTH;
+	int fullFrameSize = 8 + channels * 16 + (QOA_FRAME_LENGTH / QOA_SLICE_LENGTH) * channels * 8;
+
+	seekBytes(dataStart + (long)frameIndex * fullFrameSize);
+
+	decodedFrames = 0;
+	decodedPosition = 0;
+
+	if (decodeQoaFrame()) decodedPosition = framePosition % QOA_FRAME_LENGTH;
+	else framePosition = dataFrames;
+}
+
+int StemReader::getSampleRate() const { return sampleRate; }
+
+/************************************|
+			 MUSIC MIXER
+|************************************/
+
+const string MUSIC_STEMS[MUSIC_LAYER_COUNT] = {
+	"resources/theme1_normal",
+	"resources/theme1_ice",
+	"resources/theme1_break",
+	"resources/theme1_conveyor",
+	"resources/theme1_portal"
+};
+
+static const char* musicStemExtensions[] = { ".qoa", ".wav" };
+
+atomic<MusicMixer*> MusicMixer::activeMixer{ nullptr };
+
+MusicMixer::MusicMixer() {
+	for (int layer = 0; layer < MUSIC_LAYER_COUNT; layer++) {
+		targetVolumes[layer].store(0.0f);
+	}
+}
+
+MusicMixer::~MusicMixer() { stop(); }
+
+bool MusicMixer::start(const string (&paths)[MUSIC_LAYER_COUNT]) {
+	if (running || !IsAudioDeviceReady()) return false;
+
+	sampleRate = 0;
+	mixedFrames = 0;
+
+	for (int layer = 0; layer < MUSIC_LAYER_COUNT; layer++) {
+		stemPaths[layer] = paths[layer];
+		stemFailed[layer] = false;
+	}
+
+	// Most layers are silent until their tiles spawn, so only the ones that can be heard are opened now
+	for (int layer = 0; layer < MUSIC_LAYER_COUNT; layer++) {
+		if (targetVolumes[layer].load() > 0.0f) openStem(layer);
+	}
+
+	// The stream needs a sample rate even if nothing can be heard yet
+	for (int layer = 0; layer < MUSIC_LAYER_COUNT && sampleRate == 0; layer++) {
+		if (!stemLoaded[layer] && !stemFailed[layer]) openStem(layer);
+	}
+
+	if (sampleRate == 0) return false;
+
+	ring.assign(MUSIC_RING_FRAMES * 2, 0.0f);
+	ringWrite = 0;
+	ringRead = 0;
+
+	for (int layer = 0; layer < MUSIC_LAYER_COUNT; layer++) currentVolumes[layer] = targetVolumes[layer].load();
+
+	running = true;
+	mixingThread = thread(&MusicMixer::mixLoop, this);
+
+	stream = LoadAudioStream(sampleRate, 32, 2);
+
+	activeMixer = this;
+	SetAudioStreamCallback(stream, &MusicMixer::streamCallback);
+	PlayAudioStream(stream);
+
+	return true;
+}
+
+void MusicMixer::stop() {
+	if (!running) return;
+
+	StopAudioStream(stream);
+	UnloadAudioStream(stream);
+	stream = { 0 };
+
+	MusicMixer* self = this;
+	activeMixer.compare_exchange_strong(self, nullptr);
+
+	running = false;
+	if (mixingThread.joinable()) mixingThread.join();
+
+	for (int layer = 0; layer < MUSIC_LAYER_COUNT; layer++) {
+		stems[layer].close();
+		stemLoaded[layer] = false;
+	}
+}
+
+bool MusicMixer::openStem(int layer) {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	// The compressed stem is used if it's been converted, otherwise the WAV
+	string path;
+
+	for (const char* extension : musicStemExtensions) {
+		path = stemPaths[layer] + extension;
+		stemLoaded[layer] = stems[layer].open(path);
+
+		if (stemLoaded[layer]) break;
+	}
+
+	if (!stemLoaded[layer]) {
+		cout << "Failed to open music stem: " << stemPaths[layer] << endl;
+		stemFailed[layer] = true;
+		return false;
+	}
+
+	// Every stem is mixed at the rate of the first one
+	if (sampleRate == 0) {
+		sampleRate = stems[layer].getSampleRate();
+	} else if (stems[layer].getSampleRate() != sampleRate) {
+		cout << "Music stem " << path << " has a different sample rate, skipping it" << endl;
+		stems[layer].close();
+		stemLoaded[layer] = false;
+		stemFailed[layer] = true;
+		return false;
+	}
+
+	stems[layer].seek(mixedFrames);
+
+	cout << "Opened music stem " << path << " in " << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms" << endl;
+
+	return true;
+}
+
+void MusicMixer::setLayerVolume(MusicLayer layer, float volume) {
+	targetVolumes[layer].store(volume, memory_order_relaxed);
+}
+
+bool MusicMixer::isPlaying() const { return running; }
+
+void MusicMixer::streamCallback(void* buffer, unsigned int frames) {
+	float* output = (float*)buffer;
+
+	MusicMixer* mixer = activeMixer.load(memory_order_acquire);
+
+	if (!mixer) {
+		memset(output, 0, frames * 2 * sizeof(float));
+		return;
+	}
+
+	uint64_t read = mixer->ringRead.load(memory_order_relaxed);
+	uint64_t available = mixer->ringWrite.load(memory_order_acquire) - read;
+
+	unsigned int framesToCopy = (unsigned int)min<uint64_t>(frames, available);
+
+	for (unsigned int frame = 0; frame < framesToCopy; frame++) {
+		size_t index = ((read + frame) % MUSIC_RING_FRAMES) * 2;
+		output[frame * 2]     = mixer->ring[index];
+		output[frame * 2 + 1] = mixer->ring[index + 1];
+	}
+
+	// Mixing thread fell behind, play silence rather than old samples
+	if (framesToCopy < frames) memset(output + framesToCopy * 2, 0, (frames - framesToCopy) * 2 * sizeof(float));
+
+	mixer->ringRead.store(read + framesToCopy, memory_order_release);
+}
+
+void MusicMixer::mixLoop() {
+	vector<float> mixed(MUSIC_MIX_FRAMES * 2);
+
+	while (running) {
+		uint64_t write = ringWrite.load(memory_order_relaxed);
+		uint64_t used = write - ringRead.load(memory_order_acquire);
+
+		if (MUSIC_RING_FRAMES - used < MUSIC_MIX_FRAMES) { // Ring is full, wait for the device to catch up
+			this_thread::sleep_for(chrono::milliseconds(5));
+			continue;
+		}
+
+		mixFrames(mixed.data(), MUSIC_MIX_FRAMES);
+
+		for (int frame = 0; frame < MUSIC_MIX_FRAMES; frame++) {
+			size_t index = ((write + frame) % MUSIC_RING_FRAMES) * 2;
+			ring[index]     = mixed[frame * 2];
+			ring[index + 1] = mixed[frame * 2 + 1];
+		}
+
+		ringWrite.store(write + MUSIC_MIX_FRAMES, memory_order_release);
+	}
+}
+
+void MusicMixer::mixFrames(float* output, int frameCount) {
+	static thread_local vector<float> stemBuffer;
+	stemBuffer.resize(frameCount * 2);
+
+	memset(output, 0, frameCount * 2 * sizeof(float));
+
+	for (int layer = 0; layer < MUSIC_LAYER_COUNT; layer++) {
+		// Only the header is read, the ring has enough buffered to cover the disk seek
+		if (!stemLoaded[layer] && !stemFailed[layer] && targetVolumes[layer].load(memory_order_relaxed) > 0.0f) openStem(layer);
+
+		if (!stemLoaded[layer]) continue;
+
+		// Every stem is read even when silent, so the layers stay in sync
+		stems[layer].read(stemBuffer.data(), frameCount);
+
+		// Ramp to the new volume over the chunk to avoid clicks
+		float startVolume = currentVolumes[layer];
+		float endVolume = targetVolumes[layer].load(memory_order_relaxed);
+
+		if (startVolume == 0.0f && endVolume == 0.0f) continue;
+
+		float step = (endVolume - startVolume) / frameCount;
+
+		for (int frame = 0; frame < frameCount; frame++) {
+			float volume = startVolume + step * frame;
+			output[frame * 2]     += stemBuffer[frame * 2] * volume;
+			output[frame * 2 + 1] += stemBuffer[frame * 2 + 1] * volume;
+		}
+
+		currentVolumes[layer] = endVolume;
+	}
+
+	for (int sample = 0; sample < frameCount * 2; sample++) {
+		output[sample] = max(-1.0f, min(1.0f, output[sample]));
+	}
+
+	mixedFrames += frameCount;
+}
+
+/************************************|
+			  CONVERTER
+|************************************/
+
+AudioConvertOptions parseAudioConvertOptions(int argc, char** argv) {
+	AudioConvertOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--convert-audio") != 0) continue;
+
+		// Every following argument up to the next option is a file
+		while (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) options.inputPaths.push_back(argv[++i]);
+	}
+
+	return options;
+}
+
+int convertAudio(const AudioConvertOptions& options) {
+	vector<string> inputPaths = options.inputPaths;
+
+	if (inputPaths.empty()) {
+		for (const string& stem : MUSIC_STEMS) inputPaths.push_back(stem + ".wav");
+	}
+
+	int failures = 0;
+
+	for (const string& inputPath : inputPaths) {
+		Wave wave = LoadWave(inputPath.c_str());
+
+		if (!wave.data) {
+			cerr << "Unable to load " << inputPath << endl;
+			failures++;
+			continue;
+		}
+
+		WaveFormat(&wave, wave.sampleRate, 16, wave.channels); // QOA is encoded from 16 bit samples
+
+		// Swap the extension, the QOA goes next to the WAV
+		string outputPath = inputPath;
+
+		size_t extension = outputPath.find_last_of('.');
+		size_t directory = outputPath.find_last_of("/\\");
+
+		if (extension != string::npos && (directory == string::npos || extension > directory)) outputPath.resize(extension);
+
+		outputPath += ".qoa";
+
+		bool exported = ExportWave(wave, outputPath.c_str());
+
+		UnloadWave(wave);
+
+		if (!exported) {
+			cerr << "Unable to write " << outputPath << endl;
+			failures++;
+			continue;
+		}
+
+		error_code error;
+
+		uintmax_t inputSize = filesystem::file_size(inputPath, error);
+		uintmax_t outputSize = filesystem::file_size(outputPath, error);
+
+		cout << "Converted " << inputPath << " to " << outputPath << ": " << inputSize << " -> " << outputSize << " bytes" << endl;
+	}
+
+	return failures > 0 ? 1 : 0;
+}
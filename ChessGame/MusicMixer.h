@@ -0,0 +1,227 @@
+#ifndef MUSICMIXER_H
+#define MUSICMIXER_H
+
+#include "raylib.h"
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+
+using namespace std;
+
+#define MUSIC_RING_FRAMES 16384 // Frames buffered between the mixing thread and the audio device (~0.37s at 44.1kHz)
+#define MUSIC_MIX_FRAMES 1024   // Frames mixed at a time by the mixing thread
+
+// Layout of QOA files, the compressed format stems are shipped in
+#define QOA_SLICE_LENGTH 20     // Samples per channel in a slice
+#define QOA_FRAME_LENGTH 5120   // Samples per channel in a frame (256 slices)
+#define QOA_MAX_CHANNELS 8
+
+typedef enum {
+	MUSIC_NORMAL,
+	MUSIC_ICE,
+	MUSIC_BREAK,
+	MUSIC_CONVEYOR,
+	MUSIC_PORTAL,
+	MUSIC_LAYER_COUNT
+} MusicLayer;
+
+/// <summary>
+/// The file of each layer of the soundtrack without its extension, in MusicLayer order
+/// </summary>
+extern const string MUSIC_STEMS[MUSIC_LAYER_COUNT];
+
+enum class StemFormat {
+	WAV, // Uncompressed PCM
+	QOA  // Compressed to 3.2 bits per sample, decoded a frame at a time on the mixing thread
+};
+
+/// <summary>
+/// Streams the samples of a WAV or QOA file from disk or the asset pack, looping back to the start when it runs out
+/// </summary>
+class StemReader {
+	private:
+		FILE* file = nullptr;
+
+		StemFormat format = StemFormat::WAV;
+
+		// The stem's bytes in the mapped asset pack, used instead of the file when it's packed
+		const uint8_t* memory = nullptr;
+		size_t memorySize = 0;
+		size_t memoryPosition = 0;
+
+		int formatTag = 0;
+		int channels = 0;
+		int sampleRate = 0;
+		int bitsPerSample = 0;
+
+		long dataStart = 0;
+		uint32_t dataFrames = 0;
+		uint32_t framePosition = 0;
+
+		vector<uint8_t> readBuffer;
+
+		// The QOA frame being played
+		vector<int16_t> decoded;
+		int decodedFrames = 0;
+		int decodedPosition = 0;
+
+		size_t readBytes(void* output, size_t size);
+
+		/// <summary>
+		/// Reads bytes without copying them when the stem is mapped, otherwise into the read buffer
+		/// </summary>
+		/// <returns>The bytes, valid until the next read</returns>
+		const uint8_t* readData(size_t size, size_t& bytesRead);
+
+		void seekBytes(long position);
+
+		long tellBytes();
+
+		/// <summary>
+		/// Reads the header of a QOA file, after the first 12 bytes have been read
+		/// </summary>
+		bool openQoa(const uint8_t* header);
+
+		/// <summary>
+		/// Decodes the QOA frame at the read position
+		/// </summary>
+		/// <returns>true if a frame was decoded, false if the file ended or the frame is malformed</returns>
+		bool decodeQoaFrame();
+
+		void readQoa(float* output, int frameCount);
+
+	public:
+		StemReader() = default;
+		~StemReader();
+
+		StemReader(const StemReader&) = delete;
+		StemReader& operator=(const StemReader&) = delete;
+
+		/// <summary>
+		/// Opens a WAV or QOA file and reads its header, from the asset pack if it's in there
+		/// </summary>
+		/// <param name="path">The path of the file</param>
+		/// <returns>true if the file is a WAV or QOA file that can be streamed, false if not</returns>
+		bool open(const string& path);
+
+		void close();
+
+		bool isOpen() const;
+
+		/// <summary>
+		/// Moves to a frame, wrapping around the end like the stem does when it loops
+		/// </summary>
+		void seek(uint64_t frame);
+
+		/// <summary>
+		/// Reads frames as interleaved stereo floats, mono files are copied to both channels
+		/// </summary>
+		/// <param name="output">Buffer for frameCount * 2 floats</param>
+		/// <param name="frameCount">The number of frames to read</param>
+		void read(float* output, int frameCount);
+
+		int getSampleRate() const;
+};
+
+/// <summary>
+/// Mixes the layers of the adaptive soundtrack on a background thread into a single audio stream
+/// </summary>
+class MusicMixer {
+	private:
+		StemReader stems[MUSIC_LAYER_COUNT];
+		string stemPaths[MUSIC_LAYER_COUNT];
+		bool stemLoaded[MUSIC_LAYER_COUNT] = {};
+		bool stemFailed[MUSIC_LAYER_COUNT] = {}; // Couldn't be opened, so it isn't tried again
+
+		atomic<float> targetVolumes[MUSIC_LAYER_COUNT];
+		float currentVolumes[MUSIC_LAYER_COUNT] = {}; // Only touched by the mixing thread
+
+		// Single producer (mixing thread), single consumer (audio thread) ring buffer of stereo frames
+		vector<float> ring;
+		atomic<uint64_t> ringWrite{ 0 };
+		atomic<uint64_t> ringRead{ 0 };
+
+		AudioStream stream = { 0 };
+		int sampleRate = 0;
+
+		uint64_t mixedFrames = 0; // Frames mixed since the start, where a stem opened later starts from
+
+		thread mixingThread;
+		atomic<bool> running{ false };
+
+		/// <summary>
+		/// The mixer the audio stream callback reads from, raylib callbacks don't take a user pointer
+		/// </summary>
+		static atomic<MusicMixer*> activeMixer;
+
+		static void streamCallback(void* buffer, unsigned int frames);
+
+		/// <summary>
+		/// Keeps the ring buffer filled, runs on the mixing thread
+		/// </summary>
+		void mixLoop();
+
+		/// <summary>
+		/// Opens the stem of a layer at the frame the mix is at, so it lines up with the others
+		/// </summary>
+		/// <returns>true if the stem can be mixed, false if it couldn't be opened or has a different sample rate</returns>
+		bool openStem(int layer);
+
+		/// <summary>
+		/// Mixes the next chunk of every stem into the output, opening the stems that became audible
+		/// </summary>
+		void mixFrames(float* output, int frameCount);
+
+	public:
+		MusicMixer();
+		~MusicMixer();
+
+		MusicMixer(const MusicMixer&) = delete;
+		MusicMixer& operator=(const MusicMixer&) = delete;
+
+		/// <summary>
+		/// Opens the stems that can be heard and starts the mixing thread and audio stream.
+		/// The other stems are opened by the mixing thread the first time their layer's volume goes up
+		/// </summary>
+		/// <param name="paths">The file of each layer without its extension, in MusicLayer order. A .qoa is played over a .wav</param>
+		/// <returns>true if at least one stem could be played, false if not</returns>
+		bool start(const string (&paths)[MUSIC_LAYER_COUNT]);
+
+		/// <summary>
+		/// Stops the audio stream and the mixing thread
+		/// </summary>
+		void stop();
+
+		/// <summary>
+		/// Sets the volume a layer fades to, safe to call every frame
+		/// </summary>
+		/// <param name="layer">The layer to set the volume of</param>
+		/// <param name="volume">The volume, from 0 to 1</param>
+		void setLayerVolume(MusicLayer layer, float volume);
+
+		bool isPlaying() const;
+};
+
+/************************************|
+			  CONVERTER
+|************************************/
+
+struct AudioConvertOptions {
+	vector<string> inputPaths; // WAV files to convert, the music stems if none are given
+};
+
+/// <summary>
+/// Reads the options of the --convert-audio mode: --convert-audio [files...]
+/// </summary>
+AudioConvertOptions parseAudioConvertOptions(int argc, char** argv);
+
+/// <summary>
+/// Compresses WAV files to QOA, each written next to its WAV so the mixer plays it instead
+/// </summary>
+/// <returns>The exit code of the program</returns>
+int convertAudio(const AudioConvertOptions& options);
+
+#endif
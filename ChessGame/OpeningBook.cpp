@@ -0,0 +1,270 @@
+#include "OpeningBook.h"
+#include "MoveGenerator.h"
+#include "GameRecord.h"
+#include "Zobrist.h"
+#include "Profiler.h"
+#include "Log.h"
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <map>
+#include <algorithm>
+
+static const char BOOK_MAGIC[4] = { 'C', 'G', 'B', 'K' };
+
+uint16_t encodeBookMove(const Move& move) {
+	return (uint16_t)(((move.from.rank * 8 + move.from.file) << 6) | (move.to.rank * 8 + move.to.file));
+}
+
+Cell getBookMoveFrom(uint16_t move) { return Cell((move >> 9) & 7, (move >> 6) & 7); }
+
+Cell getBookMoveTo(uint16_t move) { return Cell((move >> 3) & 7, move & 7); }
+
+/************************************|
+			   BOOK
+|************************************/
+
+OpeningBook& OpeningBook::get() {
+	static OpeningBook book;
+	return book;
+}
+
+bool OpeningBook::open(const string& path) {
+	close();
+
+	if (!file.open(path)) return false;
+
+	OpeningBookHeader header;
+
+	if (file.getSize() < sizeof(header)) {
+		close();
+		return false;
+	}
+
+	memcpy(&header, file.getData(), sizeof(header));
+
+	if (memcmp(header.magic, BOOK_MAGIC, 4) != 0 || header.version != OPENING_BOOK_VERSION ||
+		header.entries > (file.getSize() - sizeof(header)) / sizeof(BookEntry)) {
+		GAME_LOG("Opening book " << path << " is not a valid book" << endl);
+		close();
+		return false;
+	}
+
+	// The map is page aligned and the header is 16 bytes, so the entries can be used in place
+	entries = (const BookEntry*)(file.getData() + sizeof(header));
+	entryCount = (size_t)header.entries;
+
+	GAME_LOG("Loaded opening book " << path << " with " << entryCount << " moves" << endl);
+
+	return true;
+}
+
+void OpeningBook::close() {
+	file.close();
+	entries = nullptr;
+	entryCount = 0;
+}
+
+bool OpeningBook::isOpen() { return entries != nullptr; }
+
+size_t OpeningBook::getEntryCount() { return entryCount; }
+
+vector<BookEntry> OpeningBook::getEntries(uint64_t key) {
+	PROFILE_SCOPE("OpeningBook::getEntries");
+
+	const BookEntry* end = entries + entryCount;
+
+	const BookEntry* first = lower_bound(entries, end, key, [](const BookEntry& entry, uint64_t key) { return entry.key < key; });
+
+	vector<BookEntry> found;
+
+	for (const BookEntry* entry = first; entry != end && entry->key == key; entry++) found.push_back(*entry);
+
+	return found;
+}
+
+/************************************|
+			  BUILDER
+|************************************/
+
+BookBuildOptions parseBookBuildOptions(int argc, char** argv) {
+	BookBuildOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--build-book" && hasValue) {
+			options.outputPath = argv[++i];
+
+			// Every following argument up to the next option is a record
+			while (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) options.recordPaths.push_back(argv[++i]);
+		}
+		else if (argument == "--book-plies" && hasValue) options.maxPlies = atoi(argv[++i]);
+		else if (argument == "--book-min" && hasValue) options.minGames = max(1, atoi(argv[++i]));
+	}
+
+	return options;
+}
+
+struct BookMoveStats {
+	uint64_t score = 0; // 2 for every win and 1 for every draw, from the view of the player making the move
+	int games = 0;
+};
+
+/// <summary>
+/// Moves pieces carried by tiles all at once, since pieces on a conveyor move into cells that are being left at the same time
+/// </summary>
+static void applyTileMoves(MoveGenerator& generator, vector<Move>& tileMoves) {
+	vector<PieceRepr> pieces;
+
+	for (const Move& move : tileMoves) pieces.push_back(generator.getPiece(move.from));
+	for (const Move& move : tileMoves) generator.removePiece(move.from);
+
+	for (size_t i = 0; i < tileMoves.size(); i++) {
+		pieces[i].hasMoved = true;
+		generator.setPiece(tileMoves[i].to, pieces[i]);
+	}
+
+	tileMoves.clear();
+}
+
+/// <summary>
+/// Plays the start of a recorded game on a search position and counts every move it made
+/// </summary>
+static void addGameToBook(const RecordedGame& game, int maxPlies, map<pair<uint64_t, uint16_t>, BookMoveStats>& stats) {
+	if (game.entryCount == 0 || game.ruleset != GAME_RULESET_TILE_CHESS) return;
+
+	RecordEntry last = game.getEntry(game.entryCount - 1);
+
+	if (last.getTag() != RECORD_END || last.getOutcome() == GameOutcome::UNFINISHED) return;
+
+	GameOutcome outcome = last.getOutcome();
+
+	MoveGenerator generator(FEN_START_POSITION);
+	vector<Move> tileMoves;
+	int plies = 0;
+
+	for (size_t i = 0; i < game.entryCount && plies < maxPlies; i++) {
+		RecordEntry entry = game.getEntry(i);
+
+		switch (entry.getTag()) {
+			case RECORD_MOVE: {
+				applyTileMoves(generator, tileMoves);
+
+				Move recordedMove = entry.getMove();
+				int player = generator.getCurrentPlayer();
+
+				// The record doesn't have flags, so use the legal move with them
+				vector<Move> legalMoves = generator.getAllLegalMoves(player);
+
+				auto legalMove = find_if(legalMoves.begin(), legalMoves.end(), [&](const Move& move) {
+					return move.from == recordedMove.from && move.to == recordedMove.to;
+				});
+
+				if (legalMove == legalMoves.end()) return; // The game went somewhere the search can't follow
+
+				bool won = (outcome == GameOutcome::PLAYER_1_WIN && player == 1) || (outcome == GameOutcome::PLAYER_2_WIN && player == 2);
+				bool drew = outcome == GameOutcome::STALEMATE || outcome == GameOutcome::PLY_LIMIT;
+
+				BookMoveStats& moveStats = stats[{ generator.getZobristKey(), encodeBookMove(*legalMove) }];
+				moveStats.score += won ? 2 : (drew ? 1 : 0);
+				moveStats.games++;
+
+				generator.makeMove(*legalMove);
+				plies++;
+				break;
+			}
+
+			case RECORD_TILE_MOVE:
+				tileMoves.push_back(entry.getMove());
+				break;
+
+			case RECORD_PROMOTION: {
+				applyTileMoves(generator, tileMoves);
+
+				Cell cell = entry.getPromotionCell();
+				generator.setPiece(cell, { entry.getPromotionType(), generator.getPiece(cell).player, true });
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+}
+
+int buildOpeningBook(const BookBuildOptions& options) {
+	if (options.recordPaths.empty()) {
+		cerr << "No game records to build the book from, use --build-book output records..." << endl;
+		return 1;
+	}
+
+	map<pair<uint64_t, uint16_t>, BookMoveStats> stats; // Sorted by key, so it can be written straight out
+	int gameCount = 0;
+
+	// The search logs every position it's created with
+	silenceGameLog();
+
+	for (const string& path : options.recordPaths) {
+		GameRecordReader reader;
+
+		if (!reader.open(path)) {
+			cerr << "Unable to open game record: " << path << endl;
+			continue;
+		}
+
+		for (size_t i = 0; i < reader.getGameCount(); i++) {
+			addGameToBook(reader.getGame(i), options.maxPlies, stats);
+			gameCount++;
+		}
+	}
+
+	vector<BookEntry> entries;
+	auto position = stats.begin();
+
+	// Go through one position at a time, scaling the weights so its best move fits in 16 bits
+	while (position != stats.end()) {
+		auto positionEnd = position;
+		uint64_t best = 0;
+
+		for (; positionEnd != stats.end() && positionEnd->first.first == position->first.first; positionEnd++) {
+			if (positionEnd->second.games >= options.minGames) best = max(best, positionEnd->second.score);
+		}
+
+		size_t positionStart = entries.size();
+
+		for (; position != positionEnd; position++) {
+			const BookMoveStats& moveStats = position->second;
+
+			if (moveStats.games < options.minGames || moveStats.score == 0) continue;
+
+			uint16_t weight = (uint16_t)max<uint64_t>(1, moveStats.score * min<uint64_t>(best, 65535) / best);
+
+			entries.push_back({ position->first.first, position->first.second, weight, 0 });
+		}
+
+		// Best moves first
+		sort(entries.begin() + positionStart, entries.end(), [](const BookEntry& a, const BookEntry& b) { return a.weight > b.weight; });
+	}
+
+	FILE* file = fopen(options.outputPath.c_str(), "wb");
+
+	if (!file) {
+		cerr << "Unable to create opening book: " << options.outputPath << endl;
+		return 1;
+	}
+
+	OpeningBookHeader header;
+	memcpy(header.magic, BOOK_MAGIC, 4);
+	header.version = OPENING_BOOK_VERSION;
+	header.entries = entries.size();
+
+	fwrite(&header, sizeof(header), 1, file);
+	if (!entries.empty()) fwrite(entries.data(), sizeof(BookEntry), entries.size(), file);
+	fclose(file);
+
+	cout << "Built opening book " << options.outputPath << " from " << gameCount << " games: " << entries.size() << " moves" << endl;
+
+	return 0;
+}
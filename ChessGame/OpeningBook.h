@@ -0,0 +1,104 @@
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MemoryMappedFile.h"
+#include "Move.h"
+
+using namespace std;
+
+/*
+	Book files are laid out like Polyglot books, but with our own Zobrist keys and in little endian:
+
+		OpeningBookHeader           16 bytes
+		BookEntry...                16 bytes each, sorted by key and then by weight (highest first)
+
+	A move is packed like in Polyglot: bits 0 - 5 are the cell it goes to (rank * 8 + file), bits 6 - 11 the cell it comes from,
+	and bits 12 - 14 the piece a pawn promotes to (0 for none).
+*/
+
+#define OPENING_BOOK_VERSION 1
+
+#define OPENING_BOOK_PATH "resources/book.bin"
+
+struct BookEntry {
+	uint64_t key;
+	uint16_t move;
+	uint16_t weight; // How often the move was played, weighted by how well it went
+	uint32_t learn;  // Unused, kept so entries line up with Polyglot
+};
+
+struct OpeningBookHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t entries;
+};
+
+static_assert(sizeof(BookEntry) == 16, "BookEntry has to match the file layout");
+static_assert(sizeof(OpeningBookHeader) == 16, "OpeningBookHeader has to match the file layout");
+
+uint16_t encodeBookMove(const Move& move);
+
+Cell getBookMoveFrom(uint16_t move);
+
+Cell getBookMoveTo(uint16_t move);
+
+/// <summary>
+/// Known good moves for positions the AI has seen before, looked up straight from a mapped file so no search is needed
+/// </summary>
+class OpeningBook {
+	private:
+		MemoryMappedFile file;
+
+		const BookEntry* entries = nullptr;
+		size_t entryCount = 0;
+
+		OpeningBook() = default;
+
+	public:
+		static OpeningBook& get();
+
+		OpeningBook(const OpeningBook&) = delete;
+		OpeningBook& operator=(const OpeningBook&) = delete;
+
+		/// <summary>
+		/// Maps a book file, replacing the book that was open
+		/// </summary>
+		/// <returns>true if the book was opened, false if the file doesn't exist or isn't a book</returns>
+		bool open(const string& path);
+
+		void close();
+
+		bool isOpen();
+
+		size_t getEntryCount();
+
+		/// <summary>
+		/// Gets every book move of a position, by binary searching the book
+		/// </summary>
+		/// <param name="key">The Zobrist key of the position</param>
+		/// <returns>The entries of the position, best first, empty if the position isn't in the book</returns>
+		vector<BookEntry> getEntries(uint64_t key);
+};
+
+struct BookBuildOptions {
+	string outputPath = OPENING_BOOK_PATH;
+	vector<string> recordPaths; // Game records to build the book from
+	int maxPlies = 12;          // Only the first plies of every game are added
+	int minGames = 2;           // Moves played fewer times than this are left out
+};
+
+/// <summary>
+/// Reads the options of the --build-book mode: --build-book output records... [--book-plies n] [--book-min n]
+/// </summary>
+BookBuildOptions parseBookBuildOptions(int argc, char** argv);
+
+/// <summary>
+/// Builds an opening book from the opening moves of recorded games
+/// </summary>
+/// <returns>The exit code of the program</returns>
+int buildOpeningBook(const BookBuildOptions& options);
+
+#endif
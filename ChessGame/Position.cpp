@@ -0,0 +1,498 @@
+#include "Position.h"
+#include <sstream>
+#include <vector>
+#include <stdexcept>
+#include <cctype>
+
+/************************************|
+			  HELPERS
+|************************************/
+
+static vector<string> splitFields(const string& text) {
+	vector<string> fields;
+	istringstream stream(text);
+	string field;
+
+	while (stream >> field) fields.push_back(field);
+
+	return fields;
+}
+
+static int parseNumber(const string& text, const string& what) {
+	try {
+		size_t length;
+		int number = stoi(text, &length);
+
+		if (length == text.size()) return number;
+	} catch (const exception&) {}
+
+	throw runtime_error("Invalid " + what + ": " + text);
+}
+
+static optional<Cell> parseSquare(const string& square) {
+	if (square.size() != 2) return nullopt;
+
+	Cell cell(square[1] - '1', square[0] - 'a');
+
+	if (!cell.isInBounds()) return nullopt;
+
+	return cell;
+}
+
+static char getPieceChar(const PositionPiece& piece) {
+	return getPieceString(piece.type, piece.player)[0];
+}
+
+static PositionPiece getPieceFromChar(char c) {
+	PositionPiece piece;
+	piece.player = isupper(c) ? 1 : 2;
+
+	switch (tolower(c)) {
+		case 'p': piece.type = PieceType::PAWN; break;
+		case 'n': piece.type = PieceType::KNIGHT; break;
+		case 'b': piece.type = PieceType::BISHOP; break;
+		case 'r': piece.type = PieceType::ROOK; break;
+		case 'q': piece.type = PieceType::QUEEN; break;
+		case 'k': piece.type = PieceType::KING; break;
+		default: throw runtime_error(string("Invalid piece in FEN: ") + c);
+	}
+
+	return piece;
+}
+
+static char getDirectionChar(Direction direction) {
+	switch (direction) {
+		case UP:   return '^';
+		case DOWN: return 'v';
+		case LEFT: return '<';
+		default:   return '>';
+	}
+}
+
+static Direction getDirectionFromChar(char c) {
+	switch (c) {
+		case '^': return UP;
+		case 'v': return DOWN;
+		case '<': return LEFT;
+		case '>': return RIGHT;
+		default: throw runtime_error(string("Invalid conveyor direction in FEN: ") + c);
+	}
+}
+
+/// <summary>
+/// Goes through the 8 ranks of a placement field (pieces or tiles), calling readToken for everything that isn't a run of empty cells
+/// </summary>
+/// <param name="field">The field to read</param>
+/// <param name="readToken">Reads the token at a position in the field into a cell and returns the position after it</param>
+template<typename ReadToken>
+static void parsePlacement(const string& field, ReadToken readToken) {
+	int rank = 7;
+	int file = 0;
+	size_t i = 0;
+
+	while (i < field.size()) {
+		char c = field[i];
+
+		if (c == '/') {
+			if (file != 8 || rank == 0) throw runtime_error("Invalid rank in FEN: " + field);
+
+			rank--;
+			file = 0;
+			i++;
+		} else if (isdigit(c)) {
+			file += c - '0';
+			i++;
+		} else {
+			if (file > 7) throw runtime_error("Too many files in FEN: " + field);
+
+			i = readToken(field, i, Cell(rank, file));
+			file++;
+		}
+
+		if (file > 8) throw runtime_error("Too many files in FEN: " + field);
+	}
+
+	if (rank != 0 || file != 8) throw runtime_error("FEN doesn't cover the whole board: " + field);
+}
+
+/************************************|
+			   FIELDS
+|************************************/
+
+static void parsePieces(Position& position, const string& field) {
+	parsePlacement(field, [&](const string& field, size_t i, Cell cell) {
+		position.pieces[cell.rank][cell.file] = getPieceFromChar(field[i]);
+		return i + 1;
+	});
+}
+
+static string writePieces(const Position& position) {
+	string field;
+
+	for (int rank = 7; rank >= 0; rank--) {
+		int empty = 0;
+
+		for (int file = 0; file < 8; file++) {
+			const PositionPiece& piece = position.pieces[rank][file];
+
+			if (piece.type == PieceType::NO_PIECE) {
+				empty++;
+				continue;
+			}
+
+			if (empty > 0) field += to_string(empty);
+			empty = 0;
+
+			field += getPieceChar(piece);
+		}
+
+		if (empty > 0) field += to_string(empty);
+		if (rank > 0) field += '/';
+	}
+
+	return field;
+}
+
+static void parseTiles(Position& position, const string& field) {
+	parsePlacement(field, [&](const string& field, size_t i, Cell cell) {
+		PositionTile& tile = position.tiles[cell.rank][cell.file];
+
+		char kind = field[i++];
+
+		// Settings in braces after the letter
+		vector<string> settings;
+
+		if (i < field.size() && field[i] == '{') {
+			size_t end = field.find('}', i);
+
+			if (end == string::npos) throw runtime_error("Unclosed tile settings in FEN: " + field);
+
+			stringstream stream(field.substr(i + 1, end - i - 1));
+			string setting;
+
+			while (getline(stream, setting, ',')) settings.push_back(setting);
+
+			i = end + 1;
+		}
+
+		auto getLifetime = [&](size_t index, int defaultLifetime) {
+			return settings.size() > index ? parseNumber(settings[index], "tile lifetime") : defaultLifetime;
+		};
+
+		switch (kind) {
+			case 'I':
+				tile.kind = TileKind::ICE;
+				tile.lifetime = getLifetime(0, -1);
+				break;
+			case 'B':
+				tile.kind = TileKind::BREAKING;
+				tile.lifetime = getLifetime(0, 6);
+				break;
+			case 'C':
+				if (settings.empty() || settings[0].size() != 1) throw runtime_error("Conveyor without a direction in FEN: " + field);
+
+				tile.kind = TileKind::CONVEYOR;
+				tile.direction = getDirectionFromChar(settings[0][0]);
+				tile.lifetime = getLifetime(1, 10);
+				break;
+			case 'P':
+				if (settings.empty()) throw runtime_error("Portal without a number in FEN: " + field);
+
+				tile.kind = TileKind::PORTAL;
+				tile.portalNumber = parseNumber(settings[0], "portal number");
+				tile.lifetime = getLifetime(1, 10);
+				break;
+			default:
+				throw runtime_error(string("Invalid tile in FEN: ") + kind);
+		}
+
+		return i;
+	});
+}
+
+static string writeTiles(const Position& position) {
+	string field;
+
+	for (int rank = 7; rank >= 0; rank--) {
+		int basic = 0;
+
+		for (int file = 0; file < 8; file++) {
+			const PositionTile& tile = position.tiles[rank][file];
+
+			if (tile.kind == TileKind::BASIC) {
+				basic++;
+				continue;
+			}
+
+			if (basic > 0) field += to_string(basic);
+			basic = 0;
+
+			// Lifetimes are only written when they aren't the lifetime the tile spawns with
+			switch (tile.kind) {
+				case TileKind::ICE:
+					field += "I";
+					if (tile.lifetime != -1) field += "{" + to_string(tile.lifetime) + "}";
+					break;
+				case TileKind::BREAKING:
+					field += "B";
+					if (tile.lifetime != 6) field += "{" + to_string(tile.lifetime) + "}";
+					break;
+				case TileKind::CONVEYOR:
+					field += string("C{") + getDirectionChar(tile.direction);
+					if (tile.lifetime != 10) field += "," + to_string(tile.lifetime);
+					field += "}";
+					break;
+				case TileKind::PORTAL:
+					field += "P{" + to_string(tile.portalNumber);
+					if (tile.lifetime != 10) field += "," + to_string(tile.lifetime);
+					field += "}";
+					break;
+				default:
+					break;
+			}
+		}
+
+		if (basic > 0) field += to_string(basic);
+		if (rank > 0) field += '/';
+	}
+
+	return field;
+}
+
+static void parseFrozen(Position& position, const string& field) {
+	if (field == "-") return;
+
+	stringstream stream(field);
+	string entry;
+
+	while (getline(stream, entry, ',')) {
+		size_t separator = entry.find('=');
+		optional<Cell> cell = parseSquare(entry.substr(0, separator));
+
+		if (separator == string::npos || !cell) throw runtime_error("Invalid frozen piece in FEN: " + entry);
+
+		PositionPiece& piece = position.pieces[cell->rank][cell->file];
+
+		if (piece.type == PieceType::NO_PIECE) throw runtime_error("Frozen piece on an empty cell in FEN: " + entry);
+
+		piece.frozen = parseNumber(entry.substr(separator + 1), "frozen turns");
+	}
+}
+
+static string writeFrozen(const Position& position) {
+	string field;
+
+	for (int rank = 0; rank < 8; rank++) {
+		for (int file = 0; file < 8; file++) {
+			const PositionPiece& piece = position.pieces[rank][file];
+
+			if (piece.type == PieceType::NO_PIECE || piece.frozen <= 0) continue;
+
+			if (!field.empty()) field += ",";
+
+			field += Cell(rank, file).getAlgebraicNotation() + "=" + to_string(piece.frozen);
+		}
+	}
+
+	return field.empty() ? "-" : field;
+}
+
+/// <summary>
+/// Reads the 4 fields FEN and EPD have in common
+/// </summary>
+static void parseBaseFields(Position& position, const vector<string>& fields) {
+	if (fields.size() < 4) throw runtime_error("FEN needs at least 4 fields");
+
+	parsePieces(position, fields[0]);
+
+	if (fields[1] == "w") position.sideToMove = 1;
+	else if (fields[1] == "b") position.sideToMove = 2;
+	else throw runtime_error("Invalid side to move in FEN: " + fields[1]);
+
+	if (fields[2] != "-") {
+		for (char c : fields[2]) {
+			switch (c) {
+				case 'K': position.castling[CASTLE_WHITE_KING] = true; break;
+				case 'Q': position.castling[CASTLE_WHITE_QUEEN] = true; break;
+				case 'k': position.castling[CASTLE_BLACK_KING] = true; break;
+				case 'q': position.castling[CASTLE_BLACK_QUEEN] = true; break;
+				default: throw runtime_error("Invalid castling rights in FEN: " + fields[2]);
+			}
+		}
+	}
+
+	if (fields[3] != "-") {
+		optional<Cell> square = parseSquare(fields[3]);
+
+		if (!square) throw runtime_error("Invalid en passant square in FEN: " + fields[3]);
+
+		// The pawn is one cell past the square it skipped, from the side that just moved
+		position.enPassantableCell = Cell(square->rank + (position.sideToMove == 2 ? 1 : -1), square->file);
+	}
+}
+
+static string writeBaseFields(const Position& position) {
+	string fen = writePieces(position);
+
+	fen += position.sideToMove == 1 ? " w " : " b ";
+
+	string castling;
+	if (position.castling[CASTLE_WHITE_KING])  castling += "K";
+	if (position.castling[CASTLE_WHITE_QUEEN]) castling += "Q";
+	if (position.castling[CASTLE_BLACK_KING])  castling += "k";
+	if (position.castling[CASTLE_BLACK_QUEEN]) castling += "q";
+
+	fen += castling.empty() ? "-" : castling;
+	fen += " ";
+
+	if (position.enPassantableCell) {
+		Cell pawn = position.enPassantableCell.value();
+		fen += Cell(pawn.rank + (position.sideToMove == 2 ? -1 : 1), pawn.file).getAlgebraicNotation();
+	} else {
+		fen += "-";
+	}
+
+	return fen;
+}
+
+/************************************|
+			  POSITION
+|************************************/
+
+void Position::updateHasMoved() {
+	static const PieceType backRank[8] = {
+		PieceType::ROOK, PieceType::KNIGHT, PieceType::BISHOP, PieceType::QUEEN,
+		PieceType::KING, PieceType::BISHOP, PieceType::KNIGHT, PieceType::ROOK
+	};
+
+	for (int rank = 0; rank < 8; rank++) {
+		for (int file = 0; file < 8; file++) {
+			PositionPiece& piece = pieces[rank][file];
+
+			if (piece.type == PieceType::NO_PIECE) continue;
+
+			int homeRank = piece.player == 1 ? 0 : 7;
+			int castleOffset = piece.player == 1 ? 0 : 2;
+
+			switch (piece.type) {
+				case PieceType::PAWN:
+					piece.hasMoved = rank != (piece.player == 1 ? 1 : 6);
+					break;
+				case PieceType::KING:
+					// Only a king that can still castle counts as unmoved
+					piece.hasMoved = !(rank == homeRank && file == 4 && (castling[castleOffset] || castling[castleOffset + 1]));
+					break;
+				case PieceType::ROOK:
+					piece.hasMoved = !(rank == homeRank && ((file == 7 && castling[castleOffset]) || (file == 0 && castling[castleOffset + 1])));
+					break;
+				default:
+					piece.hasMoved = !(rank == homeRank && backRank[file] == piece.type);
+					break;
+			}
+		}
+	}
+}
+
+Position parseFEN(const string& fen) {
+	Position position;
+	vector<string> fields = splitFields(fen);
+
+	parseBaseFields(position, fields);
+
+	if (fields.size() > 4) position.halfmoveClock = parseNumber(fields[4], "halfmove clock");
+	if (fields.size() > 5) position.fullmoveNumber = parseNumber(fields[5], "fullmove number");
+	if (fields.size() > 6) parseTiles(position, fields[6]);
+	if (fields.size() > 7) parseFrozen(position, fields[7]);
+
+	position.updateHasMoved();
+
+	return position;
+}
+
+string writeFEN(const Position& position, bool includeTiles) {
+	string fen = writeBaseFields(position) + " " + to_string(position.halfmoveClock) + " " + to_string(position.fullmoveNumber);
+
+	if (includeTiles) fen += " " + writeTiles(position) + " " + writeFrozen(position);
+
+	return fen;
+}
+
+Position parseEPD(const string& epd) {
+	Position position;
+	vector<string> fields = splitFields(epd);
+
+	parseBaseFields(position, fields);
+
+	// Everything after the 4th field is operations, found again in the original string since operands can have spaces
+	size_t start = 0;
+
+	for (int field = 0; field < 4; field++) {
+		start = epd.find_first_not_of(" \t", start);
+		start = epd.find_first_of(" \t", start);
+	}
+
+	string operation;
+	bool quoted = false;
+
+	auto addOperation = [&]() {
+		size_t begin = operation.find_first_not_of(" \t");
+
+		if (begin == string::npos) return;
+
+		size_t end = operation.find_last_not_of(" \t");
+		size_t split = operation.find_first_of(" \t", begin);
+
+		string opcode = operation.substr(begin, split == string::npos || split > end ? end - begin + 1 : split - begin);
+		string operand = "";
+
+		if (split != string::npos && split < end) {
+			size_t operandStart = operation.find_first_not_of(" \t", split);
+			operand = operation.substr(operandStart, end - operandStart + 1);
+		}
+
+		if (opcode == "hmvc") position.halfmoveClock = parseNumber(operand, "halfmove clock");
+		else if (opcode == "fmvn") position.fullmoveNumber = parseNumber(operand, "fullmove number");
+		else if (opcode == "tiles") parseTiles(position, operand);
+		else if (opcode == "frozen") parseFrozen(position, operand);
+		else position.operations[opcode] = operand;
+	};
+
+	if (start != string::npos) {
+		for (size_t i = start; i < epd.size(); i++) {
+			char c = epd[i];
+
+			if (c == '"') quoted = !quoted;
+
+			if (c == ';' && !quoted) {
+				addOperation();
+				operation.clear();
+			} else {
+				operation += c;
+			}
+		}
+
+		addOperation();
+	}
+
+	position.updateHasMoved();
+
+	return position;
+}
+
+string writeEPD(const Position& position, bool includeTiles) {
+	string epd = writeBaseFields(position);
+
+	if (includeTiles) {
+		string tiles = writeTiles(position);
+		string frozen = writeFrozen(position);
+
+		if (tiles != "8/8/8/8/8/8/8/8") epd += " tiles " + tiles + ";";
+		if (frozen != "-") epd += " frozen " + frozen + ";";
+	}
+
+	for (const auto& [opcode, operand] : position.operations) {
+		epd += " " + opcode + (operand.empty() ? "" : " " + operand) + ";";
+	}
+
+	return epd;
+}
@@ -0,0 +1,128 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <string>
+#include <map>
+#include <optional>
+#include "PieceType.h"
+#include "Cell.h"
+#include "customtiles.h"
+
+using namespace std;
+
+/*
+	Positions are written as FEN with two extra fields for the tiles:
+
+		<pieces> <side> <castling> <en passant> <halfmove clock> <fullmove number> [<tiles> [<frozen pieces>]]
+
+	The tile field is laid out like the piece field, ranks 8 to 1 separated by '/', with digits for runs of basic tiles.
+	Special tiles are a letter, followed by their settings in braces when they aren't the default:
+
+		I{lifetime}                  Ice
+		B{lifetime}                  Breaking tile, B{6} when it was just spawned
+		C{direction,lifetime}        Conveyor, direction is one of ^ v < > (up, down, left, right)
+		P{number,lifetime}           Portal, portals with the same number are linked
+
+	The frozen field lists frozen pieces and the turns they stay frozen for, e.g. "e4=3,d5=6", or "-" if there are none.
+	Standard 6 field FENs load onto a board of basic tiles.
+
+	EPD is the first 4 fields followed by operations ("bm e4; id \"test 1\";"), the tiles and frozen pieces are
+	the operations "tiles" and "frozen".
+*/
+
+#define FEN_START_POSITION "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+enum class TileKind {
+	BASIC,
+	ICE,
+	BREAKING,
+	CONVEYOR,
+	PORTAL
+};
+
+struct PositionPiece {
+	PieceType type = PieceType::NO_PIECE;
+	int player = -1;
+
+	bool hasMoved = false;
+
+	int frozen = 0; // Turns the piece stays frozen for
+};
+
+struct PositionTile {
+	TileKind kind = TileKind::BASIC;
+
+	int lifetime = -1;
+
+	Direction direction = RIGHT; // Conveyors only
+	int portalNumber = 0;        // Portals only
+};
+
+// Indices of Position::castling
+#define CASTLE_WHITE_KING 0
+#define CASTLE_WHITE_QUEEN 1
+#define CASTLE_BLACK_KING 2
+#define CASTLE_BLACK_QUEEN 3
+
+/// <summary>
+/// Everything about a position that can be written as FEN, independent of the board or the search
+/// </summary>
+struct Position {
+	PositionPiece pieces[8][8]; // [rank][file]
+	PositionTile tiles[8][8];
+
+	int sideToMove = 1;
+
+	bool castling[4] = { false, false, false, false };
+
+	/// <summary>
+	/// The cell of a pawn that can be captured en passant (not the cell behind it like in FEN)
+	/// </summary>
+	optional<Cell> enPassantableCell;
+
+	int halfmoveClock = 0;
+	int fullmoveNumber = 1;
+
+	/// <summary>
+	/// Operations of an EPD, like "bm" or "id", with their operands
+	/// </summary>
+	map<string, string> operations;
+
+	/// <summary>
+	/// Gets the ply of the position, 0 being white's first move
+	/// </summary>
+	int getPly() const { return (fullmoveNumber - 1) * 2 + (sideToMove == 2 ? 1 : 0); }
+
+	/// <summary>
+	/// Works out which pieces have moved from where they are and the castling rights, since FEN doesn't store it
+	/// </summary>
+	void updateHasMoved();
+};
+
+/// <summary>
+/// Reads a FEN, with or without the tile fields
+/// </summary>
+/// <param name="fen">The FEN to read</param>
+/// <returns>The position, throws a runtime_error if the FEN is malformed</returns>
+Position parseFEN(const string& fen);
+
+/// <summary>
+/// Writes a position as FEN
+/// </summary>
+/// <param name="position">The position to write</param>
+/// <param name="includeTiles">Adds the tile and frozen fields, leave out for FEN other programs can read</param>
+string writeFEN(const Position& position, bool includeTiles = true);
+
+/// <summary>
+/// Reads an EPD line, the operations are kept in the position
+/// </summary>
+/// <param name="epd">The EPD to read</param>
+/// <returns>The position, throws a runtime_error if the EPD is malformed</returns>
+Position parseEPD(const string& epd);
+
+/// <summary>
+/// Writes a position as EPD with its operations
+/// </summary>
+string writeEPD(const Position& position, bool includeTiles = true);
+
+#endif
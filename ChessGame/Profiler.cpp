@@ -0,0 +1,259 @@
+#include "Profiler.h"
+#include "raylib.h"
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+/************************************|
+		 ALLOCATION COUNTING
+|************************************/
+
+atomic<bool> Profiler::enabled{ true };
+atomic<uint64_t> Profiler::allocationCount{ 0 };
+atomic<uint64_t> Profiler::allocationBytes{ 0 };
+
+// Replacing the global allocator is the only way to see allocations made inside the standard library
+void* operator new(size_t size) {
+	if (Profiler::enabled.load(memory_order_relaxed)) {
+		Profiler::allocationCount.fetch_add(1, memory_order_relaxed);
+		Profiler::allocationBytes.fetch_add(size, memory_order_relaxed);
+	}
+
+	if (void* pointer = malloc(size == 0 ? 1 : size)) return pointer;
+
+	throw bad_alloc();
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+	if (Profiler::enabled.load(memory_order_relaxed)) {
+		Profiler::allocationCount.fetch_add(1, memory_order_relaxed);
+		Profiler::allocationBytes.fetch_add(size, memory_order_relaxed);
+	}
+
+	return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { free(pointer); }
+void operator delete(void* pointer, const nothrow_t&) noexcept { free(pointer); }
+
+/************************************|
+			  PROFILER
+|************************************/
+
+Profiler& Profiler::get() {
+	static Profiler profiler;
+	return profiler;
+}
+
+int64_t Profiler::now() const {
+	return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+uint32_t Profiler::threadIndex() {
+	static atomic<uint32_t> nextIndex{ 0 };
+	thread_local uint32_t index = nextIndex.fetch_add(1);
+	return index;
+}
+
+ProfileFrame& Profiler::getFrame(int age) {
+	return frames[(currentFrame - age + PROFILER_HISTORY) % PROFILER_HISTORY];
+}
+
+void Profiler::beginFrame() {
+	lock_guard<mutex> lock(eventMutex);
+
+	currentFrame = (currentFrame + 1) % PROFILER_HISTORY;
+
+	ProfileFrame& frame = frames[currentFrame];
+	frame.start = now();
+	frame.duration = 0;
+	frame.events.clear(); // Keeps its capacity, so recording doesn't allocate once warmed up
+	frame.allocations = 0;
+	frame.allocatedBytes = 0;
+	frame.spriteCount = 0;
+
+	frameStartAllocations = allocationCount.load(memory_order_relaxed);
+	frameStartAllocatedBytes = allocationBytes.load(memory_order_relaxed);
+}
+
+void Profiler::endFrame() {
+	lock_guard<mutex> lock(eventMutex);
+
+	ProfileFrame& frame = frames[currentFrame];
+	frame.duration = now() - frame.start;
+	frame.allocations = allocationCount.load(memory_order_relaxed) - frameStartAllocations;
+	frame.allocatedBytes = allocationBytes.load(memory_order_relaxed) - frameStartAllocatedBytes;
+
+	if (recordedFrames < PROFILER_HISTORY) recordedFrames++;
+}
+
+void Profiler::recordEvent(const ProfileEvent& event) {
+	lock_guard<mutex> lock(eventMutex);
+
+	frames[currentFrame].events.push_back(event);
+}
+
+void Profiler::setSpriteCount(int count) {
+	frames[currentFrame].spriteCount = count;
+}
+
+void Profiler::handleInput() {
+	if (IsKeyPressed(KEY_F3)) toggleOverlay();
+
+	if (IsKeyPressed(KEY_F4)) {
+		if (exportChromeTrace("trace.json")) {
+			cout << "Wrote profiler trace to trace.json" << endl;
+		} else {
+			cout << "Failed to write profiler trace!" << endl;
+		}
+	}
+}
+
+void Profiler::toggleOverlay() { overlayVisible = !overlayVisible; }
+
+bool Profiler::isOverlayVisible() const { return overlayVisible; }
+
+void Profiler::setEnabled(bool enable) { enabled.store(enable); }
+
+void Profiler::drawOverlay(int x, int y) {
+	if (!overlayVisible) return;
+
+	lock_guard<mutex> lock(eventMutex);
+
+	const int graphHeight = 60;
+	const float msToPixels = graphHeight / 33.3f; // Graph tops out at two frames of 60 fps
+
+	int width = PROFILER_HISTORY + 20;
+
+	// Only finished frames are shown, the one being recorded is incomplete
+	int shownFrames = min(recordedFrames, PROFILER_HISTORY - 1);
+
+	// Sum the time spent in each scope for the last frame and over the history
+	struct ScopeTotal {
+		const char* name;
+		int64_t lastFrame = 0;
+		int64_t history = 0;
+	};
+
+	ScopeTotal totals[32];
+	int totalCount = 0;
+
+	int64_t totalFrameTime = 0;
+
+	for (int age = 1; age <= shownFrames; age++) {
+		ProfileFrame& frame = getFrame(age);
+		totalFrameTime += frame.duration;
+
+		for (const ProfileEvent& event : frame.events) {
+			int index = 0;
+			while (index < totalCount && strcmp(totals[index].name, event.name) != 0) index++;
+
+			if (index == totalCount) {
+				if (totalCount == 32) continue;
+				totals[totalCount++] = { event.name };
+			}
+
+			totals[index].history += event.duration;
+			if (age == 1) totals[index].lastFrame += event.duration;
+		}
+	}
+
+	int height = graphHeight + 70 + totalCount * 12;
+
+	DrawRectangle(x, y, width, height, Fade(BLACK, 0.7f));
+
+	// Frame graph, newest frame on the right
+	int graphBottom = y + 10 + graphHeight;
+
+	for (int age = 1; age <= shownFrames; age++) {
+		ProfileFrame& frame = getFrame(age);
+
+		float milliseconds = frame.duration / 1000.0f;
+		int barHeight = min((int)(milliseconds * msToPixels), graphHeight);
+
+		Color barColor = milliseconds > 33.3f ? RED : (milliseconds > 16.7f ? YELLOW : GREEN);
+
+		DrawRectangle(x + 10 + PROFILER_HISTORY - age, graphBottom - barHeight, 1, barHeight, barColor);
+	}
+
+	DrawLine(x + 10, graphBottom - (int)(16.7f * msToPixels), x + 10 + PROFILER_HISTORY, graphBottom - (int)(16.7f * msToPixels), Fade(WHITE, 0.5f));
+
+	if (shownFrames == 0) return;
+
+	ProfileFrame& lastFrame = getFrame(1);
+
+	int textY = graphBottom + 6;
+
+	DrawText(TextFormat("Frame: %.2f ms (avg %.2f ms)", lastFrame.duration / 1000.0f, totalFrameTime / 1000.0f / shownFrames), x + 10, textY, 10, WHITE);
+	textY += 12;
+
+	DrawText(TextFormat("Sprites: %i", lastFrame.spriteCount), x + 10, textY, 10, WHITE);
+	textY += 12;
+
+	DrawText(TextFormat("Allocations: %i (%.1f KB)", (int)lastFrame.allocations, lastFrame.allocatedBytes / 1024.0f), x + 10, textY, 10, WHITE);
+	textY += 18;
+
+	for (int i = 0; i < totalCount; i++) {
+		DrawText(TextFormat("%s: %.2f ms (avg %.2f ms)", totals[i].name, totals[i].lastFrame / 1000.0f, totals[i].history / 1000.0f / shownFrames), x + 10, textY, 10, LIGHTGRAY);
+		textY += 12;
+	}
+}
+
+bool Profiler::exportChromeTrace(const string& path) {
+	ofstream file(path);
+
+	if (!file.is_open()) return false;
+
+	lock_guard<mutex> lock(eventMutex);
+
+	file << "{\"traceEvents\":[" << endl;
+
+	bool first = true;
+
+	auto writeEvent = [&](const char* name, int64_t start, int64_t duration, uint32_t thread) {
+		if (!first) file << "," << endl;
+		first = false;
+
+		file << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread << ",\"ts\":" << start << ",\"dur\":" << duration << "}";
+	};
+
+	// Oldest frame first
+	for (int age = min(recordedFrames, PROFILER_HISTORY - 1); age >= 1; age--) {
+		ProfileFrame& frame = getFrame(age);
+
+		writeEvent("Frame", frame.start, frame.duration, 0);
+
+		for (const ProfileEvent& event : frame.events) {
+			writeEvent(event.name, event.start, event.duration, event.thread);
+		}
+	}
+
+	file << endl << "],\"displayTimeUnit\":\"ms\"}" << endl;
+
+	return file.good();
+}
+
+/************************************|
+			PROFILE SCOPE
+|************************************/
+
+thread_local int ProfileScope::currentDepth = 0;
+
+ProfileScope::ProfileScope(const char* name) : name(name), start(0), depth(0), active(Profiler::enabled.load(memory_order_relaxed)) {
+	if (!active) return;
+
+	start = Profiler::get().now();
+	depth = currentDepth++;
+}
+
+ProfileScope::~ProfileScope() {
+	if (!active) return;
+
+	currentDepth--;
+
+	Profiler& profiler = Profiler::get();
+	profiler.recordEvent({ name, start, profiler.now() - start, Profiler::threadIndex(), depth });
+}
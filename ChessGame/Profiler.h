@@ -0,0 +1,158 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+#define PROFILER_HISTORY 240 // Number of frames kept in the history
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+/// <summary>
+/// Times the rest of the enclosing scope under the given name
+/// </summary>
+#define PROFILE_SCOPE(name) ProfileScope PROFILER_CONCAT(profileScope, __LINE__)(name)
+
+struct ProfileEvent {
+	const char* name; // Name of the scope, has to be a string literal
+	int64_t start;    // Microseconds since the profiler started
+	int64_t duration; // Microseconds
+	uint32_t thread;  // Index of the thread the scope ran on
+	int depth;        // Nesting depth on its thread
+};
+
+struct ProfileFrame {
+	int64_t start = 0;
+	int64_t duration = 0;
+
+	vector<ProfileEvent> events;
+
+	uint64_t allocations = 0;    // Number of allocations made during the frame
+	uint64_t allocatedBytes = 0; // Bytes allocated during the frame
+
+	int spriteCount = 0;
+};
+
+class Profiler {
+	private:
+		chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+		array<ProfileFrame, PROFILER_HISTORY> frames;
+		int currentFrame = 0;
+		int recordedFrames = 0;
+
+		mutex eventMutex; // Scopes can end on other threads (AI search)
+
+		uint64_t frameStartAllocations = 0;
+		uint64_t frameStartAllocatedBytes = 0;
+
+		bool overlayVisible = false;
+
+		Profiler() = default;
+
+		/// <summary>
+		/// Gets a frame relative to the current one
+		/// </summary>
+		/// <param name="age">0 is the frame being recorded, 1 the last finished frame, etc.</param>
+		ProfileFrame& getFrame(int age);
+
+	public:
+		static atomic<bool> enabled; // Read by every scope and allocation, so it is kept outside of the instance
+		static atomic<uint64_t> allocationCount;
+		static atomic<uint64_t> allocationBytes;
+
+		/// <summary>
+		/// Gets the profiler instance
+		/// </summary>
+		static Profiler& get();
+
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		/// <summary>
+		/// Gets the time since the profiler started
+		/// </summary>
+		/// <returns>The time in microseconds</returns>
+		int64_t now() const;
+
+		/// <summary>
+		/// Gets a small index for the calling thread, used to tell scopes of different threads apart
+		/// </summary>
+		static uint32_t threadIndex();
+
+		/// <summary>
+		/// Starts recording a new frame, the oldest frame in the history is overwritten
+		/// </summary>
+		void beginFrame();
+
+		/// <summary>
+		/// Finishes recording the current frame
+		/// </summary>
+		void endFrame();
+
+		/// <summary>
+		/// Records a finished scope into the current frame
+		/// </summary>
+		void recordEvent(const ProfileEvent& event);
+
+		/// <summary>
+		/// Records how many sprites were drawn this frame
+		/// </summary>
+		void setSpriteCount(int count);
+
+		/// <summary>
+		/// Handles the overlay and export keys, called once per frame
+		/// </summary>
+		void handleInput();
+
+		void toggleOverlay();
+
+		bool isOverlayVisible() const;
+
+		/// <summary>
+		/// Turns recording of scopes and allocations on or off, off when running games without a frame loop
+		/// </summary>
+		void setEnabled(bool enable);
+
+		/// <summary>
+		/// Draws the frame graph and the per scope timings of the last frame
+		/// </summary>
+		void drawOverlay(int x, int y);
+
+		/// <summary>
+		/// Writes the recorded history as a Chrome trace (chrome://tracing, Perfetto)
+		/// </summary>
+		/// <param name="path">Path of the JSON file to write</param>
+		/// <returns>true if the file was written, false if not</returns>
+		bool exportChromeTrace(const string& path);
+};
+
+/// <summary>
+/// Times its own lifetime and records it with the profiler
+/// </summary>
+class ProfileScope {
+	private:
+		const char* name;
+		int64_t start;
+		int depth;
+		bool active; // If the profiler was enabled when the scope started
+
+		static thread_local int currentDepth;
+
+	public:
+		ProfileScope(const char* name);
+		~ProfileScope();
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#endif
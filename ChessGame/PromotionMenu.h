@@ -39,10 +39,6 @@ class PromotionMenu {
 
             Vector2 mousePos = GetMousePosition();
 
-            Tile* promotionTile = board.getTile(promotionCell);
-
-            Piece* promotionPiece = promotionTile->getPiece();
-
             for (int i = 0; i < 4; i++) {
                 float yOffset = float(i * TILE_WIDTH) * totalWidth;
                 float boxX = x + 4;
@@ -66,20 +62,18 @@ class PromotionMenu {
 
                 if (hovering && open && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
                     // Replace the piece with the selected one
-                    Piece* newPiece = nullptr;
-					int player = promotionPiece->getPlayer();
+                    PieceType type = PieceType::NO_PIECE;
 
                     switch (i) {
-                        case ICON_KNIGHT: newPiece = new Knight(atlas, player); break;
-                        case ICON_ROOK:   newPiece = new Rook(atlas, player); break;
-                        case ICON_BISHOP: newPiece = new Bishop(atlas, player); break;
-                        case ICON_QUEEN:  newPiece = new Queen(atlas, player); break;
+                        case ICON_KNIGHT: type = PieceType::KNIGHT; break;
+                        case ICON_ROOK:   type = PieceType::ROOK; break;
+                        case ICON_BISHOP: type = PieceType::BISHOP; break;
+                        case ICON_QUEEN:  type = PieceType::QUEEN; break;
                         default: break;
                     }
 
-                    if (newPiece) {
-                        delete promotionTile->getPiece();  // Clean up old piece
-                        promotionTile->setPiece(newPiece);
+                    if (type != PieceType::NO_PIECE) {
+                        board.promotePiece(promotionCell, type);
                         open = false;  // Close menu after promotion
                     }
                 }
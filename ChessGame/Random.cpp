@@ -0,0 +1,70 @@
+#include "Random.h"
+#include <random>
+#include <chrono>
+
+using namespace std;
+
+Random::Random() { seed(0x853c49e6748fea9bULL); }
+
+Random::Random(uint64_t seed, uint64_t stream) { this->seed(seed, stream); }
+
+void Random::seed(uint64_t seed, uint64_t stream) {
+	state = 0;
+	increment = (stream << 1) | 1; // Has to be odd
+
+	next();
+	state += seed;
+	next();
+}
+
+void Random::getState(uint64_t& state, uint64_t& increment) const {
+	state = this->state;
+	increment = this->increment;
+}
+
+void Random::setState(uint64_t state, uint64_t increment) {
+	this->state = state;
+	this->increment = increment | 1;
+}
+
+uint32_t Random::next() {
+	uint64_t oldState = state;
+	state = oldState * 6364136223846793005ULL + increment;
+
+	uint32_t xorShifted = (uint32_t)(((oldState >> 18) ^ oldState) >> 27);
+	uint32_t rotation = (uint32_t)(oldState >> 59);
+
+	return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+}
+
+int Random::nextInt(int bound) {
+	if (bound <= 1) return 0;
+
+	// Multiply and keep the high bits, rejecting the few low values that would bias the result
+	uint32_t range = (uint32_t)bound;
+	uint64_t product = (uint64_t)next() * range;
+	uint32_t low = (uint32_t)product;
+
+	if (low < range) {
+		uint32_t threshold = (0u - range) % range;
+
+		while (low < threshold) {
+			product = (uint64_t)next() * range;
+			low = (uint32_t)product;
+		}
+	}
+
+	return (int)(product >> 32);
+}
+
+float Random::nextFloat(float min, float max) {
+	return min + (next() >> 8) * (1.0f / 16777216.0f) * (max - min);
+}
+
+uint64_t Random::createSeed() {
+	random_device device;
+
+	uint64_t seed = ((uint64_t)device() << 32) | device();
+
+	return seed ^ (uint64_t)chrono::steady_clock::now().time_since_epoch().count();
+}
@@ -0,0 +1,65 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Streams of a game's seed, each system gets its own so they don't shift each other's numbers
+#define RANDOM_STREAM_BOARD 1
+#define RANDOM_STREAM_SEARCH 2
+#define RANDOM_STREAM_BACKGROUND 3
+
+/// <summary>
+/// Small seeded random number generator (PCG32), the same seed and stream always give the same numbers
+/// </summary>
+class Random {
+	private:
+		uint64_t state = 0;
+		uint64_t increment = 1;
+
+	public:
+		Random();
+		Random(uint64_t seed, uint64_t stream = 0);
+
+		/// <summary>
+		/// Restarts the generator from a seed
+		/// </summary>
+		/// <param name="seed">The seed to start from</param>
+		/// <param name="stream">Which of the seed's independent sequences to use</param>
+		void seed(uint64_t seed, uint64_t stream = 0);
+
+		/// <summary>
+		/// Gets the next 32 random bits
+		/// </summary>
+		uint32_t next();
+
+		/// <summary>
+		/// Gets a random integer without modulo bias
+		/// </summary>
+		/// <param name="bound">The upper bound, exclusive</param>
+		/// <returns>A number from 0 to bound - 1</returns>
+		int nextInt(int bound);
+
+		/// <summary>
+		/// Gets a random float in a range
+		/// </summary>
+		/// <param name="min">The lower bound, inclusive</param>
+		/// <param name="max">The upper bound, exclusive</param>
+		float nextFloat(float min, float max);
+
+		/// <summary>
+		/// Gets the generator's internal state, so it can be sent or saved and carried on somewhere else
+		/// </summary>
+		void getState(uint64_t& state, uint64_t& increment) const;
+
+		/// <summary>
+		/// Sets the generator's internal state from getState
+		/// </summary>
+		void setState(uint64_t state, uint64_t increment);
+
+		/// <summary>
+		/// Creates a seed that is different every time the program runs
+		/// </summary>
+		static uint64_t createSeed();
+};
+
+#endif
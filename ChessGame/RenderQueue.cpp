@@ -2,6 +2,8 @@
 #include <algorithm>
 #include "isometric.h"
 #include <iostream>
+#include <cstring>
+#include "Profiler.h"
 
 SpriteObject::SpriteObject(raylib::Vector3 position, raylib::Texture2D* atlas, raylib::Rectangle source, Color color, float opacity) : position(position), atlas(atlas), source(source), color(color), opacity(opacity) {}
 
@@ -14,8 +16,20 @@ RenderQueue::RenderQueue() {
 	queue = vector<SpriteObject>();
 }
 
+uint32_t RenderQueue::depthToKey(float depth) {
+	uint32_t bits;
+	memcpy(&bits, &depth, sizeof(bits));
+
+	// Flip all bits of negative floats and only the sign bit of positive ones, so they compare as unsigned integers
+	return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
 void RenderQueue::draw() {
-	for (SpriteObject& spriteObject : queue) {
+	PROFILE_SCOPE("RenderQueue::draw");
+
+	for (uint32_t index : sortedIndices) {
+		SpriteObject& spriteObject = queue[index];
+
 		raylib::Vector2 screenPosition = IsoToScreen(spriteObject.position + raylib::Vector3(0.0, 0.0, (spriteObject.source.height / TILE_HEIGHT) - 1.0));
 
 		DrawTextureRec(*spriteObject.atlas, spriteObject.source, screenPosition, Fade(spriteObject.color, spriteObject.opacity));
@@ -23,17 +37,54 @@ void RenderQueue::draw() {
 }
 
 void RenderQueue::addSpriteObject(SpriteObject spriteObject) {
+	sortedIndices.push_back((uint32_t)queue.size()); // Drawn in insertion order until sorted
+	depthKeys.push_back(depthToKey(spriteObject.getDepth()));
 	queue.push_back(spriteObject);
 }
 
 void RenderQueue::sortQueue() {
-	sort(queue.begin(), queue.end(), [](SpriteObject a, SpriteObject b) {
-		return a.getDepth() < b.getDepth();
-	});
+	PROFILE_SCOPE("RenderQueue::sortQueue");
+
+	// Same sprites at the same depths as last frame, so the order is the same as well
+	if (depthKeys == lastDepthKeys) {
+		sortedIndices = lastSortedIndices;
+		return;
+	}
+
+	size_t count = depthKeys.size();
+
+	if (count == 0) return;
+
+	sortedIndices.resize(count);
+	sortScratch.resize(count);
+
+	for (size_t i = 0; i < count; i++) sortedIndices[i] = (uint32_t)i;
+
+	// Stable LSD radix sort over the indices, one byte of the key per pass
+	for (int shift = 0; shift < 32; shift += 8) {
+		size_t offsets[257] = { 0 };
+
+		for (size_t i = 0; i < count; i++) offsets[((depthKeys[i] >> shift) & 0xFF) + 1]++;
+
+		if (offsets[((depthKeys[0] >> shift) & 0xFF) + 1] == count) continue; // Every key has the same byte, nothing to do
+
+		for (int bucket = 0; bucket < 256; bucket++) offsets[bucket + 1] += offsets[bucket];
+
+		for (uint32_t index : sortedIndices) {
+			sortScratch[offsets[(depthKeys[index] >> shift) & 0xFF]++] = index;
+		}
+
+		sortedIndices.swap(sortScratch);
+	}
+
+	lastDepthKeys = depthKeys;
+	lastSortedIndices = sortedIndices;
 }
 
 void RenderQueue::clearQueue() {
 	queue.clear();
+	depthKeys.clear();
+	sortedIndices.clear();
 }
 
 int RenderQueue::numberOfSpriteObjects() {
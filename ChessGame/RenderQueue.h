@@ -3,6 +3,7 @@
 
 #include "include/raylib-cpp.hpp"
 #include <vector>
+#include <cstdint>
 
 using namespace std;
 
@@ -22,6 +23,18 @@ class RenderQueue {
 	private:
 		vector<SpriteObject> queue;
 
+		vector<uint32_t> depthKeys;     // Sort key of each sprite object, computed on insertion
+		vector<uint32_t> sortedIndices; // Draw order as indices into the queue
+		vector<uint32_t> sortScratch;   // Scratch buffer for the radix passes
+
+		vector<uint32_t> lastDepthKeys; // Keys of the previous frame, used to skip sorting when nothing moved
+		vector<uint32_t> lastSortedIndices;
+
+		/// <summary>
+		/// Converts a depth into an unsigned key that sorts in the same order as the depth
+		/// </summary>
+		static uint32_t depthToKey(float depth);
+
 	public:
 		RenderQueue();
 
@@ -29,6 +42,9 @@ class RenderQueue {
 
 		void addSpriteObject(SpriteObject spriteObject);
 
+		/// <summary>
+		/// Sorts the sprite objects back to front, skipped if the keys are identical to the previous frame
+		/// </summary>
 		void sortQueue();
 
 		void clearQueue();
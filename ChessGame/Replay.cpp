@@ -0,0 +1,204 @@
+#include "Replay.h"
+#include <algorithm>
+#include <iostream>
+
+/************************************|
+			   REPLAY
+|************************************/
+
+bool Replay::load(const string& path, size_t gameIndex) {
+	GameRecordReader reader;
+
+	if (!reader.open(path) || gameIndex >= reader.getGameCount()) return false;
+
+	RecordedGame game = reader.getGame(gameIndex);
+
+	if (game.ruleset != GAME_RULESET_TILE_CHESS) return false;
+
+	seed = game.seed;
+	outcome = GameOutcome::UNFINISHED;
+	plies.clear();
+	snapshots.clear();
+
+	vector<RecordEntry> recorded;
+
+	for (size_t i = 0; i < game.entryCount; i++) {
+		RecordEntry entry = game.getEntry(i);
+
+		switch (entry.getTag()) {
+			case RECORD_MOVE:
+				plies.push_back({ entry.getMove(), {} });
+				break;
+			case RECORD_PROMOTION:
+				if (!plies.empty()) plies.back().promotions.push_back({ entry.getPromotionCell(), entry.getPromotionType() });
+				break;
+			case RECORD_END:
+				outcome = entry.getOutcome();
+				continue;
+			default:
+				break;
+		}
+
+		recorded.push_back(entry);
+	}
+
+	// Play the game through once, tiles spawn from the seed so they come out the same as they did in the game
+	cursor = make_unique<Game>(nullptr, true, seed);
+
+	vector<RecordEntry> replayed;
+	recordGame(*cursor, [&](RecordEntry entry) { replayed.push_back(entry); });
+
+	for (size_t ply = 0; ply < plies.size(); ply++) {
+		if (ply % REPLAY_SNAPSHOT_INTERVAL == 0) snapshots.push_back(cursor->getState());
+
+		if (!applyPly(*cursor, plies[ply])) {
+			cout << "Replay stopped at ply " << ply << ", the move isn't legal" << endl;
+			plies.resize(ply);
+			break;
+		}
+	}
+
+	if (snapshots.empty()) snapshots.push_back(cursor->getState());
+
+	// Seeks don't need the hooks, and they'd point at the locals here
+	recordGame(*cursor, [](RecordEntry) {});
+
+	bool matches = replayed.size() <= recorded.size() && equal(replayed.begin(), replayed.end(), recorded.begin(), [](RecordEntry a, RecordEntry b) {
+		return a.bits == b.bits;
+	});
+
+	if (!matches) cout << "Replay doesn't match the record, the rules might have changed since it was played" << endl;
+
+	return true;
+}
+
+int Replay::getPlyCount() { return (int)plies.size(); }
+
+uint64_t Replay::getSeed() { return seed; }
+
+GameOutcome Replay::getOutcome() { return outcome; }
+
+const ReplayPly& Replay::getPly(int ply) { return plies.at(ply); }
+
+GameState Replay::seek(int ply) {
+	ply = clamp(ply, 0, getPlyCount());
+
+	int snapshot = min(ply / REPLAY_SNAPSHOT_INTERVAL, (int)snapshots.size() - 1);
+
+	cursor->setState(snapshots[snapshot]);
+
+	for (int i = snapshot * REPLAY_SNAPSHOT_INTERVAL; i < ply; i++) applyPly(*cursor, plies[i]);
+
+	return cursor->getState();
+}
+
+bool Replay::applyPly(Game& game, const ReplayPly& ply) {
+	optional<Move> move = game.getLegalMove(ply.move.from, ply.move.to); // The record doesn't have the flags
+
+	if (!move) return false;
+
+	game.getCurrentPlayer().setMove(move.value());
+
+	Board& board = game.getBoard();
+	size_t promotion = 0;
+
+	// The first update takes the move, then every phase finishes on its own update
+	do {
+		while (board.hasPromotion()) {
+			PieceType type = promotion < ply.promotions.size() ? ply.promotions[promotion++].second : PieceType::QUEEN;
+
+			board.promotePiece(board.getPromotionCell(), type);
+		}
+
+		game.update();
+	} while (!game.isPlayable() && !game.getGameEnd());
+
+	return true;
+}
+
+/************************************|
+			   VIEWER
+|************************************/
+
+ReplayViewer::ReplayViewer(Replay& replay) : replay(replay) {}
+
+void ReplayViewer::seek(Game& game, GameLoop& loop, int target) {
+	ply = clamp(target, 0, replay.getPlyCount());
+	steppingPly = nullopt;
+
+	game.setState(replay.seek(ply));
+
+	loop.push({ GameLoopEventType::STATE_UPDATED }); // The turn changed without being played
+}
+
+optional<Move> ReplayViewer::handleInput(Game& game, GameLoop& loop) {
+	Vector2 mouse = GetMousePosition();
+
+	if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(mouse, { bar.x, bar.y - 6.0f, bar.width, bar.height + 12.0f })) scrubbing = true;
+	if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) scrubbing = false;
+
+	if (scrubbing && bar.width > 0.0f) {
+		int target = (int)roundf(Clamp((mouse.x - bar.x) / bar.width, 0.0f, 1.0f) * replay.getPlyCount());
+
+		if (target != ply) seek(game, loop, target);
+
+		return nullopt;
+	}
+
+	if (IsKeyPressed(KEY_HOME)) seek(game, loop, 0);
+	if (IsKeyPressed(KEY_END)) seek(game, loop, replay.getPlyCount());
+	if (IsKeyPressed(KEY_LEFT) && ply > 0) seek(game, loop, ply - 1);
+
+	// Stepping forward plays the ply with its animations, once the last one finished
+	if (IsKeyPressed(KEY_RIGHT) && ply < replay.getPlyCount() && game.isPlayable()) {
+		const ReplayPly& next = replay.getPly(ply);
+
+		optional<Move> move = game.getLegalMove(next.move.from, next.move.to);
+
+		if (!move) {
+			seek(game, loop, ply + 1); // Shouldn't happen, the replay was checked when it loaded
+			return nullopt;
+		}
+
+		steppingPly = ply++;
+
+		return move;
+	}
+
+	return nullopt;
+}
+
+void ReplayViewer::promote(Game& game) {
+	if (!steppingPly) return;
+
+	Board& board = game.getBoard();
+	const vector<pair<Cell, PieceType>>& promotions = replay.getPly(steppingPly.value()).promotions;
+
+	while (board.hasPromotion()) {
+		Cell cell = board.getPromotionCell();
+
+		auto promotion = find_if(promotions.begin(), promotions.end(), [&](const pair<Cell, PieceType>& recorded) { return recorded.first == cell; });
+
+		board.promotePiece(cell, promotion != promotions.end() ? promotion->second : PieceType::QUEEN);
+	}
+
+	if (game.isPlayable()) steppingPly = nullopt;
+}
+
+void ReplayViewer::draw(int x, int y, int width) {
+	bar = { (float)x, (float)y, (float)width, 4.0f };
+
+	DrawRectangleRec(bar, Fade(WHITE, 0.3f));
+
+	int plies = replay.getPlyCount();
+	float progress = plies > 0 ? (float)ply / plies : 0.0f;
+
+	DrawRectangle(x, y, (int)(width * progress), 4, WHITE);
+	DrawCircle(x + (int)(width * progress), y + 2, 5.0f, WHITE);
+
+	string text = "Ply " + to_string(ply) + " / " + to_string(plies) + "  " + getOutcomeString(replay.getOutcome());
+
+	DrawText(text.c_str(), x, y - 16, 10, WHITE);
+}
+
+int ReplayViewer::getPly() { return ply; }
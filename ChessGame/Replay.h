@@ -0,0 +1,119 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "game.h"
+#include "GameRecord.h"
+#include "GameLoop.h"
+
+using namespace std;
+
+#define REPLAY_SNAPSHOT_INTERVAL 8 // Plies between snapshots, so a seek never plays more than this many plies
+
+/// <summary>
+/// A player's move from the record and the pieces its pawns were promoted to
+/// </summary>
+struct ReplayPly {
+	Move move;
+
+	vector<pair<Cell, PieceType>> promotions;
+};
+
+/// <summary>
+/// A recorded game played through once on load, with snapshots every few plies so any ply can be reached instantly
+/// </summary>
+class Replay {
+	private:
+		uint64_t seed = 0;
+		GameOutcome outcome = GameOutcome::UNFINISHED;
+
+		vector<ReplayPly> plies;
+
+		/// <summary>
+		/// The state before every REPLAY_SNAPSHOT_INTERVAL plies, starting with the state before the first ply
+		/// </summary>
+		vector<GameState> snapshots;
+
+		/// <summary>
+		/// Game without animations or audio that seeks are played on
+		/// </summary>
+		unique_ptr<Game> cursor;
+
+	public:
+		/// <summary>
+		/// Loads a game from a record file and plays it through to take the snapshots
+		/// </summary>
+		/// <param name="path">The record file</param>
+		/// <param name="gameIndex">Which game of the file to load</param>
+		/// <returns>true if the game was loaded, false if the file or game couldn't be read</returns>
+		bool load(const string& path, size_t gameIndex = 0);
+
+		int getPlyCount();
+
+		uint64_t getSeed();
+
+		GameOutcome getOutcome();
+
+		const ReplayPly& getPly(int ply);
+
+		/// <summary>
+		/// Gets the game at a ply, from the nearest snapshot before it
+		/// </summary>
+		/// <param name="ply">The number of plies played, clamped to the length of the game</param>
+		GameState seek(int ply);
+
+		/// <summary>
+		/// Plays a ply on a game without animations, promoting pawns like they were in the record
+		/// </summary>
+		/// <returns>true if the move was legal, false if the game went somewhere the record didn't</returns>
+		static bool applyPly(Game& game, const ReplayPly& ply);
+};
+
+/// <summary>
+/// Lets the player step through and scrub a replay in the window, used by the --replay mode
+/// </summary>
+class ReplayViewer {
+	private:
+		Replay& replay;
+
+		int ply = 0;
+
+		/// <summary>
+		/// Ply being animated, its promotions are made from the record instead of the promotion menu
+		/// </summary>
+		optional<int> steppingPly;
+
+		Rectangle bar = { 0.0f, 0.0f, 0.0f, 0.0f }; // Where the scrub bar was last drawn
+		bool scrubbing = false;
+
+	public:
+		ReplayViewer(Replay& replay);
+
+		/// <summary>
+		/// Jumps to a ply without animations
+		/// </summary>
+		void seek(Game& game, GameLoop& loop, int ply);
+
+		/// <summary>
+		/// Handles the replay keys (left and right step, home and end jump) and dragging the scrub bar
+		/// </summary>
+		/// <returns>The next move to play with animations when stepping forward</returns>
+		optional<Move> handleInput(Game& game, GameLoop& loop);
+
+		/// <summary>
+		/// Promotes the pawns of the ply being animated like the record did, called before the game updates
+		/// </summary>
+		void promote(Game& game);
+
+		/// <summary>
+		/// Draws the scrub bar and the ply
+		/// </summary>
+		void draw(int x, int y, int width);
+
+		int getPly();
+};
+
+#endif
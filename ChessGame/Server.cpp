@@ -0,0 +1,628 @@
+#include "Server.h"
+#include "Socket.h"
+#include "Simulation.h"
+#include "Log.h"
+#include "game.h"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+
+ServerOptions parseServerOptions(int argc, char** argv) {
+	ServerOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--port" && hasValue) options.port = (uint16_t)atoi(argv[++i]);
+		else if (argument == "--host" && hasValue) options.host = argv[++i];
+		else if (argument == "--threads" && hasValue) options.threads = atoi(argv[++i]);
+		else if (argument == "--depth" && hasValue) options.depth = max(1, atoi(argv[++i]));
+	}
+
+	return options;
+}
+
+LoadGenOptions parseLoadGenOptions(int argc, char** argv) {
+	LoadGenOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--loadgen" && hasValue && isdigit(argv[i + 1][0])) options.connections = max(1, atoi(argv[++i]));
+		else if (argument == "--host" && hasValue) options.host = argv[++i];
+		else if (argument == "--port" && hasValue) options.port = (uint16_t)atoi(argv[++i]);
+		else if (argument == "--games" && hasValue) options.games = atoi(argv[++i]);
+		else if (argument == "--plies" && hasValue) options.maxPlies = max(1, atoi(argv[++i]));
+		else if (argument == "--seed" && hasValue) options.seed = strtoul(argv[++i], nullptr, 10);
+	}
+
+	return options;
+}
+
+/// <summary>
+/// Gets a move in the protocol's notation, like "e2e4"
+/// </summary>
+static string getServerMove(const Move& move) {
+	return move.from.getAlgebraicNotation() + move.to.getAlgebraicNotation();
+}
+
+/// <summary>
+/// Splits a line into its first word and the rest
+/// </summary>
+static pair<string, string> splitCommand(const string& line) {
+	size_t space = line.find(' ');
+
+	if (space == string::npos) return { line, "" };
+
+	return { line.substr(0, space), line.substr(space + 1) };
+}
+
+/************************************|
+			  WORKERS
+|************************************/
+
+/// <summary>
+/// Runs jobs on a fixed set of threads, in the order they were pushed
+/// </summary>
+class ServerWorkers {
+	private:
+		vector<thread> threads;
+
+		mutex jobMutex;
+		condition_variable jobCondition;
+		queue<function<void()>> jobs;
+		bool stopping = false;
+
+		void run() {
+			while (true) {
+				function<void()> job;
+
+				{
+					unique_lock<mutex> lock(jobMutex);
+					jobCondition.wait(lock, [&]() { return stopping || !jobs.empty(); });
+
+					if (jobs.empty()) return; // Only when stopping
+
+					job = move(jobs.front());
+					jobs.pop();
+				}
+
+				job();
+			}
+		}
+
+	public:
+		ServerWorkers(int count) {
+			for (int i = 0; i < count; i++) threads.emplace_back(&ServerWorkers::run, this);
+		}
+
+		~ServerWorkers() {
+			{
+				lock_guard<mutex> lock(jobMutex);
+				stopping = true;
+			}
+
+			jobCondition.notify_all();
+
+			for (thread& worker : threads) worker.join();
+		}
+
+		void push(function<void()> job) {
+			{
+				lock_guard<mutex> lock(jobMutex);
+				jobs.push(move(job));
+			}
+
+			jobCondition.notify_one();
+		}
+};
+
+/************************************|
+			   SERVER
+|************************************/
+
+/// <summary>
+/// The game of a connection. Only touched by one worker at a time, the connection waits for each command to finish before sending the next
+/// </summary>
+struct ServerSession {
+	unique_ptr<Game> game;
+
+	/// <summary>
+	/// Plays a move to the end of the turn without animations, promoting pawns to queens
+	/// </summary>
+	void playPly(const Move& move) {
+		game->getCurrentPlayer().setMove(move);
+
+		Board& board = game->getBoard();
+		int updatesLeft = 64; // Every phase finishes on its first update, so a turn only takes a handful
+
+		do {
+			while (board.hasPromotion()) board.promotePiece(board.getPromotionCell(), PieceType::QUEEN);
+
+			game->update();
+		} while (!game->isPlayable() && !game->getGameEnd() && --updatesLeft > 0);
+	}
+
+	/// <summary>
+	/// Runs a command of the protocol
+	/// </summary>
+	/// <returns>The line to answer with</returns>
+	string handle(const string& line, int depth) {
+		auto [command, argument] = splitCommand(line);
+
+		if (command == "new") {
+			uint64_t seed = argument.empty() ? Random::createSeed() : strtoull(argument.c_str(), nullptr, 10);
+
+			game = make_unique<Game>(nullptr, true, seed);
+
+			return "game " + to_string(seed) + " " + game->getFEN();
+		}
+
+		if (command != "fen" && command != "legal" && command != "move") return "error unknown command " + command;
+
+		if (!game) return "error no game, send new first";
+
+		if (command == "fen") return "fen " + game->getFEN();
+
+		if (command == "legal") {
+			string reply = "legal";
+
+			if (!game->getGameEnd()) {
+				for (const Move& move : game->getLegalMoves()) reply += " " + getServerMove(move);
+			}
+
+			return reply;
+		}
+
+		// move
+		if (game->getGameEnd()) return "error the game is over";
+
+		if (argument.size() < 4) return "error expected a move like e2e4";
+
+		Cell from(argument[1] - '1', argument[0] - 'a');
+		Cell to(argument[3] - '1', argument[2] - 'a');
+
+		optional<Move> move = from.isInBounds() && to.isInBounds() ? game->getLegalMove(from, to) : nullopt;
+
+		if (!move) return "error illegal move " + argument;
+
+		playPly(move.value());
+
+		string reply = "-";
+
+		if (!game->getGameEnd()) {
+			optional<Move> aiMove = chooseSimulatedMove(*game, depth);
+
+			if (aiMove) {
+				reply = getServerMove(aiMove.value());
+				playPly(aiMove.value());
+			}
+		}
+
+		return "played " + reply + " " + getOutcomeString(game->getOutcome()) + " " + game->getFEN();
+	}
+};
+
+struct ServerConnection {
+	Socket socket;
+
+	string input;
+	string output;
+
+	shared_ptr<ServerSession> session = make_shared<ServerSession>();
+
+	bool busy = false;    // A command is running on a worker, the next one waits in the input until it's done
+	bool closing = false; // Close once the output is sent
+	bool writing = false; // Waiting for room to write
+};
+
+struct ServerReply {
+	uint64_t connection;
+	string line;
+};
+
+#define SERVER_LISTENER_KEY 0
+#define SERVER_WAKE_KEY 1
+
+int runServer(const ServerOptions& options) {
+	if (!initSockets()) {
+		cerr << "Unable to start sockets" << endl;
+		return 1;
+	}
+
+	Socket listener = Socket::listen(options.port, options.host);
+	Socket wakeSocket = Socket::createWakeSocket();
+
+	if (!listener.isValid() || !wakeSocket.isValid()) {
+		cerr << "Unable to listen on port " << options.port << endl;
+		return 1;
+	}
+
+	int threadCount = options.threads > 0 ? options.threads : max(1u, thread::hardware_concurrency());
+
+	cerr << "Hosting games on port " << options.port << " with " << threadCount << " AI threads (depth " << options.depth << ")" << endl;
+
+	// The games log every step to cout, which would serialize all threads on the console
+	silenceGameLog();
+
+	SocketPoller poller;
+	poller.add(listener, SERVER_LISTENER_KEY);
+	poller.add(wakeSocket, SERVER_WAKE_KEY);
+
+	unordered_map<uint64_t, unique_ptr<ServerConnection>> connections;
+	uint64_t nextKey = SERVER_WAKE_KEY + 1;
+
+	// Replies from the workers, handed back to the socket thread
+	mutex replyMutex;
+	vector<ServerReply> replies;
+	vector<ServerReply> handledReplies;
+
+	atomic<uint64_t> commandsRun{ 0 };
+
+	ServerWorkers workers(threadCount);
+
+	auto closeConnection = [&](uint64_t key) {
+		auto found = connections.find(key);
+
+		if (found == connections.end()) return;
+
+		poller.remove(found->second->socket);
+		connections.erase(found); // A command still running keeps its session alive until it's done
+	};
+
+	// Sends as much of the output as the socket takes, waiting for room to write for the rest
+	auto flush = [&](uint64_t key, ServerConnection& connection) {
+		while (!connection.output.empty()) {
+			int sent = connection.socket.send(connection.output.data(), (int)connection.output.size());
+
+			if (sent == SOCKET_WOULD_BLOCK) break;
+
+			if (sent <= 0) {
+				closeConnection(key);
+				return;
+			}
+
+			connection.output.erase(0, sent);
+		}
+
+		bool waiting = !connection.output.empty();
+
+		if (waiting != connection.writing) {
+			poller.modify(connection.socket, key, waiting);
+			connection.writing = waiting;
+		}
+
+		if (!waiting && connection.closing) closeConnection(key);
+	};
+
+	// Starts the next whole command in the input, one at a time per connection so its game is only on one worker
+	auto handleInput = [&](uint64_t key, ServerConnection& connection) {
+		if (connection.busy || connection.closing) return;
+
+		size_t end = connection.input.find('\n');
+
+		if (end == string::npos) {
+			if (connection.input.size() > SERVER_MAX_LINE) closeConnection(key);
+			return;
+		}
+
+		string line = connection.input.substr(0, end);
+		connection.input.erase(0, end + 1);
+
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+
+		if (line == "quit") {
+			connection.closing = true;
+			flush(key, connection);
+			return;
+		}
+
+		connection.busy = true;
+
+		workers.push([&, key, line, session = connection.session]() {
+			string reply = session->handle(line, options.depth);
+
+			commandsRun++;
+
+			{
+				lock_guard<mutex> lock(replyMutex);
+				replies.push_back({ key, reply });
+			}
+
+			wakeSocket.wake();
+		});
+	};
+
+	vector<SocketEvent> events;
+	char buffer[SERVER_READ_SIZE];
+
+	auto lastStats = chrono::steady_clock::now();
+	uint64_t lastCommands = 0;
+
+	while (true) {
+		poller.wait(events, 1000);
+
+		for (const SocketEvent& event : events) {
+			if (event.key == SERVER_LISTENER_KEY) {
+				Socket socket;
+
+				while ((socket = listener.accept()).isValid()) {
+					uint64_t key = nextKey++;
+
+					auto connection = make_unique<ServerConnection>();
+					connection->socket = move(socket);
+
+					poller.add(connection->socket, key);
+					connections[key] = move(connection);
+				}
+
+				continue;
+			}
+
+			if (event.key == SERVER_WAKE_KEY) {
+				wakeSocket.drain();
+
+				{
+					lock_guard<mutex> lock(replyMutex);
+					swap(replies, handledReplies);
+				}
+
+				for (const ServerReply& reply : handledReplies) {
+					auto found = connections.find(reply.connection);
+
+					if (found == connections.end()) continue; // Disconnected while its command ran
+
+					ServerConnection& connection = *found->second;
+
+					connection.busy = false;
+					connection.output += reply.line + "\n";
+
+					flush(reply.connection, connection);
+
+					// Flushing can close the connection
+					if (connections.count(reply.connection)) handleInput(reply.connection, connection);
+				}
+
+				handledReplies.clear();
+				continue;
+			}
+
+			auto found = connections.find(event.key);
+
+			if (found == connections.end()) continue;
+
+			ServerConnection& connection = *found->second;
+
+			if (event.writable) {
+				flush(event.key, connection);
+
+				if (!connections.count(event.key)) continue;
+			}
+
+			if (event.readable) {
+				int received;
+
+				while ((received = connection.socket.receive(buffer, sizeof(buffer))) > 0) connection.input.append(buffer, received);
+
+				if (received != SOCKET_WOULD_BLOCK) {
+					closeConnection(event.key); // Closed by the client, or failed
+					continue;
+				}
+
+				handleInput(event.key, connection);
+			}
+		}
+
+		double elapsed = chrono::duration<double>(chrono::steady_clock::now() - lastStats).count();
+
+		if (elapsed >= SERVER_STATS_INTERVAL) {
+			uint64_t commands = commandsRun;
+
+			cerr << connections.size() << " connections, " << (uint64_t)((commands - lastCommands) / elapsed) << " commands per second" << endl;
+
+			lastStats = chrono::steady_clock::now();
+			lastCommands = commands;
+		}
+	}
+
+	return 0;
+}
+
+/************************************|
+			  LOAD GEN
+|************************************/
+
+struct LoadGenClient {
+	Socket socket;
+
+	string input;
+
+	Random random;
+
+	int plies = 0;
+
+	chrono::steady_clock::time_point sentTime; // When the last move was sent
+};
+
+int runLoadGen(const LoadGenOptions& options) {
+	if (!initSockets()) {
+		cerr << "Unable to start sockets" << endl;
+		return 1;
+	}
+
+	SocketPoller poller;
+	vector<LoadGenClient> clients(options.connections);
+
+	int startedGames = 0;
+	int finishedGames = 0;
+	int abandonedGames = 0;
+	int errors = 0;
+	int outcomeCounts[5] = { 0 };
+
+	vector<double> latencies; // Milliseconds from sending a move to the server's reply
+
+	int openClients = 0;
+
+	auto closeClient = [&](LoadGenClient& client) {
+		poller.remove(client.socket);
+		client.socket.close();
+		openClients--;
+	};
+
+	auto send = [&](LoadGenClient& client, const string& line) {
+		string text = line + "\n";
+
+		// Replies are waited for before sending anything else, so a line always fits in the socket's buffer
+		if (client.socket.send(text.data(), (int)text.size()) != (int)text.size()) {
+			cerr << "Failed to send to the server" << endl;
+			closeClient(client);
+		}
+	};
+
+	// Starts the next game on a connection, or closes it once enough games were started
+	auto startGame = [&](size_t index) {
+		LoadGenClient& client = clients[index];
+
+		if (startedGames >= options.games) {
+			closeClient(client);
+			return;
+		}
+
+		uint64_t seed = (uint64_t)options.seed + startedGames++;
+
+		client.plies = 0;
+		client.random.seed(seed, index);
+
+		send(client, "new " + to_string(seed));
+	};
+
+	for (size_t i = 0; i < clients.size(); i++) {
+		clients[i].socket = Socket::connect(options.host, options.port);
+
+		if (!clients[i].socket.isValid()) {
+			cerr << "Unable to connect to " << options.host << ":" << options.port << endl;
+			return 1;
+		}
+
+		poller.add(clients[i].socket, i);
+		openClients++;
+	}
+
+	cout << "Playing " << options.games << " games over " << options.connections << " connections to " << options.host << ":" << options.port << "..." << endl;
+
+	auto startTime = chrono::steady_clock::now();
+
+	for (size_t i = 0; i < clients.size(); i++) startGame(i);
+
+	vector<SocketEvent> events;
+	char buffer[SERVER_READ_SIZE];
+
+	while (openClients > 0) {
+		poller.wait(events, 1000);
+
+		for (const SocketEvent& event : events) {
+			LoadGenClient& client = clients[event.key];
+
+			if (!client.socket.isValid()) continue;
+
+			int received;
+
+			while ((received = client.socket.receive(buffer, sizeof(buffer))) > 0) client.input.append(buffer, received);
+
+			if (received != SOCKET_WOULD_BLOCK) {
+				cerr << "The server closed a connection" << endl;
+				closeClient(client);
+				continue;
+			}
+
+			size_t end;
+
+			while (client.socket.isValid() && (end = client.input.find('\n')) != string::npos) {
+				string line = client.input.substr(0, end);
+				client.input.erase(0, end + 1);
+
+				auto [reply, argument] = splitCommand(line);
+
+				if (reply == "game") send(client, "legal");
+				else if (reply == "legal") {
+					istringstream moves(argument);
+					vector<string> legalMoves;
+					string move;
+
+					while (moves >> move) legalMoves.push_back(move);
+
+					if (legalMoves.empty()) {
+						abandonedGames++; // No moves but the game didn't end, shouldn't happen
+						startGame(event.key);
+						continue;
+					}
+
+					client.sentTime = chrono::steady_clock::now();
+
+					send(client, "move " + legalMoves[client.random.nextInt((int)legalMoves.size())]);
+				} else if (reply == "played") {
+					latencies.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - client.sentTime).count());
+
+					client.plies += 2;
+
+					istringstream fields(argument);
+					string aiMove, outcome;
+					fields >> aiMove >> outcome;
+
+					if (outcome != "*" || client.plies >= options.maxPlies) {
+						if (outcome == "1-0") outcomeCounts[(int)GameOutcome::PLAYER_1_WIN]++;
+						else if (outcome == "0-1") outcomeCounts[(int)GameOutcome::PLAYER_2_WIN]++;
+						else if (outcome == "1/2") outcomeCounts[(int)GameOutcome::STALEMATE]++;
+						else outcomeCounts[(int)GameOutcome::PLY_LIMIT]++;
+
+						int finished = ++finishedGames;
+
+						if (finished % 100 == 0) cerr << finished << "/" << options.games << " games played" << endl;
+
+						startGame(event.key);
+					} else {
+						send(client, "legal");
+					}
+				} else {
+					cerr << "Server: " << line << endl;
+					errors++;
+					startGame(event.key);
+				}
+			}
+		}
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+	sort(latencies.begin(), latencies.end());
+
+	auto percentile = [&](double fraction) { return latencies.empty() ? 0.0 : latencies[min(latencies.size() - 1, (size_t)(fraction * latencies.size()))]; };
+
+	double totalLatency = 0.0;
+	for (double latency : latencies) totalLatency += latency;
+
+	cout << "Done! Took: " << seconds << " seconds (" << finishedGames / max(seconds, 0.001) << " games per second, " << latencies.size() / max(seconds, 0.001) << " turns per second)" << endl;
+	cout << "Player 1 wins: " << outcomeCounts[(int)GameOutcome::PLAYER_1_WIN] << endl;
+	cout << "Player 2 wins: " << outcomeCounts[(int)GameOutcome::PLAYER_2_WIN] << endl;
+	cout << "Stalemates: " << outcomeCounts[(int)GameOutcome::STALEMATE] << endl;
+	cout << "Ply limit reached: " << outcomeCounts[(int)GameOutcome::PLY_LIMIT] << endl;
+	cout << "Abandoned: " << abandonedGames << ", errors: " << errors << endl;
+	cout << "Turn latency: " << (latencies.empty() ? 0.0 : totalLatency / latencies.size()) << " ms average, " << percentile(0.5) << " ms median, " << percentile(0.99) << " ms 99th percentile, " << percentile(1.0) << " ms worst" << endl;
+
+	shutdownSockets();
+
+	return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+#define SERVER_PORT 7373
+#define SERVER_READ_SIZE 4096
+#define SERVER_MAX_LINE 1024 // Longest command a client can send, longer ones drop the connection
+#define SERVER_STATS_INTERVAL 10.0 // Seconds between the status lines the server prints
+
+/*
+	Server protocol, one command or reply per line of text:
+
+	Client                  Server
+	new [seed]              game <seed> <fen>
+	fen                     fen <fen>
+	legal                   legal <move> <move> ...
+	move <move>             played <reply or -> <outcome> <fen>
+	quit                    (closes the connection)
+
+	Moves are in UCI notation (like "e2e4"), pawns promote to queens. Every connection plays one game at a time as
+	player 1, the server answers every move with the AI's reply (player 2). The outcome is "*" while the game goes on.
+	Anything the server can't do is answered with "error <reason>".
+*/
+
+struct ServerOptions {
+	uint16_t port = SERVER_PORT;
+	string host = "";   // Address to listen on, every address if empty
+	int threads = 0;    // Threads the AI turns are searched on, 0 for one per core
+	int depth = 2;      // Search depth of the AI
+};
+
+struct LoadGenOptions {
+	string host = "127.0.0.1";
+	uint16_t port = SERVER_PORT;
+	int connections = 100; // Games played at once
+	int games = 1000;      // Games to finish before stopping
+	int maxPlies = 200;    // Games that run longer than this are abandoned and a new one is started
+	unsigned int seed = 1; // Seed of the first game, every following game adds one
+};
+
+/// <summary>
+/// Reads the options of the --server mode: --server [--port n] [--host address] [--threads n] [--depth n]
+/// </summary>
+ServerOptions parseServerOptions(int argc, char** argv);
+
+/// <summary>
+/// Reads the options of the --loadgen mode: --loadgen [connections] [--host address] [--port n] [--games n] [--plies n] [--seed n]
+/// </summary>
+LoadGenOptions parseLoadGenOptions(int argc, char** argv);
+
+/// <summary>
+/// Hosts games for clients over TCP without a window. Every connection gets its own game, sockets are handled on one
+/// thread and the turns are played on a pool of worker threads, so a slow search doesn't hold up the other games
+/// </summary>
+/// <param name="options">The settings to host with</param>
+/// <returns>The exit code of the program</returns>
+int runServer(const ServerOptions& options);
+
+/// <summary>
+/// Plays many games against a server at once with random legal moves and reports how fast it answered
+/// </summary>
+/// <param name="options">The settings to play with</param>
+/// <returns>The exit code of the program</returns>
+int runLoadGen(const LoadGenOptions& options);
+
+#endif
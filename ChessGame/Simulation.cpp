@@ -0,0 +1,165 @@
+#include "Simulation.h"
+#include "game.h"
+#include "MoveGenerator.h"
+#include "Log.h"
+#include "OpeningBook.h"
+#include "Tablebase.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cctype>
+
+SimulationOptions parseSimulationOptions(int argc, char** argv) {
+	SimulationOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--selfplay" && hasValue && isdigit(argv[i + 1][0])) options.games = atoi(argv[++i]);
+		else if (argument == "--threads" && hasValue) options.threads = atoi(argv[++i]);
+		else if (argument == "--depth" && hasValue) options.depth = max(1, atoi(argv[++i]));
+		else if (argument == "--plies" && hasValue) options.maxPlies = atoi(argv[++i]);
+		else if (argument == "--seed" && hasValue) options.seed = strtoul(argv[++i], nullptr, 10);
+		else if (argument == "--log" && hasValue) options.logPath = argv[++i];
+		else if (argument == "--record" && hasValue) options.recordPath = argv[++i];
+		else if (argument == "--book" && hasValue) options.bookPath = argv[++i];
+		else if (argument == "--tablebases" && hasValue) options.tablebasePath = argv[++i];
+	}
+
+	return options;
+}
+
+optional<Move> chooseSimulatedMove(Game& game, int depth) {
+	Board& board = game.getBoard();
+	int player = game.getPlayerTurn();
+
+	Move aiMove = MoveGenerator(game).chooseMove(depth);
+
+	if (board.isLegalMove(player, aiMove.from, aiMove.to)) return board.getMove(aiMove.from, aiMove.to);
+
+	vector<Move> legalMoves = board.getAllLegalMoves(player);
+
+	if (legalMoves.empty()) return nullopt;
+
+	return legalMoves[game.getSearchRandom().nextInt(legalMoves.size())];
+}
+
+SimulatedGame simulateGame(int index, const SimulationOptions& options) {
+	SimulatedGame result = { index, GameOutcome::PLY_LIMIT, 0, options.seed + index };
+
+	Game game(nullptr, true, result.seed);
+
+	recordGame(game, [&](RecordEntry entry) { result.record.push_back(entry); });
+
+	// Every phase finishes on its first update without animations, so a ply takes a handful of updates
+	int updatesLeft = options.maxPlies * 16;
+
+	while (!game.getGameEnd() && result.plies < options.maxPlies && updatesLeft-- > 0) {
+		if (game.isPlayable()) {
+			optional<Move> move = chooseSimulatedMove(game, options.depth);
+
+			if (!move) break; // No legal moves but the game didn't end, shouldn't happen
+
+			game.getCurrentPlayer().setMove(move.value());
+			result.plies++;
+		}
+
+		game.update();
+	}
+
+	if (game.getGameEnd()) result.outcome = game.getOutcome();
+
+	return result;
+}
+
+int runSelfPlay(const SimulationOptions& options) {
+	ofstream log(options.logPath);
+
+	if (!log.is_open()) {
+		cerr << "Unable to open log file: " << options.logPath << endl;
+		return 1;
+	}
+
+	GameRecordWriter recordWriter;
+
+	if (!options.recordPath.empty() && !recordWriter.open(options.recordPath)) {
+		cerr << "Unable to open game record: " << options.recordPath << endl;
+		return 1;
+	}
+
+	if (!options.bookPath.empty() && !OpeningBook::get().open(options.bookPath)) {
+		cerr << "Unable to open opening book: " << options.bookPath << endl;
+		return 1;
+	}
+
+	if (!options.tablebasePath.empty() && Tablebases::get().open(options.tablebasePath) == 0) {
+		cerr << "No endgame tablebases in: " << options.tablebasePath << endl;
+		return 1;
+	}
+
+	int threadCount = options.threads > 0 ? options.threads : max(1u, thread::hardware_concurrency());
+
+	cout << "Playing " << options.games << " games on " << threadCount << " threads (depth " << options.depth << ")..." << endl;
+
+	log << "# selfplay games=" << options.games << " depth=" << options.depth << " maxPlies=" << options.maxPlies << " seed=" << options.seed << endl;
+
+	// The game logs every step to cout, which would serialize all threads on the console
+	silenceGameLog();
+
+	atomic<int> nextGame{ 0 };
+	atomic<int> finishedGames{ 0 };
+	mutex logMutex;
+
+	int outcomeCounts[5] = { 0 };
+	long long totalPlies = 0;
+
+	auto startTime = chrono::steady_clock::now();
+
+	auto worker = [&]() {
+		int index;
+
+		while ((index = nextGame.fetch_add(1)) < options.games) {
+			SimulatedGame game = simulateGame(index, options);
+
+			lock_guard<mutex> lock(logMutex);
+
+			log << game.index << " " << getOutcomeString(game.outcome) << " " << game.plies << ":";
+
+			for (RecordEntry entry : game.record) log << " " << entry.toString();
+
+			log << "\n";
+
+			recordWriter.writeGame(game.seed, game.record, game.outcome);
+
+			outcomeCounts[(int)game.outcome]++;
+			totalPlies += game.plies;
+
+			int finished = ++finishedGames;
+
+			if (finished % 100 == 0) cerr << finished << "/" << options.games << " games played" << endl;
+		}
+	};
+
+	vector<thread> workers;
+
+	for (int i = 0; i < threadCount; i++) workers.emplace_back(worker);
+	for (thread& thread : workers) thread.join();
+
+	recordWriter.close();
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+	cout << "Done! Took: " << seconds << " seconds (" << options.games / max(seconds, 0.001) << " games per second)" << endl;
+	cout << "Player 1 wins: " << outcomeCounts[(int)GameOutcome::PLAYER_1_WIN] << endl;
+	cout << "Player 2 wins: " << outcomeCounts[(int)GameOutcome::PLAYER_2_WIN] << endl;
+	cout << "Stalemates: " << outcomeCounts[(int)GameOutcome::STALEMATE] << endl;
+	cout << "Ply limit reached: " << outcomeCounts[(int)GameOutcome::PLY_LIMIT] << endl;
+	cout << "Average length: " << (options.games > 0 ? (double)totalPlies / options.games : 0.0) << " plies" << endl;
+
+	return 0;
+}
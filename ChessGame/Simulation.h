@@ -0,0 +1,61 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <string>
+#include <vector>
+#include "GameRecord.h"
+
+using namespace std;
+
+struct SimulationOptions {
+	int games = 100;          // Number of games to play
+	int threads = 0;          // Number of games played at once, 0 for one per core
+	int depth = 2;            // Search depth of both AI players
+	int maxPlies = 300;       // Games that run longer than this are counted as draws
+	unsigned int seed = 1;    // Seed of the first game, every following game adds one
+	string logPath = "selfplay.log";
+	string recordPath = "";   // Binary record of every game, none if empty
+	string bookPath = "";     // Opening book both players use, none if empty
+	string tablebasePath = ""; // Endgame tablebase folder both players use, none if empty
+};
+
+struct SimulatedGame {
+	int index;
+	GameOutcome outcome;
+	int plies;
+
+	uint64_t seed;
+
+	/// <summary>
+	/// Moves, tile spawns, tile moves and promotions in the order they happened
+	/// </summary>
+	vector<RecordEntry> record;
+};
+
+/// <summary>
+/// Reads the options of the --selfplay mode: --selfplay [games] [--threads n] [--depth n] [--plies n] [--seed n] [--log path] [--record path] [--book path] [--tablebases folder]
+/// </summary>
+SimulationOptions parseSimulationOptions(int argc, char** argv);
+
+/// <summary>
+/// Picks the AI's move, falling back to a random legal move if the search disagrees with the board (tile effects it doesn't know about)
+/// </summary>
+/// <returns>The move, or nullopt if there are no legal moves</returns>
+optional<Move> chooseSimulatedMove(Game& game, int depth);
+
+/// <summary>
+/// Plays a single AI vs AI game without a window, audio or animations
+/// </summary>
+/// <param name="index">The number of the game, used for its seed</param>
+/// <param name="options">The settings to play with</param>
+/// <returns>The result and record of the game</returns>
+SimulatedGame simulateGame(int index, const SimulationOptions& options);
+
+/// <summary>
+/// Plays many games across all cores and writes each one to the log as a single line, and to the game record if there is one
+/// </summary>
+/// <param name="options">The settings to play with</param>
+/// <returns>The exit code of the program</returns>
+int runSelfPlay(const SimulationOptions& options);
+
+#endif
@@ -0,0 +1,336 @@
+#include "Socket.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+
+typedef int socklen_t;
+
+#define INVALID_HANDLE ((intptr_t)INVALID_SOCKET)
+
+static bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+static void closeHandle(intptr_t handle) { closesocket((SOCKET)handle); }
+#else
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+
+#define INVALID_HANDLE ((intptr_t)-1)
+
+static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK; }
+static void closeHandle(intptr_t handle) { ::close((int)handle); }
+#endif
+
+bool initSockets() {
+#ifdef _WIN32
+	WSADATA data;
+	return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+	signal(SIGPIPE, SIG_IGN); // Writing to a closed connection fails instead of killing the process
+	return true;
+#endif
+}
+
+void shutdownSockets() {
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+static void setNonBlocking(intptr_t handle) {
+#ifdef _WIN32
+	u_long enabled = 1;
+	ioctlsocket((SOCKET)handle, FIONBIO, &enabled);
+#else
+	fcntl((int)handle, F_SETFL, fcntl((int)handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+static void setNoDelay(intptr_t handle) {
+	int enabled = 1; // Messages are single short lines, they shouldn't wait to be batched
+	setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&enabled, sizeof(enabled));
+}
+
+/************************************|
+			   SOCKET
+|************************************/
+
+Socket::Socket(intptr_t handle) : handle(handle) {}
+
+Socket::~Socket() { close(); }
+
+Socket::Socket(Socket&& other) noexcept : handle(other.handle) { other.handle = INVALID_HANDLE; }
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+	if (this != &other) {
+		close();
+		handle = other.handle;
+		other.handle = INVALID_HANDLE;
+	}
+
+	return *this;
+}
+
+Socket Socket::listen(uint16_t port, const string& host) {
+	intptr_t listener = (intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+	if (listener == INVALID_HANDLE) return Socket();
+
+	Socket result(listener);
+
+	int reuse = 1; // So the server can be restarted straight away on the same port
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	if (!host.empty() && inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) return Socket();
+
+	if (::bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0) return Socket();
+
+	setNonBlocking(listener);
+
+	return result;
+}
+
+Socket Socket::connect(const string& host, uint16_t port) {
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* addresses = nullptr;
+
+	if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &addresses) != 0) return Socket();
+
+	Socket result;
+
+	for (addrinfo* address = addresses; address && !result.isValid(); address = address->ai_next) {
+		intptr_t connection = (intptr_t)socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+		if (connection == INVALID_HANDLE) continue;
+
+		if (::connect(connection, address->ai_addr, (socklen_t)address->ai_addrlen) != 0) {
+			closeHandle(connection);
+			continue;
+		}
+
+		setNonBlocking(connection);
+		setNoDelay(connection);
+
+		result = Socket(connection);
+	}
+
+	freeaddrinfo(addresses);
+
+	return result;
+}
+
+Socket Socket::createWakeSocket() {
+	intptr_t wakeHandle = (intptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	if (wakeHandle == INVALID_HANDLE) return Socket();
+
+	Socket result(wakeHandle);
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0; // Any free port
+
+	socklen_t length = sizeof(address);
+
+	if (::bind(wakeHandle, (sockaddr*)&address, sizeof(address)) != 0) return Socket();
+	if (getsockname(wakeHandle, (sockaddr*)&address, &length) != 0) return Socket();
+	if (::connect(wakeHandle, (sockaddr*)&address, length) != 0) return Socket();
+
+	setNonBlocking(wakeHandle);
+
+	return result;
+}
+
+Socket Socket::accept() {
+	intptr_t connection = (intptr_t)::accept(handle, nullptr, nullptr);
+
+	if (connection == INVALID_HANDLE) return Socket();
+
+	setNonBlocking(connection);
+	setNoDelay(connection);
+
+	return Socket(connection);
+}
+
+int Socket::receive(char* buffer, int size) {
+	int received = (int)::recv(handle, buffer, size, 0);
+
+	if (received >= 0) return received;
+
+	return wouldBlock() ? SOCKET_WOULD_BLOCK : SOCKET_FAILED;
+}
+
+int Socket::send(const char* buffer, int size) {
+#ifdef MSG_NOSIGNAL
+	int sent = (int)::send(handle, buffer, size, MSG_NOSIGNAL);
+#else
+	int sent = (int)::send(handle, buffer, size, 0);
+#endif
+
+	if (sent >= 0) return sent;
+
+	return wouldBlock() ? SOCKET_WOULD_BLOCK : SOCKET_FAILED;
+}
+
+void Socket::wake() {
+	char byte = 0;
+	::send(handle, &byte, 1, 0); // If the buffer is full there's already a wake up waiting
+}
+
+void Socket::drain() {
+	char buffer[256];
+	while (::recv(handle, buffer, sizeof(buffer), 0) > 0);
+}
+
+void Socket::close() {
+	if (handle == INVALID_HANDLE) return;
+
+	closeHandle(handle);
+	handle = INVALID_HANDLE;
+}
+
+bool Socket::isValid() const { return handle != INVALID_HANDLE; }
+
+intptr_t Socket::getHandle() const { return handle; }
+
+/************************************|
+			   POLLER
+|************************************/
+
+#ifdef _WIN32
+
+SocketPoller::SocketPoller() {}
+
+SocketPoller::~SocketPoller() {}
+
+static WSAPOLLFD* getDescriptors(vector<uint8_t>& descriptors) { return (WSAPOLLFD*)descriptors.data(); }
+
+void SocketPoller::add(const Socket& socket, uint64_t key, bool writable) {
+	WSAPOLLFD descriptor = {};
+	descriptor.fd = (SOCKET)socket.getHandle();
+	descriptor.events = POLLRDNORM | (writable ? POLLWRNORM : 0);
+
+	indices[socket.getHandle()] = keys.size();
+	keys.push_back(key);
+
+	descriptors.insert(descriptors.end(), (uint8_t*)&descriptor, (uint8_t*)&descriptor + sizeof(descriptor));
+}
+
+void SocketPoller::modify(const Socket& socket, uint64_t key, bool writable) {
+	auto index = indices.find(socket.getHandle());
+
+	if (index == indices.end()) return;
+
+	keys[index->second] = key;
+	getDescriptors(descriptors)[index->second].events = POLLRDNORM | (writable ? POLLWRNORM : 0);
+}
+
+void SocketPoller::remove(const Socket& socket) {
+	auto index = indices.find(socket.getHandle());
+
+	if (index == indices.end()) return;
+
+	// Move the last socket into the gap so the array stays packed
+	size_t removed = index->second;
+	size_t last = keys.size() - 1;
+
+	WSAPOLLFD* entries = getDescriptors(descriptors);
+
+	if (removed != last) {
+		entries[removed] = entries[last];
+		keys[removed] = keys[last];
+		indices[(intptr_t)entries[removed].fd] = removed;
+	}
+
+	indices.erase(index);
+	keys.pop_back();
+	descriptors.resize(last * sizeof(WSAPOLLFD));
+}
+
+int SocketPoller::wait(vector<SocketEvent>& events, int timeout) {
+	events.clear();
+
+	WSAPOLLFD* entries = getDescriptors(descriptors);
+	ULONG count = (ULONG)keys.size();
+
+	if (count == 0 || WSAPoll(entries, count, timeout) <= 0) return 0;
+
+	for (ULONG i = 0; i < count; i++) {
+		SHORT returned = entries[i].revents;
+
+		if (returned == 0) continue;
+
+		bool failed = returned & (POLLERR | POLLHUP | POLLNVAL);
+
+		events.push_back({ keys[i], (returned & POLLRDNORM) != 0 || failed, (returned & POLLWRNORM) != 0, failed });
+	}
+
+	return (int)events.size();
+}
+
+#else
+
+SocketPoller::SocketPoller() { descriptor = epoll_create1(0); }
+
+SocketPoller::~SocketPoller() {
+	if (descriptor >= 0) ::close(descriptor);
+}
+
+void SocketPoller::add(const Socket& socket, uint64_t key, bool writable) {
+	epoll_event event = {};
+	event.events = EPOLLIN | EPOLLRDHUP | (writable ? (uint32_t)EPOLLOUT : 0u);
+	event.data.u64 = key;
+
+	epoll_ctl(descriptor, EPOLL_CTL_ADD, (int)socket.getHandle(), &event);
+}
+
+void SocketPoller::modify(const Socket& socket, uint64_t key, bool writable) {
+	epoll_event event = {};
+	event.events = EPOLLIN | EPOLLRDHUP | (writable ? (uint32_t)EPOLLOUT : 0u);
+	event.data.u64 = key;
+
+	epoll_ctl(descriptor, EPOLL_CTL_MOD, (int)socket.getHandle(), &event);
+}
+
+void SocketPoller::remove(const Socket& socket) {
+	epoll_ctl(descriptor, EPOLL_CTL_DEL, (int)socket.getHandle(), nullptr);
+}
+
+int SocketPoller::wait(vector<SocketEvent>& events, int timeout) {
+	epoll_event ready[SOCKET_MAX_EVENTS];
+
+	events.clear();
+
+	int count = epoll_wait(descriptor, ready, SOCKET_MAX_EVENTS, timeout);
+
+	for (int i = 0; i < count; i++) {
+		uint32_t returned = ready[i].events;
+
+		bool failed = returned & (EPOLLERR | EPOLLHUP);
+
+		events.push_back({ ready[i].data.u64, (returned & (EPOLLIN | EPOLLRDHUP)) != 0 || failed, (returned & EPOLLOUT) != 0, failed });
+	}
+
+	return (int)events.size();
+}
+
+#endif
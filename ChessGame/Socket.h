@@ -0,0 +1,151 @@
+#ifndef SOCKET_H
+#define SOCKET_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+#define SOCKET_WOULD_BLOCK -1 // Nothing to read, or no room to write, without waiting
+#define SOCKET_FAILED -2
+
+#define SOCKET_MAX_EVENTS 256 // Events taken from epoll per wait, the rest come on the next wait
+
+/// <summary>
+/// Starts the socket library, has to be called before any socket is made (only does anything on Windows)
+/// </summary>
+bool initSockets();
+
+void shutdownSockets();
+
+/// <summary>
+/// A non-blocking TCP or UDP socket, closed when it's destroyed
+/// </summary>
+class Socket {
+	private:
+		// Kept as a plain type so winsock2.h doesn't leak into everything (windows.h clashes with raylib)
+		intptr_t handle = -1;
+
+		explicit Socket(intptr_t handle);
+
+	public:
+		Socket() = default;
+		~Socket();
+
+		Socket(const Socket&) = delete;
+		Socket& operator=(const Socket&) = delete;
+
+		Socket(Socket&& other) noexcept;
+		Socket& operator=(Socket&& other) noexcept;
+
+		/// <summary>
+		/// Opens a TCP socket that accepts connections
+		/// </summary>
+		/// <param name="port">The port to listen on</param>
+		/// <param name="host">The address to listen on, every address if empty</param>
+		/// <returns>The socket, invalid if the port couldn't be bound</returns>
+		static Socket listen(uint16_t port, const string& host = "");
+
+		/// <summary>
+		/// Connects to a TCP server, waiting until the connection is made
+		/// </summary>
+		/// <returns>The socket, invalid if the server couldn't be reached</returns>
+		static Socket connect(const string& host, uint16_t port);
+
+		/// <summary>
+		/// Makes a UDP socket on the loopback address that sends to itself, for waking a poller from another thread
+		/// </summary>
+		static Socket createWakeSocket();
+
+		/// <summary>
+		/// Accepts a waiting connection
+		/// </summary>
+		/// <returns>The connection, invalid if there isn't one</returns>
+		Socket accept();
+
+		/// <summary>
+		/// Reads whatever has arrived
+		/// </summary>
+		/// <returns>The number of bytes read, 0 if the other side closed the connection, SOCKET_WOULD_BLOCK or SOCKET_FAILED</returns>
+		int receive(char* buffer, int size);
+
+		/// <summary>
+		/// Writes as much as fits in the socket's buffer
+		/// </summary>
+		/// <returns>The number of bytes written, SOCKET_WOULD_BLOCK or SOCKET_FAILED</returns>
+		int send(const char* buffer, int size);
+
+		/// <summary>
+		/// Sends a byte to a wake socket, safe to call from any thread
+		/// </summary>
+		void wake();
+
+		/// <summary>
+		/// Reads every pending wake up off a wake socket
+		/// </summary>
+		void drain();
+
+		void close();
+
+		bool isValid() const;
+
+		intptr_t getHandle() const;
+};
+
+struct SocketEvent {
+	uint64_t key;   // The key the socket was added with
+	bool readable;  // Has data, a connection to accept, or was closed
+	bool writable;
+	bool failed;    // Errored or hung up, reading returns 0 or fails
+};
+
+/// <summary>
+/// Waits on many sockets at once, epoll on Linux and WSAPoll on Windows
+/// </summary>
+class SocketPoller {
+	private:
+#ifdef _WIN32
+		// WSAPoll takes the whole list every call, so it's kept as an array ready to pass
+		vector<uint8_t> descriptors; // WSAPOLLFDs, stored as bytes so winsock2.h stays in Socket.cpp
+		vector<uint64_t> keys;
+		unordered_map<intptr_t, size_t> indices;
+#else
+		int descriptor = -1;
+#endif
+
+	public:
+		SocketPoller();
+		~SocketPoller();
+
+		SocketPoller(const SocketPoller&) = delete;
+		SocketPoller& operator=(const SocketPoller&) = delete;
+
+		/// <summary>
+		/// Starts waiting on a socket
+		/// </summary>
+		/// <param name="key">Given back in the socket's events</param>
+		/// <param name="writable">Also wait for room to write</param>
+		void add(const Socket& socket, uint64_t key, bool writable = false);
+
+		/// <summary>
+		/// Changes whether a socket is waited on for room to write
+		/// </summary>
+		void modify(const Socket& socket, uint64_t key, bool writable);
+
+		/// <summary>
+		/// Stops waiting on a socket, has to be called before the socket is closed
+		/// </summary>
+		void remove(const Socket& socket);
+
+		/// <summary>
+		/// Waits until a socket is ready
+		/// </summary>
+		/// <param name="events">Set to the sockets that are ready</param>
+		/// <param name="timeout">Milliseconds to wait, -1 to wait until something happens</param>
+		/// <returns>The number of events</returns>
+		int wait(vector<SocketEvent>& events, int timeout);
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "SoundBank.h"
+#include <iostream>
+#include "AssetManager.h"
+
+// Files for each effect, effects with more than one file pick a random one when played
+static const vector<const char*> soundFiles[SOUND_COUNT] = {
+	{ "resources/pickup.wav" },                                  // SOUND_PICKUP
+	{ "resources/putdown.wav" },                                 // SOUND_PUTDOWN
+	{ "resources/piecetaken.wav" },                              // SOUND_PIECE_TAKEN
+	{ "resources/piecelost.wav" },                               // SOUND_PIECE_LOST
+	{ "resources/icebreak.wav" },                                // SOUND_ICE_BREAK
+	{ "resources/icefrozen.wav" },                               // SOUND_ICE_FROZEN
+	{ "resources/icethaw1.wav", "resources/icethaw2.wav" },      // SOUND_ICE_THAW
+	{ "resources/gamewin.wav" }                                  // SOUND_GAME_WIN
+};
+
+SoundBank::SoundBank() : random(Random::createSeed()) {}
+
+SoundBank::~SoundBank() { unload(); }
+
+void SoundBank::load() {
+	if (loaded || !IsAudioDeviceReady()) return;
+
+	// Effects are decoded on the asset workers and played once they arrive, until then playing them does nothing
+	for (int effect = 0; effect < SOUND_COUNT; effect++) {
+		for (const char* file : soundFiles[effect]) {
+			AssetManager::get().loadWave(file, [this, effect](Wave wave) {
+				if (!loaded || !wave.data) { // Unloaded while it was decoding, or it failed
+					UnloadWave(wave);
+					return;
+				}
+
+				SoundVariant variant;
+				variant.source = LoadSoundFromWave(wave);
+
+				UnloadWave(wave); // The sound has its own copy of the samples
+
+				if (!IsSoundValid(variant.source)) return;
+
+				// The source is the first voice, the rest are aliases so no sample data is duplicated
+				variant.voices.push_back(variant.source);
+
+				for (int voice = 1; voice < SOUND_VOICES; voice++) {
+					variant.voices.push_back(LoadSoundAlias(variant.source));
+				}
+
+				effects[effect].push_back(variant);
+			});
+		}
+	}
+
+	loaded = true;
+}
+
+void SoundBank::unload() {
+	if (!loaded) return;
+
+	for (int effect = 0; effect < SOUND_COUNT; effect++) {
+		for (SoundVariant& variant : effects[effect]) {
+			// Aliases have to be unloaded before the sound that owns the data
+			for (size_t voice = 1; voice < variant.voices.size(); voice++) {
+				UnloadSoundAlias(variant.voices[voice]);
+			}
+
+			UnloadSound(variant.source);
+		}
+
+		effects[effect].clear();
+	}
+
+	loaded = false;
+}
+
+void SoundBank::play(SoundEffect effect, float volume) {
+	if (!loaded || effects[effect].empty()) return;
+
+	SoundVariant& variant = effects[effect][random.nextInt(effects[effect].size())];
+
+	// Prefer a voice that isn't playing, otherwise cut off the oldest one
+	int voiceCount = variant.voices.size();
+	int voice = variant.nextVoice;
+
+	for (int i = 0; i < voiceCount; i++) {
+		int candidate = (variant.nextVoice + i) % voiceCount;
+
+		if (!IsSoundPlaying(variant.voices[candidate])) {
+			voice = candidate;
+			break;
+		}
+	}
+
+	variant.nextVoice = (voice + 1) % voiceCount;
+
+	SetSoundVolume(variant.voices[voice], volume);
+	PlaySound(variant.voices[voice]);
+}
+
+bool SoundBank::isLoaded() { return loaded; }
@@ -0,0 +1,66 @@
+#ifndef SOUNDBANK_H
+#define SOUNDBANK_H
+
+#include "raylib.h"
+#include <vector>
+#include "Random.h"
+
+using namespace std;
+
+#define SOUND_VOICES 4 // Number of copies of each effect that can play over each other
+
+typedef enum {
+	SOUND_PICKUP,
+	SOUND_PUTDOWN,
+	SOUND_PIECE_TAKEN,
+	SOUND_PIECE_LOST,
+	SOUND_ICE_BREAK,
+	SOUND_ICE_FROZEN,
+	SOUND_ICE_THAW,
+	SOUND_GAME_WIN,
+	SOUND_COUNT
+} SoundEffect;
+
+class SoundBank {
+	private:
+		struct SoundVariant {
+			Sound source;          // The loaded sound, owns the sample data
+			vector<Sound> voices;  // Aliases of the source sharing its sample data
+			int nextVoice = 0;
+		};
+
+		vector<SoundVariant> effects[SOUND_COUNT];
+
+		bool loaded = false;
+
+		Random random; // Picks between variants, doesn't affect the game so it isn't seeded by it
+
+	public:
+		SoundBank();
+		~SoundBank();
+
+		SoundBank(const SoundBank&) = delete;
+		SoundBank& operator=(const SoundBank&) = delete;
+
+		/// <summary>
+		/// Starts loading every sound effect on the asset workers, does nothing if the audio device isn't ready.
+		/// Each effect can be played once AssetManager::update() hands it over
+		/// </summary>
+		void load();
+
+		/// <summary>
+		/// Unloads every sound effect and its voices
+		/// </summary>
+		void unload();
+
+		/// <summary>
+		/// Plays a sound effect on a free voice, a random variant is picked if the effect has more than one
+		/// </summary>
+		/// <param name="effect">The effect to play</param>
+		/// <param name="volume">The volume to play it at</param>
+		void play(SoundEffect effect, float volume = 1.0f);
+
+		bool isLoaded();
+};
+
+#endif
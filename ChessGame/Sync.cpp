@@ -0,0 +1,469 @@
+#include "Sync.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "Socket.h"
+#include "Log.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cctype>
+
+static void writeUInt16(vector<uint8_t>& bytes, uint16_t value) {
+	bytes.push_back((uint8_t)value);
+	bytes.push_back((uint8_t)(value >> 8));
+}
+
+static void writeUInt64(vector<uint8_t>& bytes, uint64_t value) {
+	for (int i = 0; i < 8; i++) bytes.push_back((uint8_t)(value >> (i * 8)));
+}
+
+/// <summary>
+/// Reads little endian numbers off a message, failing instead of reading past the end
+/// </summary>
+struct SyncReader {
+	const uint8_t* data;
+	size_t size;
+	size_t offset = 0;
+
+	bool failed = false;
+
+	uint64_t read(int bytes) {
+		if (offset + bytes > size) {
+			failed = true;
+			return 0;
+		}
+
+		uint64_t value = 0;
+		for (int i = 0; i < bytes; i++) value |= (uint64_t)data[offset + i] << (i * 8);
+
+		offset += bytes;
+
+		return value;
+	}
+};
+
+/// <summary>
+/// Gets the cells whose frozen counter is different between two positions
+/// </summary>
+static vector<pair<uint8_t, uint8_t>> getFrozenChanges(const Position& before, const Position& after) {
+	vector<pair<uint8_t, uint8_t>> changes;
+
+	for (int rank = 0; rank < 8; rank++) {
+		for (int file = 0; file < 8; file++) {
+			int frozen = after.pieces[rank][file].frozen;
+
+			if (frozen != before.pieces[rank][file].frozen) changes.push_back({ (uint8_t)(rank * 8 + file), (uint8_t)clamp(frozen, 0, 255) });
+		}
+	}
+
+	return changes;
+}
+
+/************************************|
+			  ENCODER
+|************************************/
+
+SyncEncoder::SyncEncoder(Game& game) : game(game) {
+	recordGame(game, [this](RecordEntry entry) { entries.push_back(entry); });
+
+	lastPosition = game.getPosition();
+}
+
+vector<uint8_t> SyncEncoder::encodeDelta() {
+	sequence++;
+
+	if (game.getGameEnd()) entries.push_back(RecordEntry::end(game.getOutcome()));
+
+	Position position = game.getPosition();
+	vector<pair<uint8_t, uint8_t>> frozenChanges = getFrozenChanges(lastPosition, position);
+
+	vector<uint8_t> bytes;
+	bytes.reserve(5 + entries.size() * 2 + frozenChanges.size() * 2);
+
+	bytes.push_back(SYNC_DELTA);
+	writeUInt16(bytes, sequence);
+
+	bytes.push_back((uint8_t)min(entries.size(), (size_t)255));
+	for (size_t i = 0; i < min(entries.size(), (size_t)255); i++) writeUInt16(bytes, entries[i].bits);
+
+	bytes.push_back((uint8_t)frozenChanges.size());
+	for (auto [cell, turns] : frozenChanges) {
+		bytes.push_back(cell);
+		bytes.push_back(turns);
+	}
+
+	entries.clear();
+	lastPosition = position;
+
+	return bytes;
+}
+
+vector<uint8_t> SyncEncoder::encodeKeyframe() {
+	Board& board = game.getBoard();
+
+	uint64_t state, increment;
+	board.getRandom().getState(state, increment);
+
+	string fen = game.getFEN();
+
+	vector<uint8_t> bytes;
+	bytes.reserve(22 + fen.size());
+
+	bytes.push_back(SYNC_KEYFRAME);
+	writeUInt16(bytes, sequence);
+	writeUInt64(bytes, state);
+	writeUInt64(bytes, increment);
+	bytes.push_back((uint8_t)board.getPortalCounter());
+	writeUInt16(bytes, (uint16_t)fen.size());
+	bytes.insert(bytes.end(), fen.begin(), fen.end());
+
+	return bytes;
+}
+
+bool SyncEncoder::isKeyframeDue() { return sequence % SYNC_KEYFRAME_INTERVAL == 0; }
+
+uint16_t SyncEncoder::getSequence() { return sequence; }
+
+/************************************|
+			  DECODER
+|************************************/
+
+SyncResult SyncDecoder::apply(const uint8_t* message, size_t size) {
+	SyncReader reader = { message, size };
+
+	int type = (int)reader.read(1);
+	uint16_t messageSequence = (uint16_t)reader.read(2);
+
+	if (type == SYNC_KEYFRAME) {
+		uint64_t state = reader.read(8);
+		uint64_t increment = reader.read(8);
+		int portalCounter = (int)reader.read(1);
+		size_t length = (size_t)reader.read(2);
+
+		if (reader.failed || reader.offset + length > size) return SyncResult::MALFORMED;
+
+		GameState snapshot;
+
+		try {
+			snapshot = GameState::fromPosition(parseFEN(string((const char*)message + reader.offset, length)));
+		} catch (const runtime_error&) {
+			return SyncResult::MALFORMED;
+		}
+
+		snapshot.randomState = state;
+		snapshot.randomIncrement = increment;
+		snapshot.portalCounter = (uint16_t)portalCounter;
+
+		if (!game) {
+			game = make_unique<Game>(nullptr, true);
+			recordGame(*game, [this](RecordEntry entry) { entries.push_back(entry); });
+		}
+
+		game->setState(snapshot);
+
+		sequence = messageSequence;
+		synced = true;
+
+		return SyncResult::APPLIED;
+	}
+
+	if (type != SYNC_DELTA) return SyncResult::MALFORMED;
+
+	int entryCount = (int)reader.read(1);
+
+	vector<RecordEntry> expected(entryCount);
+	for (RecordEntry& entry : expected) entry.bits = (uint16_t)reader.read(2);
+
+	int frozenCount = (int)reader.read(1);
+
+	vector<pair<uint8_t, uint8_t>> expectedFrozen(frozenCount);
+	for (auto& [cell, turns] : expectedFrozen) {
+		cell = (uint8_t)reader.read(1);
+		turns = (uint8_t)reader.read(1);
+	}
+
+	if (reader.failed) return SyncResult::MALFORMED;
+
+	// Deltas only make sense on top of the one before
+	if (!synced || messageSequence != (uint16_t)(sequence + 1)) {
+		synced = false;
+		return SyncResult::NEEDS_KEYFRAME;
+	}
+
+	ReplayPly ply;
+	bool hasMove = false;
+
+	for (RecordEntry entry : expected) {
+		if (entry.getTag() == RECORD_MOVE && !hasMove) {
+			ply.move = entry.getMove();
+			hasMove = true;
+		} else if (entry.getTag() == RECORD_PROMOTION) {
+			ply.promotions.push_back({ entry.getPromotionCell(), entry.getPromotionType() });
+		}
+	}
+
+	Position before = game->getPosition();
+
+	entries.clear();
+
+	if (!hasMove || game->getGameEnd() || !Replay::applyPly(*game, ply)) {
+		synced = false;
+		return SyncResult::NEEDS_KEYFRAME;
+	}
+
+	if (game->getGameEnd()) entries.push_back(RecordEntry::end(game->getOutcome()));
+
+	// The copy has to have done exactly what the game did
+	bool matches = entries.size() == expected.size() && equal(entries.begin(), entries.end(), expected.begin(), [](RecordEntry a, RecordEntry b) {
+		return a.bits == b.bits;
+	});
+
+	if (!matches || getFrozenChanges(before, game->getPosition()) != expectedFrozen) {
+		synced = false;
+		return SyncResult::NEEDS_KEYFRAME;
+	}
+
+	sequence = messageSequence;
+
+	return SyncResult::APPLIED;
+}
+
+bool SyncDecoder::isSynced() { return synced; }
+
+Game* SyncDecoder::getGame() { return game.get(); }
+
+/************************************|
+			   BENCH
+|************************************/
+
+/// <summary>
+/// A copy in the bench, with both ends of its loopback connection
+/// </summary>
+struct SyncBenchClient {
+	string name;
+
+	Socket server; // The end the game is sent from
+	Socket client;
+
+	string received;
+
+	SyncDecoder decoder;
+
+	int joinPly = 0;  // Messages before this ply aren't sent, like it wasn't connected yet
+	int dropEvery = 0; // Loses every nth delta, 0 to lose none
+
+	uint64_t bytes = 0;
+	int keyframes = 0;
+	int resyncs = 0;
+	int mismatches = 0; // Plies where the copy was synced but didn't match the game
+};
+
+/// <summary>
+/// Sends a message with a 16 bit length in front, waiting until it's all written
+/// </summary>
+static bool writeFrame(Socket& socket, const vector<uint8_t>& message) {
+	vector<uint8_t> frame;
+	writeUInt16(frame, (uint16_t)message.size());
+	frame.insert(frame.end(), message.begin(), message.end());
+
+	size_t offset = 0;
+
+	while (offset < frame.size()) {
+		int sent = socket.send((const char*)frame.data() + offset, (int)(frame.size() - offset));
+
+		if (sent == SOCKET_FAILED) return false;
+		if (sent > 0) offset += sent;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Waits for the next whole message
+/// </summary>
+static bool readFrame(Socket& socket, string& received, vector<uint8_t>& message) {
+	char buffer[4096];
+
+	while (received.size() < 2 || received.size() < 2 + (size_t)((uint8_t)received[0] | ((uint8_t)received[1] << 8))) {
+		int count = socket.receive(buffer, sizeof(buffer));
+
+		if (count == 0 || count == SOCKET_FAILED) return false;
+		if (count > 0) received.append(buffer, count);
+	}
+
+	size_t length = (uint8_t)received[0] | ((uint8_t)received[1] << 8);
+
+	message.assign(received.begin() + 2, received.begin() + 2 + length);
+	received.erase(0, 2 + length);
+
+	return true;
+}
+
+int runSyncBench(int argc, char** argv) {
+	int games = 20;
+	int depth = 2;
+	int maxPlies = 300;
+	unsigned int seed = 1;
+	uint16_t port = SYNC_BENCH_PORT;
+
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--sync-bench" && hasValue && isdigit(argv[i + 1][0])) games = max(1, atoi(argv[++i]));
+		else if (argument == "--seed" && hasValue) seed = strtoul(argv[++i], nullptr, 10);
+		else if (argument == "--depth" && hasValue) depth = max(1, atoi(argv[++i]));
+		else if (argument == "--plies" && hasValue) maxPlies = atoi(argv[++i]);
+		else if (argument == "--port" && hasValue) port = (uint16_t)atoi(argv[++i]);
+	}
+
+	if (!initSockets()) {
+		cerr << "Unable to start sockets" << endl;
+		return 1;
+	}
+
+	Socket listener = Socket::listen(port, "127.0.0.1");
+
+	if (!listener.isValid()) {
+		cerr << "Unable to listen on port " << port << endl;
+		return 1;
+	}
+
+	cout << "Syncing " << games << " games over loopback (depth " << depth << ")..." << endl;
+
+	// The games log every step to cout
+	silenceGameLog();
+
+	long long plies = 0;
+	uint64_t deltaBytes = 0;
+	size_t largestDelta = 0;
+	uint64_t keyframeBytes = 0;
+	int keyframes = 0;
+	uint64_t fenBytes = 0; // What sending the whole position every ply would cost
+
+	vector<SyncBenchClient> totals(3);
+
+	auto startTime = chrono::steady_clock::now();
+
+	for (int index = 0; index < games; index++) {
+		Game game(nullptr, true, (uint64_t)seed + index);
+		SyncEncoder encoder(game);
+
+		vector<SyncBenchClient> clients(3);
+		clients[0].name = "Spectator";
+		clients[1].name = "Late joiner";
+		clients[1].joinPly = 20;
+		clients[2].name = "Lossy";
+		clients[2].dropEvery = 25;
+
+		for (SyncBenchClient& client : clients) {
+			client.client = Socket::connect("127.0.0.1", port);
+
+			while (!(client.server = listener.accept()).isValid());
+		}
+
+		// Sends a message to a copy and applies it there, sending a keyframe if it asks for one
+		auto deliver = [&](SyncBenchClient& client, const vector<uint8_t>& message) {
+			vector<uint8_t> received;
+
+			if (!writeFrame(client.server, message) || !readFrame(client.client, client.received, received)) return false;
+
+			client.bytes += 2 + message.size();
+
+			SyncResult result = client.decoder.apply(received.data(), received.size());
+
+			if (received[0] == SYNC_KEYFRAME) client.keyframes++;
+
+			// Joining or falling out of sync asks for a keyframe, like a real client would
+			if (result == SyncResult::NEEDS_KEYFRAME) {
+				client.resyncs++;
+
+				vector<uint8_t> keyframe = encoder.encodeKeyframe();
+
+				if (!writeFrame(client.server, keyframe) || !readFrame(client.client, client.received, received)) return false;
+
+				client.bytes += 2 + keyframe.size();
+				client.keyframes++;
+
+				result = client.decoder.apply(received.data(), received.size());
+			}
+
+			return result == SyncResult::APPLIED;
+		};
+
+		for (SyncBenchClient& client : clients) {
+			if (client.joinPly == 0) deliver(client, encoder.encodeKeyframe());
+		}
+
+		int gamePlies = 0;
+
+		while (!game.getGameEnd() && gamePlies < maxPlies) {
+			optional<Move> move = chooseSimulatedMove(game, depth);
+
+			if (!move) break;
+
+			Replay::applyPly(game, { move.value(), {} });
+			gamePlies++;
+
+			vector<uint8_t> delta = encoder.encodeDelta();
+			string fen = game.getFEN();
+
+			deltaBytes += 2 + delta.size();
+			largestDelta = max(largestDelta, delta.size() + 2);
+			fenBytes += 2 + fen.size();
+
+			for (SyncBenchClient& client : clients) {
+				if (gamePlies < client.joinPly) continue;
+				if (client.dropEvery > 0 && gamePlies % client.dropEvery == 0) continue; // Lost on the way
+
+				if (!deliver(client, delta)) {
+					cerr << client.name << " couldn't apply ply " << gamePlies << " of game " << index << endl;
+					return 1;
+				}
+
+				if (client.decoder.getGame()->getFEN() != fen) client.mismatches++;
+			}
+
+			if (encoder.isKeyframeDue()) {
+				vector<uint8_t> keyframe = encoder.encodeKeyframe();
+
+				keyframeBytes += 2 + keyframe.size();
+				keyframes++;
+
+				for (SyncBenchClient& client : clients) {
+					if (gamePlies >= client.joinPly) deliver(client, keyframe);
+				}
+			}
+		}
+
+		plies += gamePlies;
+
+		for (size_t i = 0; i < clients.size(); i++) {
+			totals[i].name = clients[i].name;
+			totals[i].bytes += clients[i].bytes;
+			totals[i].keyframes += clients[i].keyframes;
+			totals[i].resyncs += clients[i].resyncs;
+			totals[i].mismatches += clients[i].mismatches;
+		}
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+	cout << "Done! Took: " << seconds << " seconds, " << plies << " plies" << endl;
+	cout << "Delta: " << (plies > 0 ? (double)deltaBytes / plies : 0.0) << " bytes per ply on average, " << largestDelta << " at most" << endl;
+	cout << "Keyframe: " << (keyframes > 0 ? (double)keyframeBytes / keyframes : 0.0) << " bytes on average" << endl;
+	cout << "Whole position every ply: " << (plies > 0 ? (double)fenBytes / plies : 0.0) << " bytes per ply" << endl;
+
+	bool failed = false;
+
+	for (SyncBenchClient& client : totals) {
+		cout << client.name << ": " << client.bytes << " bytes, " << client.keyframes << " keyframes, " << client.resyncs << " resyncs, " << client.mismatches << " mismatches" << endl;
+
+		failed |= client.mismatches > 0;
+	}
+
+	shutdownSockets();
+
+	return failed ? 1 : 0;
+}
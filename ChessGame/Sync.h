@@ -0,0 +1,124 @@
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "game.h"
+#include "GameRecord.h"
+
+using namespace std;
+
+/*
+	Binary protocol for keeping remote copies of a game in sync, all numbers are little endian:
+
+	Delta (sent after every ply):
+		uint8   SYNC_DELTA
+		uint16  sequence            Number of the ply, wraps around
+		uint8   entry count
+		uint16  entries...          RecordEntry bits: the move, then the tile moves, promotions and spawns it caused,
+		                            and RECORD_END if the game ended
+		uint8   frozen count
+		        frozen changes...   uint8 cell (rank * 8 + file) and uint8 turns left, for every cell whose counter changed
+
+	Keyframe (sent every SYNC_KEYFRAME_INTERVAL plies, and to anyone joining or out of sync):
+		uint8   SYNC_KEYFRAME
+		uint16  sequence            Of the last ply played, the next delta is one more
+		uint64  random state        The board's random numbers, so tile spawns can be played out the same
+		uint64  random increment
+		uint8   portal counter
+		uint16  FEN length
+		        FEN                 With the tile and frozen fields
+
+	A copy plays the delta's move with the board rules and checks that it caused what the delta says. A missing sequence
+	number or a delta that doesn't match means the copy is out of sync, and it waits for the next keyframe.
+*/
+
+#define SYNC_DELTA 1
+#define SYNC_KEYFRAME 2
+
+#define SYNC_KEYFRAME_INTERVAL 32 // Plies between keyframes, the longest a late joiner waits without asking for one
+
+#define SYNC_BENCH_PORT 7374
+
+enum class SyncResult {
+	APPLIED,
+	NEEDS_KEYFRAME, // No keyframe yet, a sequence number was skipped, or the delta didn't match the copy
+	MALFORMED
+};
+
+/// <summary>
+/// Turns what happens in a game into deltas and keyframes, call encodeDelta after every ply
+/// </summary>
+class SyncEncoder {
+	private:
+		Game& game;
+
+		uint16_t sequence = 0;
+
+		vector<RecordEntry> entries; // What happened since the last delta
+
+		Position lastPosition; // For the frozen counters that changed
+
+	public:
+		/// <summary>
+		/// Starts recording the game, replacing any record hooks it had
+		/// </summary>
+		SyncEncoder(Game& game);
+
+		/// <summary>
+		/// Gets the delta of the ply that was just played
+		/// </summary>
+		vector<uint8_t> encodeDelta();
+
+		/// <summary>
+		/// Gets the whole state of the game
+		/// </summary>
+		vector<uint8_t> encodeKeyframe();
+
+		/// <summary>
+		/// Determines if the last ply is one that a keyframe should go out after
+		/// </summary>
+		bool isKeyframeDue();
+
+		uint16_t getSequence();
+};
+
+/// <summary>
+/// A copy of a remote game kept up to date from deltas and keyframes
+/// </summary>
+class SyncDecoder {
+	private:
+		unique_ptr<Game> game; // Null until the first keyframe
+
+		uint16_t sequence = 0;
+
+		bool synced = false;
+
+		vector<RecordEntry> entries; // What the copy did while playing the last delta
+
+	public:
+		/// <summary>
+		/// Applies a delta or keyframe
+		/// </summary>
+		SyncResult apply(const uint8_t* message, size_t size);
+
+		bool isSynced();
+
+		/// <summary>
+		/// Gets the copy of the game, null before the first keyframe
+		/// </summary>
+		Game* getGame();
+};
+
+/// <summary>
+/// Reads the options of the --sync-bench mode and runs it: --sync-bench [games] [--seed n] [--depth n] [--port n]
+/// Plays AI vs AI games and syncs them over a loopback connection to a spectator from the start, one that joins late
+/// and one that loses deltas, checking every copy against the game and counting the bytes sent
+/// </summary>
+/// <returns>The exit code of the program</returns>
+int runSyncBench(int argc, char** argv);
+
+#endif
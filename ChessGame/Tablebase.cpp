@@ -0,0 +1,1033 @@
+#include "Tablebase.h"
+#include "Profiler.h"
+#include "Log.h"
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <chrono>
+
+static const char WDL_MAGIC[4] = { 'C', 'G', 'T', 'W' };
+static const char DTM_MAGIC[4] = { 'C', 'G', 'T', 'D' };
+
+// Pieces in the order they are listed in an ending, strongest first
+static const PieceType ENDING_PIECES[] = { PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT, PieceType::PAWN };
+
+static const PieceType PROMOTION_PIECES[] = { PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP, PieceType::KNIGHT };
+
+static int getPieceOrder(PieceType type) {
+	for (int i = 0; i < 5; i++) {
+		if (ENDING_PIECES[i] == type) return i;
+	}
+
+	return 5;
+}
+
+/************************************|
+			  LAYOUT
+|************************************/
+
+// Slot of every cell the white king can be mirrored into, -1 for the rest
+// Without pawns the king is kept in the a1-d1-d4 triangle, with pawns only in files a to d
+static int triangleSlots[64];
+static int halfSlots[64];
+static int triangleCells[10];
+static int halfCells[32];
+
+static void initSlots() {
+	static bool initialized = false;
+
+	if (initialized) return;
+
+	int triangleCount = 0;
+	int halfCount = 0;
+
+	for (int cell = 0; cell < 64; cell++) {
+		int rank = cell / 8;
+		int file = cell % 8;
+
+		triangleSlots[cell] = -1;
+		halfSlots[cell] = -1;
+
+		if (file <= 3 && rank <= file) {
+			triangleCells[triangleCount] = cell;
+			triangleSlots[cell] = triangleCount++;
+		}
+
+		if (file <= 3) {
+			halfCells[halfCount] = cell;
+			halfSlots[cell] = halfCount++;
+		}
+	}
+
+	initialized = true;
+}
+
+/// <summary>
+/// Mirrors a cell (rank * 8 + file), bit 0 flips the files, bit 1 the ranks and bit 2 the diagonal
+/// </summary>
+static int transformCell(int cell, int transform) {
+	int rank = cell / 8;
+	int file = cell % 8;
+
+	if (transform & 4) swap(rank, file);
+	if (transform & 1) file = 7 - file;
+	if (transform & 2) rank = 7 - rank;
+
+	return rank * 8 + file;
+}
+
+/// <summary>
+/// The pieces of an ending in the order they are indexed: white king, black king, then the rest of white's and black's pieces
+/// </summary>
+struct EndingLayout {
+	string name;
+
+	int count = 0;
+	PieceType types[TABLEBASE_MAX_PIECES];
+	int players[TABLEBASE_MAX_PIECES];
+
+	bool hasPawns = false;
+	int pawnCount = 0;
+
+	uint64_t sideSize = 0; // Positions for one side to move
+
+	uint64_t getEntries() const { return sideSize * 2; }
+
+	/// <summary>
+	/// Gets the index of a position, trying every mirror so symmetric positions share one index
+	/// </summary>
+	/// <param name="cells">The cell of every piece, in the order of the layout</param>
+	/// <param name="side">0 if white is to move, 1 if black is</param>
+	uint64_t getIndex(const int* cells, int side) const {
+		uint64_t best = UINT64_MAX;
+		int transforms = hasPawns ? 2 : 8; // Pawns can only be mirrored left to right
+
+		for (int transform = 0; transform < transforms; transform++) {
+			int mapped[TABLEBASE_MAX_PIECES];
+
+			for (int i = 0; i < count; i++) mapped[i] = transformCell(cells[i], transform);
+
+			int slot = hasPawns ? halfSlots[mapped[0]] : triangleSlots[mapped[0]];
+
+			if (slot < 0) continue;
+
+			// Pieces of the same type and colour can swap places, so keep them sorted
+			for (int i = 2; i < count; i++) {
+				for (int j = i + 1; j < count; j++) {
+					if (types[i] == types[j] && players[i] == players[j] && mapped[j] < mapped[i]) swap(mapped[i], mapped[j]);
+				}
+			}
+
+			uint64_t index = slot;
+
+			for (int i = 1; i < count; i++) index = index * 64 + mapped[i];
+
+			best = min(best, index);
+		}
+
+		return best + side * sideSize;
+	}
+
+	/// <summary>
+	/// Gets the position at an index, it may not be legal or be the canonical form of itself
+	/// </summary>
+	void getCells(uint64_t index, int* cells, int& side) const {
+		side = (int)(index / sideSize);
+		index %= sideSize;
+
+		for (int i = count - 1; i >= 1; i--) {
+			cells[i] = (int)(index % 64);
+			index /= 64;
+		}
+
+		cells[0] = hasPawns ? halfCells[index] : triangleCells[index];
+	}
+};
+
+static EndingLayout createLayout(const vector<PieceType>& white, const vector<PieceType>& black) {
+	EndingLayout layout;
+
+	layout.name = "K";
+	layout.types[0] = PieceType::KING;
+	layout.players[0] = 1;
+	layout.types[1] = PieceType::KING;
+	layout.players[1] = 2;
+	layout.count = 2;
+
+	for (PieceType type : white) {
+		layout.name += getPieceString(type);
+		layout.types[layout.count] = type;
+		layout.players[layout.count++] = 1;
+	}
+
+	layout.name += "vK";
+
+	for (PieceType type : black) {
+		layout.name += getPieceString(type);
+		layout.types[layout.count] = type;
+		layout.players[layout.count++] = 2;
+	}
+
+	for (int i = 0; i < layout.count; i++) {
+		if (layout.types[i] == PieceType::PAWN) layout.pawnCount++;
+	}
+
+	layout.hasPawns = layout.pawnCount > 0;
+	layout.sideSize = layout.hasPawns ? 32 : 10;
+
+	for (int i = 1; i < layout.count; i++) layout.sideSize *= 64;
+
+	return layout;
+}
+
+/// <summary>
+/// Compares the pieces of two sides (without kings, strongest first), more pieces or stronger ones count as more
+/// </summary>
+static int compareSides(const vector<PieceType>& a, const vector<PieceType>& b) {
+	if (a.size() != b.size()) return a.size() > b.size() ? 1 : -1;
+
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i] != b[i]) return getPieceOrder(a[i]) < getPieceOrder(b[i]) ? 1 : -1;
+	}
+
+	return 0;
+}
+
+static void sortSide(vector<PieceType>& side) {
+	sort(side.begin(), side.end(), [](PieceType a, PieceType b) { return getPieceOrder(a) < getPieceOrder(b); });
+}
+
+/// <summary>
+/// Every ending up to a number of pieces, with the stronger side as white, in the order they have to be generated in
+/// </summary>
+static vector<EndingLayout> getEndings(int maxPieces) {
+	vector<vector<PieceType>> sides = { {} };
+
+	for (int count = 1; count <= maxPieces - 2; count++) {
+		vector<vector<PieceType>> extended;
+
+		for (const vector<PieceType>& side : sides) {
+			if ((int)side.size() != count - 1) continue;
+
+			// Only add pieces that are as weak or weaker than the last one, so every set of pieces is made once
+			int first = side.empty() ? 0 : getPieceOrder(side.back());
+
+			for (int i = first; i < 5; i++) {
+				vector<PieceType> next = side;
+				next.push_back(ENDING_PIECES[i]);
+				extended.push_back(next);
+			}
+		}
+
+		sides.insert(sides.end(), extended.begin(), extended.end());
+	}
+
+	vector<EndingLayout> endings;
+
+	for (const vector<PieceType>& white : sides) {
+		for (const vector<PieceType>& black : sides) {
+			if (white.empty() || (int)(white.size() + black.size()) + 2 > maxPieces) continue;
+			if (compareSides(white, black) < 0) continue;
+
+			endings.push_back(createLayout(white, black));
+		}
+	}
+
+	// Captures lead to endings with fewer pieces and promotions to endings with fewer pawns, so those have to be done first
+	stable_sort(endings.begin(), endings.end(), [](const EndingLayout& a, const EndingLayout& b) {
+		if (a.count != b.count) return a.count < b.count;
+		return a.pawnCount < b.pawnCount;
+	});
+
+	return endings;
+}
+
+/// <summary>
+/// Finds the ending of a position and the index of the position in it
+/// </summary>
+/// <returns>false if the position has too many pieces or only kings</returns>
+static bool getEnding(const TablebasePosition& position, EndingLayout& layout, uint64_t& index) {
+	if (position.count > TABLEBASE_MAX_PIECES || position.count <= 2) return false;
+
+	vector<PieceType> white;
+	vector<PieceType> black;
+
+	for (int i = 0; i < position.count; i++) {
+		const TablebasePiece& piece = position.pieces[i];
+
+		if (piece.type == PieceType::KING) continue;
+
+		(piece.player == 1 ? white : black).push_back(piece.type);
+	}
+
+	sortSide(white);
+	sortSide(black);
+
+	// The files only have the stronger side as white, so flip the board and colours if black is stronger
+	bool swapColours = compareSides(white, black) < 0;
+
+	layout = swapColours ? createLayout(black, white) : createLayout(white, black);
+
+	int cells[TABLEBASE_MAX_PIECES];
+	bool used[TABLEBASE_MAX_PIECES] = { false, false, false, false };
+
+	for (int i = 0; i < layout.count; i++) {
+		int found = -1;
+
+		for (int j = 0; j < position.count && found < 0; j++) {
+			const TablebasePiece& piece = position.pieces[j];
+			int player = swapColours ? 3 - piece.player : piece.player;
+
+			if (!used[j] && piece.type == layout.types[i] && player == layout.players[i]) found = j;
+		}
+
+		if (found < 0) return false;
+
+		used[found] = true;
+
+		const Cell& cell = position.pieces[found].cell;
+		cells[i] = (swapColours ? 7 - cell.rank : cell.rank) * 8 + cell.file;
+	}
+
+	int side = position.sideToMove == 1 ? 0 : 1;
+	if (swapColours) side = 1 - side;
+
+	index = layout.getIndex(cells, side);
+
+	return true;
+}
+
+/************************************|
+			 TABLEBASES
+|************************************/
+
+Tablebases& Tablebases::get() {
+	static Tablebases tablebases;
+	return tablebases;
+}
+
+/// <summary>
+/// Checks the header of a tablebase file
+/// </summary>
+/// <returns>The number of positions in the file, 0 if it isn't valid</returns>
+static uint64_t readHeader(const MemoryMappedFile& file, const char* magic, const string& ending, uint64_t bitsPerEntry) {
+	TablebaseHeader header;
+
+	if (file.getSize() < sizeof(header)) return 0;
+
+	memcpy(&header, file.getData(), sizeof(header));
+
+	if (memcmp(header.magic, magic, 4) != 0 || header.version != TABLEBASE_VERSION) return 0;
+	if (strncmp(header.ending, ending.c_str(), sizeof(header.ending)) != 0) return 0;
+	if ((header.entries * bitsPerEntry + 7) / 8 > file.getSize() - sizeof(header)) return 0;
+
+	return header.entries;
+}
+
+bool Tablebases::openTable(const string& directory, const string& ending) {
+	unique_ptr<Table> table = make_unique<Table>();
+
+	string path = directory + "/" + ending;
+
+	if (!table->wdl.open(path + ".wdl") || !table->dtm.open(path + ".dtm")) return false;
+
+	uint64_t wdlEntries = readHeader(table->wdl, WDL_MAGIC, ending, 2);
+	uint64_t dtmEntries = readHeader(table->dtm, DTM_MAGIC, ending, 8);
+
+	if (wdlEntries == 0 || wdlEntries != dtmEntries) {
+		GAME_LOG("Tablebase " << path << " is not a valid tablebase" << endl);
+		return false;
+	}
+
+	table->entries = wdlEntries;
+	tables[ending] = move(table);
+
+	return true;
+}
+
+int Tablebases::open(const string& directory) {
+	close();
+
+	initSlots();
+
+	for (const EndingLayout& layout : getEndings(TABLEBASE_MAX_PIECES)) openTable(directory, layout.name);
+
+	if (!tables.empty()) GAME_LOG("Loaded " << tables.size() << " endgame tablebases from " << directory << endl);
+
+	return (int)tables.size();
+}
+
+void Tablebases::close() { tables.clear(); }
+
+bool Tablebases::isOpen() { return !tables.empty(); }
+
+Tablebases::Table* Tablebases::findTable(const TablebasePosition& position, uint64_t& index) {
+	EndingLayout layout;
+
+	if (!getEnding(position, layout, index)) return nullptr;
+
+	auto table = tables.find(layout.name);
+
+	if (table == tables.end() || index >= table->second->entries) return nullptr;
+
+	return table->second.get();
+}
+
+/// <summary>
+/// Only kings left, which can never be won
+/// </summary>
+static bool isBareKings(const TablebasePosition& position) {
+	if (position.count != 2) return false;
+
+	return position.pieces[0].type == PieceType::KING && position.pieces[1].type == PieceType::KING;
+}
+
+optional<TablebaseWDL> Tablebases::probeWDL(const TablebasePosition& position) {
+	if (isBareKings(position)) return TablebaseWDL::DRAW;
+
+	uint64_t index;
+	Table* table = findTable(position, index);
+
+	if (!table) return nullopt;
+
+	uint8_t packed = table->wdl.getData()[sizeof(TablebaseHeader) + index / 4];
+
+	switch ((packed >> ((index % 4) * 2)) & 3) {
+		case 1: return TablebaseWDL::WIN;
+		case 2: return TablebaseWDL::LOSS;
+		default: return TablebaseWDL::DRAW;
+	}
+}
+
+optional<TablebaseResult> Tablebases::probeDTM(const TablebasePosition& position) {
+	if (isBareKings(position)) return TablebaseResult{ TablebaseWDL::DRAW, 0 };
+
+	uint64_t index;
+	Table* table = findTable(position, index);
+
+	if (!table) return nullopt;
+
+	uint8_t value = table->dtm.getData()[sizeof(TablebaseHeader) + index];
+
+	if (value == 0) return TablebaseResult{ TablebaseWDL::DRAW, 0 };
+
+	int dtm = value - 1;
+
+	// The side that mates always makes the last move, so an odd number of plies is a win
+	return TablebaseResult{ dtm % 2 == 1 ? TablebaseWDL::WIN : TablebaseWDL::LOSS, dtm };
+}
+
+/************************************|
+			 GENERATOR
+|************************************/
+
+TablebaseOptions parseTablebaseOptions(int argc, char** argv) {
+	TablebaseOptions options;
+
+	for (int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--generate-tablebases" && hasValue && strncmp(argv[i + 1], "--", 2) != 0) options.directory = argv[++i];
+		else if (argument == "--tb-pieces" && hasValue) options.maxPieces = clamp(atoi(argv[++i]), 3, TABLEBASE_MAX_PIECES);
+	}
+
+	return options;
+}
+
+// Values of positions while generating, otherwise the plies to mate + 1 like in the DTM files
+#define TB_UNKNOWN 0   // Not solved yet, draws stay like this
+#define TB_INVALID 255 // Not a legal position, or not the canonical index of it
+
+// Longest mate that fits in a byte
+#define TB_MAX_DTM 253
+
+static const int KNIGHT_OFFSETS[8][2] = { {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2} };
+static const int KING_OFFSETS[8][2] = { {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1} };
+static const int ROOK_DIRECTIONS[4][2] = { {1, 0}, {0, 1}, {-1, 0}, {0, -1} };
+static const int BISHOP_DIRECTIONS[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+static bool isOnBoard(int rank, int file) { return rank >= 0 && rank <= 7 && file >= 0 && file <= 7; }
+
+/// <summary>
+/// A position of an ending with a board to look up the pieces by cell
+/// </summary>
+struct EndingBoard {
+	int count = 0;
+	PieceType types[TABLEBASE_MAX_PIECES];
+	int players[TABLEBASE_MAX_PIECES];
+	int cells[TABLEBASE_MAX_PIECES];
+
+	int8_t board[64]; // Index of the piece on every cell, -1 if empty
+
+	void build() {
+		memset(board, -1, sizeof(board));
+
+		for (int i = 0; i < count; i++) board[cells[i]] = (int8_t)i;
+	}
+
+	int findKing(int player) const {
+		for (int i = 0; i < count; i++) {
+			if (types[i] == PieceType::KING && players[i] == player) return cells[i];
+		}
+
+		return -1;
+	}
+
+	bool isSliderAttacking(int from, int target, const int directions[4][2]) const {
+		for (int d = 0; d < 4; d++) {
+			int rank = from / 8 + directions[d][0];
+			int file = from % 8 + directions[d][1];
+
+			while (isOnBoard(rank, file)) {
+				int cell = rank * 8 + file;
+
+				if (cell == target) return true;
+				if (board[cell] >= 0) break;
+
+				rank += directions[d][0];
+				file += directions[d][1];
+			}
+		}
+
+		return false;
+	}
+
+	bool isAttacked(int target, int byPlayer) const {
+		int targetRank = target / 8;
+		int targetFile = target % 8;
+
+		for (int i = 0; i < count; i++) {
+			if (players[i] != byPlayer) continue;
+
+			int rank = cells[i] / 8;
+			int file = cells[i] % 8;
+			int rankDistance = abs(targetRank - rank);
+			int fileDistance = abs(targetFile - file);
+
+			switch (types[i]) {
+				case PieceType::PAWN:
+					if (targetRank - rank == (byPlayer == 1 ? 1 : -1) && fileDistance == 1) return true;
+					break;
+
+				case PieceType::KNIGHT:
+					if ((rankDistance == 1 && fileDistance == 2) || (rankDistance == 2 && fileDistance == 1)) return true;
+					break;
+
+				case PieceType::KING:
+					if (max(rankDistance, fileDistance) == 1) return true;
+					break;
+
+				case PieceType::ROOK:
+					if ((rankDistance == 0 || fileDistance == 0) && isSliderAttacking(cells[i], target, ROOK_DIRECTIONS)) return true;
+					break;
+
+				case PieceType::BISHOP:
+					if (rankDistance == fileDistance && isSliderAttacking(cells[i], target, BISHOP_DIRECTIONS)) return true;
+					break;
+
+				case PieceType::QUEEN:
+					if ((rankDistance == 0 || fileDistance == 0) && isSliderAttacking(cells[i], target, ROOK_DIRECTIONS)) return true;
+					if (rankDistance == fileDistance && isSliderAttacking(cells[i], target, BISHOP_DIRECTIONS)) return true;
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		return false;
+	}
+
+	bool isInCheck(int player) const { return isAttacked(findKing(player), 3 - player); }
+
+	TablebasePosition toPosition(int sideToMove) const {
+		TablebasePosition position;
+
+		for (int i = 0; i < count; i++) position.pieces[i] = { types[i], players[i], Cell(cells[i] / 8, cells[i] % 8) };
+
+		position.count = count;
+		position.sideToMove = sideToMove;
+
+		return position;
+	}
+};
+
+struct EndingMove {
+	int piece;
+	int to;
+	PieceType promotion; // NO_PIECE if the move doesn't promote
+};
+
+/// <summary>
+/// Solves one ending by working backwards from every mate, one ply at a time
+/// </summary>
+class EndingGenerator {
+	private:
+		const EndingLayout& layout;
+
+		vector<uint8_t> values;
+
+		vector<vector<uint32_t>> exitWins;   // Positions that can win by leaving the ending, by the ply of the win
+		vector<vector<uint32_t>> exitLosses; // Positions where leaving the ending loses, by the ply it loses at
+
+		EndingBoard getBoard(uint64_t index, int& side) const {
+			EndingBoard board;
+			board.count = layout.count;
+
+			for (int i = 0; i < layout.count; i++) {
+				board.types[i] = layout.types[i];
+				board.players[i] = layout.players[i];
+			}
+
+			layout.getCells(index, board.cells, side);
+			board.build();
+
+			return board;
+		}
+
+		bool isValid(uint64_t index) const {
+			int side;
+			EndingBoard board = getBoard(index, side);
+
+			for (int i = 0; i < board.count; i++) {
+				if (board.board[board.cells[i]] != i) return false; // Two pieces on one cell
+
+				int rank = board.cells[i] / 8;
+				if (board.types[i] == PieceType::PAWN && (rank == 0 || rank == 7)) return false;
+			}
+
+			if (layout.getIndex(board.cells, side) != index) return false;
+
+			// The side that just moved can't be left in check
+			int sideToMove = side == 0 ? 1 : 2;
+			return !board.isInCheck(3 - sideToMove);
+		}
+
+		void addPieceMove(const EndingBoard& board, int piece, int rank, int file, vector<EndingMove>& moves, bool quiet, bool captures) const {
+			if (!isOnBoard(rank, file)) return;
+
+			int cell = rank * 8 + file;
+			int target = board.board[cell];
+
+			if (target < 0 && quiet) moves.push_back({ piece, cell, PieceType::NO_PIECE });
+			else if (target >= 0 && captures && board.players[target] != board.players[piece] && board.types[target] != PieceType::KING) {
+				moves.push_back({ piece, cell, PieceType::NO_PIECE });
+			}
+		}
+
+		void addPawnMove(int piece, int cell, vector<EndingMove>& moves) const {
+			int rank = cell / 8;
+
+			if (rank == 0 || rank == 7) {
+				for (PieceType promotion : PROMOTION_PIECES) moves.push_back({ piece, cell, promotion });
+			}
+			else moves.push_back({ piece, cell, PieceType::NO_PIECE });
+		}
+
+		/// <summary>
+		/// Gets every move of a player, without checking if it leaves the king in check
+		/// </summary>
+		void getMoves(const EndingBoard& board, int player, vector<EndingMove>& moves) const {
+			moves.clear();
+
+			for (int i = 0; i < board.count; i++) {
+				if (board.players[i] != player) continue;
+
+				int rank = board.cells[i] / 8;
+				int file = board.cells[i] % 8;
+
+				switch (board.types[i]) {
+					case PieceType::PAWN: {
+						int direction = player == 1 ? 1 : -1;
+						int forward = (rank + direction) * 8 + file;
+
+						if (board.board[forward] < 0) {
+							addPawnMove(i, forward, moves);
+
+							int startRank = player == 1 ? 1 : 6;
+							int doubleForward = (rank + direction * 2) * 8 + file;
+
+							if (rank == startRank && board.board[doubleForward] < 0) moves.push_back({ i, doubleForward, PieceType::NO_PIECE });
+						}
+
+						for (int side = -1; side <= 1; side += 2) {
+							if (!isOnBoard(rank + direction, file + side)) continue;
+
+							int target = board.board[(rank + direction) * 8 + file + side];
+
+							if (target >= 0 && board.players[target] != player && board.types[target] != PieceType::KING) {
+								addPawnMove(i, (rank + direction) * 8 + file + side, moves);
+							}
+						}
+						break;
+					}
+
+					case PieceType::KNIGHT:
+						for (const auto& offset : KNIGHT_OFFSETS) addPieceMove(board, i, rank + offset[0], file + offset[1], moves, true, true);
+						break;
+
+					case PieceType::KING:
+						for (const auto& offset : KING_OFFSETS) addPieceMove(board, i, rank + offset[0], file + offset[1], moves, true, true);
+						break;
+
+					default: {
+						bool straight = board.types[i] == PieceType::ROOK || board.types[i] == PieceType::QUEEN;
+						bool diagonal = board.types[i] == PieceType::BISHOP || board.types[i] == PieceType::QUEEN;
+
+						for (int d = 0; d < 8; d++) {
+							if (d < 4 ? !straight : !diagonal) continue;
+
+							const int* direction = d < 4 ? ROOK_DIRECTIONS[d] : BISHOP_DIRECTIONS[d - 4];
+
+							for (int r = rank + direction[0], f = file + direction[1]; isOnBoard(r, f); r += direction[0], f += direction[1]) {
+								addPieceMove(board, i, r, f, moves, true, true);
+
+								if (board.board[r * 8 + f] >= 0) break;
+							}
+						}
+						break;
+					}
+				}
+			}
+		}
+
+		/// <summary>
+		/// Plays a move on a copy of the board
+		/// </summary>
+		/// <returns>The board after the move, with captured pieces taken out</returns>
+		EndingBoard makeMove(const EndingBoard& board, const EndingMove& move, bool& leftEnding) const {
+			EndingBoard next;
+			int captured = board.board[move.to];
+
+			for (int i = 0; i < board.count; i++) {
+				if (i == captured) continue;
+
+				next.types[next.count] = i == move.piece && move.promotion != PieceType::NO_PIECE ? move.promotion : board.types[i];
+				next.players[next.count] = board.players[i];
+				next.cells[next.count] = i == move.piece ? move.to : board.cells[i];
+				next.count++;
+			}
+
+			next.build();
+
+			leftEnding = captured >= 0 || move.promotion != PieceType::NO_PIECE;
+
+			return next;
+		}
+
+		/// <summary>
+		/// Looks up a position of another ending, which has to be generated already
+		/// </summary>
+		TablebaseResult probeExit(const EndingBoard& board, int sideToMove) const {
+			optional<TablebaseResult> result = Tablebases::get().probeDTM(board.toPosition(sideToMove));
+
+			if (!result) throw runtime_error("Tablebase " + layout.name + " needs an ending that wasn't generated");
+
+			return *result;
+		}
+
+		/// <summary>
+		/// Checks if every move of a position leads to a position the opponent has already won, in fewer plies than dtm
+		/// </summary>
+		bool isLost(uint64_t index, int dtm) const {
+			int side;
+			EndingBoard board = getBoard(index, side);
+			int player = side == 0 ? 1 : 2;
+
+			vector<EndingMove> moves;
+			getMoves(board, player, moves);
+
+			bool hasMove = false;
+
+			for (const EndingMove& move : moves) {
+				bool leftEnding;
+				EndingBoard next = makeMove(board, move, leftEnding);
+
+				if (next.isInCheck(player)) continue;
+
+				hasMove = true;
+
+				if (leftEnding) {
+					TablebaseResult result = probeExit(next, 3 - player);
+
+					if (result.wdl != TablebaseWDL::WIN || result.dtm >= dtm) return false;
+				}
+				else {
+					uint8_t value = values[layout.getIndex(next.cells, 1 - side)];
+
+					if (value == TB_UNKNOWN || value == TB_INVALID || (value - 1) % 2 == 0 || value - 1 >= dtm) return false;
+				}
+			}
+
+			return hasMove;
+		}
+
+		/// <summary>
+		/// Finds the positions the opponent could have been in before their last move, moves into a cell can't be undone if it captured
+		/// </summary>
+		void getPreviousPositions(uint64_t index, vector<uint32_t>& previous) const {
+			int side;
+			EndingBoard board = getBoard(index, side);
+			int mover = side == 0 ? 2 : 1; // The player that just moved
+
+			previous.clear();
+
+			vector<EndingMove> moves;
+
+			for (int i = 0; i < board.count; i++) {
+				if (board.players[i] != mover) continue;
+
+				int rank = board.cells[i] / 8;
+				int file = board.cells[i] % 8;
+
+				moves.clear();
+
+				if (board.types[i] == PieceType::PAWN) {
+					int direction = mover == 1 ? 1 : -1;
+					int fromRank = rank - direction;
+
+					if (fromRank >= 1 && fromRank <= 6 && board.board[fromRank * 8 + file] < 0) {
+						moves.push_back({ i, fromRank * 8 + file, PieceType::NO_PIECE });
+
+						int startRank = mover == 1 ? 1 : 6;
+						int doubleRank = rank - direction * 2;
+
+						if (doubleRank == startRank && board.board[doubleRank * 8 + file] < 0) moves.push_back({ i, doubleRank * 8 + file, PieceType::NO_PIECE });
+					}
+				}
+				else {
+					// Every other piece moves the same way backwards
+					vector<EndingMove> pieceMoves;
+					getMoves(board, mover, pieceMoves);
+
+					for (const EndingMove& move : pieceMoves) {
+						if (move.piece == i && board.board[move.to] < 0) moves.push_back(move);
+					}
+				}
+
+				for (const EndingMove& move : moves) {
+					EndingBoard before = board;
+					before.board[before.cells[i]] = -1;
+					before.cells[i] = move.to;
+					before.board[move.to] = (int8_t)i;
+
+					// The opponent can't have been left in check
+					if (before.isInCheck(3 - mover)) continue;
+
+					uint64_t beforeIndex = layout.getIndex(before.cells, 1 - side);
+
+					if (values[beforeIndex] != TB_INVALID) previous.push_back((uint32_t)beforeIndex);
+				}
+			}
+		}
+
+		void initialize(vector<uint32_t>& mates) {
+			uint64_t entries = layout.getEntries();
+
+			values.assign(entries, TB_UNKNOWN);
+			exitWins.assign(TB_MAX_DTM + 2, {});
+			exitLosses.assign(TB_MAX_DTM + 2, {});
+
+			vector<EndingMove> moves;
+
+			for (uint64_t index = 0; index < entries; index++) {
+				if (!isValid(index)) {
+					values[index] = TB_INVALID;
+					continue;
+				}
+
+				int side;
+				EndingBoard board = getBoard(index, side);
+				int player = side == 0 ? 1 : 2;
+
+				getMoves(board, player, moves);
+
+				bool hasMove = false;
+
+				for (const EndingMove& move : moves) {
+					bool leftEnding;
+					EndingBoard next = makeMove(board, move, leftEnding);
+
+					if (next.isInCheck(player)) continue;
+
+					hasMove = true;
+
+					if (!leftEnding) continue;
+
+					// Captures and promotions lead to endings that are already solved
+					TablebaseResult result = probeExit(next, 3 - player);
+
+					if (result.wdl == TablebaseWDL::LOSS) exitWins[result.dtm + 1].push_back((uint32_t)index);
+					else if (result.wdl == TablebaseWDL::WIN) exitLosses[result.dtm + 1].push_back((uint32_t)index);
+				}
+
+				if (!hasMove && board.isInCheck(player)) {
+					values[index] = 1; // Mated, 0 plies to mate
+					mates.push_back((uint32_t)index);
+				}
+			}
+		}
+
+	public:
+		EndingGenerator(const EndingLayout& layout) : layout(layout) {}
+
+		/// <summary>
+		/// Solves every position of the ending
+		/// </summary>
+		/// <returns>The longest mate in plies, counted from the winning side's positions</returns>
+		int generate() {
+			vector<uint32_t> solved;
+			initialize(solved);
+
+			vector<uint32_t> previous;
+			int longest = 0;
+
+			for (int dtm = 1; dtm <= TB_MAX_DTM; dtm++) {
+				vector<uint32_t> next;
+				bool winning = dtm % 2 == 1;
+
+				auto solve = [&](uint32_t index) {
+					values[index] = (uint8_t)(dtm + 1);
+					next.push_back(index);
+				};
+
+				for (uint32_t index : exitWins[dtm]) {
+					if (values[index] == TB_UNKNOWN) solve(index);
+				}
+
+				for (uint32_t index : exitLosses[dtm]) {
+					if (values[index] == TB_UNKNOWN && isLost(index, dtm)) solve(index);
+				}
+
+				// Positions solved last ply lead to these ones
+				for (uint32_t index : solved) {
+					getPreviousPositions(index, previous);
+
+					for (uint32_t before : previous) {
+						if (values[before] != TB_UNKNOWN) continue;
+
+						if (winning || isLost(before, dtm)) solve(before);
+					}
+				}
+
+				if (winning && !next.empty()) longest = dtm;
+
+				bool pending = false;
+
+				for (int later = dtm + 1; later <= TB_MAX_DTM + 1 && !pending; later++) {
+					pending = !exitWins[later].empty() || !exitLosses[later].empty();
+				}
+
+				if (next.empty() && !pending) return longest;
+
+				solved = move(next);
+			}
+
+			throw runtime_error("Tablebase " + layout.name + " has a mate longer than " + to_string(TB_MAX_DTM) + " plies");
+		}
+
+		/// <summary>
+		/// Writes the solved ending as a WDL and a DTM file
+		/// </summary>
+		bool write(const string& directory) const {
+			uint64_t entries = layout.getEntries();
+
+			TablebaseHeader header;
+			memset(&header, 0, sizeof(header));
+			header.version = TABLEBASE_VERSION;
+			header.entries = entries;
+			strncpy(header.ending, layout.name.c_str(), sizeof(header.ending) - 1);
+
+			vector<uint8_t> wdl((entries + 3) / 4, 0);
+			vector<uint8_t> dtm(entries, 0);
+
+			for (uint64_t index = 0; index < entries; index++) {
+				uint8_t value = values[index];
+
+				if (value == TB_UNKNOWN || value == TB_INVALID) continue;
+
+				dtm[index] = value;
+				wdl[index / 4] |= ((value - 1) % 2 == 1 ? 1 : 2) << ((index % 4) * 2);
+			}
+
+			string path = directory + "/" + layout.name;
+
+			for (const auto& [extension, magic, data] : { make_tuple(".wdl", WDL_MAGIC, &wdl), make_tuple(".dtm", DTM_MAGIC, &dtm) }) {
+				FILE* file = fopen((path + extension).c_str(), "wb");
+
+				if (!file) return false;
+
+				memcpy(header.magic, magic, 4);
+				fwrite(&header, sizeof(header), 1, file);
+				fwrite(data->data(), 1, data->size(), file);
+				fclose(file);
+			}
+
+			return true;
+		}
+
+		void getCounts(uint64_t& wins, uint64_t& losses, uint64_t& draws) const {
+			wins = losses = draws = 0;
+
+			for (uint8_t value : values) {
+				if (value == TB_INVALID) continue;
+
+				if (value == TB_UNKNOWN) draws++;
+				else if ((value - 1) % 2 == 1) wins++;
+				else losses++;
+			}
+		}
+};
+
+int generateTablebases(const TablebaseOptions& options) {
+	initSlots();
+
+	error_code error;
+	filesystem::create_directories(options.directory, error);
+
+	Tablebases& tablebases = Tablebases::get();
+	tablebases.close();
+
+	for (const EndingLayout& layout : getEndings(options.maxPieces)) {
+		// Already generated, and the endings after it can use it
+		if (tablebases.openTable(options.directory, layout.name)) {
+			cout << layout.name << ": already generated" << endl;
+			continue;
+		}
+
+		PROFILE_SCOPE("generateTablebases");
+
+		auto startTime = chrono::steady_clock::now();
+
+		EndingGenerator generator(layout);
+		int longest;
+
+		try {
+			longest = generator.generate();
+		}
+		catch (const runtime_error& exception) {
+			cerr << exception.what() << endl;
+			return 1;
+		}
+
+		if (!generator.write(options.directory) || !tablebases.openTable(options.directory, layout.name)) {
+			cerr << "Unable to write tablebase " << layout.name << " to " << options.directory << endl;
+			return 1;
+		}
+
+		uint64_t wins, losses, draws;
+		generator.getCounts(wins, losses, draws);
+
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+		cout << layout.name << ": " << wins << " wins, " << losses << " losses, " << draws << " draws, longest mate "
+			<< longest << " plies (" << seconds << " seconds)" << endl;
+	}
+
+	return 0;
+}
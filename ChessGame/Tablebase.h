@@ -0,0 +1,141 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <memory>
+#include <optional>
+#include "PieceType.h"
+#include "Cell.h"
+#include "MemoryMappedFile.h"
+
+using namespace std;
+
+/*
+	Endgame tablebases hold the result of every position with up to 4 pieces (kings included), on a board without special tiles.
+	Castling and en passant are left out, they can't happen in almost any of these endings.
+
+	Each ending (like "KQvK" or "KRvKP") is stored in two files:
+		<ending>.wdl                TablebaseHeader, then 2 bits per position: 0 draw, 1 win, 2 loss for the side to move
+		<ending>.dtm                TablebaseHeader, then 1 byte per position: 0 draw, otherwise the plies to mate + 1
+
+	Positions are indexed by the side to move and the cells of every piece, with the white king moved into one corner of the
+	board by mirroring (and a quarter of one side when there are pawns), so symmetric positions are only stored once.
+	The stronger side is always white in the files, positions where black is stronger are probed with the colours swapped.
+*/
+
+#define TABLEBASE_VERSION 1
+
+#define TABLEBASE_PATH "resources/tablebases"
+
+#define TABLEBASE_MAX_PIECES 4
+
+// Score of a won tablebase position in the search, higher than any evaluation
+#define TABLEBASE_WIN_SCORE 100000
+
+enum class TablebaseWDL {
+	DRAW,
+	WIN,
+	LOSS
+};
+
+struct TablebaseResult {
+	TablebaseWDL wdl;
+	int dtm; // Plies until mate, 0 for draws
+};
+
+struct TablebasePiece {
+	PieceType type;
+	int player;
+	Cell cell;
+};
+
+/// <summary>
+/// A position small enough to be looked up
+/// </summary>
+struct TablebasePosition {
+	TablebasePiece pieces[TABLEBASE_MAX_PIECES];
+	int count = 0;
+	int sideToMove = 1;
+};
+
+struct TablebaseHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t entries;
+	char ending[16];
+};
+
+static_assert(sizeof(TablebaseHeader) == 32, "TablebaseHeader has to match the file layout");
+
+/// <summary>
+/// Every tablebase found in the tablebase folder, mapped into memory
+/// </summary>
+class Tablebases {
+	private:
+		struct Table {
+			MemoryMappedFile wdl;
+			MemoryMappedFile dtm;
+			uint64_t entries = 0;
+		};
+
+		map<string, unique_ptr<Table>> tables;
+
+		Tablebases() = default;
+
+		Table* findTable(const TablebasePosition& position, uint64_t& index);
+
+	public:
+		static Tablebases& get();
+
+		Tablebases(const Tablebases&) = delete;
+		Tablebases& operator=(const Tablebases&) = delete;
+
+		/// <summary>
+		/// Maps every tablebase in a folder
+		/// </summary>
+		/// <param name="directory">The folder with the tablebase files</param>
+		/// <returns>The number of endings that were found</returns>
+		int open(const string& directory);
+
+		/// <summary>
+		/// Maps a single ending
+		/// </summary>
+		/// <returns>true if both of its files were found</returns>
+		bool openTable(const string& directory, const string& ending);
+
+		void close();
+
+		bool isOpen();
+
+		/// <summary>
+		/// Looks up if a position is won, drawn or lost for the side to move, fast enough for the leaves of the search
+		/// </summary>
+		/// <returns>The result, or nullopt if the ending isn't in the tablebases</returns>
+		optional<TablebaseWDL> probeWDL(const TablebasePosition& position);
+
+		/// <summary>
+		/// Looks up the result of a position with the plies until mate, for picking the move that mates fastest
+		/// </summary>
+		/// <returns>The result, or nullopt if the ending isn't in the tablebases</returns>
+		optional<TablebaseResult> probeDTM(const TablebasePosition& position);
+};
+
+struct TablebaseOptions {
+	string directory = TABLEBASE_PATH;
+	int maxPieces = TABLEBASE_MAX_PIECES;
+};
+
+/// <summary>
+/// Reads the options of the --generate-tablebases mode: --generate-tablebases [folder] [--tb-pieces 3|4]
+/// </summary>
+TablebaseOptions parseTablebaseOptions(int argc, char** argv);
+
+/// <summary>
+/// Generates every ending up to a number of pieces with retrograde analysis and writes them to a folder
+/// </summary>
+/// <returns>The exit code of the program</returns>
+int generateTablebases(const TablebaseOptions& options);
+
+#endif
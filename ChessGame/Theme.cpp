@@ -2,6 +2,8 @@
 
 Theme::Theme(Background* background, TileType defaultWhite, TileType defaultBlack) : background(background), defaultWhite(defaultWhite), defaultBlack(defaultBlack) {}
 
+Theme::~Theme() { delete background; }
+
 void Theme::drawBackground() {
 	if (background) {
 		background->draw();
@@ -16,6 +18,8 @@ void Theme::updateBackground() {
 	}
 }
 
+Background* Theme::getBackground() { return background; }
+
 TileType Theme::getDefaultWhite() const {
 	return defaultWhite;
 }
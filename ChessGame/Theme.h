@@ -13,11 +13,17 @@ class Theme {
 
 	public:
 		Theme(Background* background, TileType defaultWhite, TileType defaultBlack);
+		~Theme();
+
+		Theme(const Theme&) = delete;
+		Theme& operator=(const Theme&) = delete;
 
 		void drawBackground();
 
 		void updateBackground();
 
+		Background* getBackground();
+
 		TileType getDefaultWhite() const;
 		TileType getDefaultBlack() const;
 };
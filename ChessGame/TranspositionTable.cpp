@@ -0,0 +1,84 @@
+#include "TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(int megabytes) { resize(megabytes); }
+
+void TranspositionTable::resize(int megabytes) {
+	size_t maxEntries = (size_t)max(1, megabytes) * 1024 * 1024 / sizeof(Entry);
+
+	entryCount = 1;
+	while (entryCount * 2 <= maxEntries) entryCount *= 2;
+
+	entries = make_unique<Entry[]>(entryCount);
+
+	clear();
+}
+
+void TranspositionTable::clear() {
+	for (size_t i = 0; i < entryCount; i++) {
+		entries[i].check.store(0, memory_order_relaxed);
+		entries[i].data.store(0, memory_order_relaxed);
+	}
+
+	generation = 0;
+}
+
+void TranspositionTable::newSearch() { generation = (generation + 1) & 63; }
+
+/*
+	Data is packed as:
+		bits 0 - 31         score
+		bits 32 - 47        move
+		bits 48 - 55        depth
+		bits 56 - 57        bound
+		bits 58 - 63        generation
+*/
+
+uint64_t TranspositionTable::pack(const TranspositionData& data, uint8_t generation) {
+	return (uint64_t)(uint32_t)data.score | ((uint64_t)data.move << 32) | ((uint64_t)(uint8_t)data.depth << 48) |
+		((uint64_t)data.bound << 56) | ((uint64_t)generation << 58);
+}
+
+TranspositionData TranspositionTable::unpack(uint64_t data) {
+	return { (int)(int32_t)(uint32_t)data, (int)(uint8_t)(data >> 48), (TranspositionBound)((data >> 56) & 3), (uint16_t)(data >> 32) };
+}
+
+bool TranspositionTable::probe(uint64_t key, TranspositionData& data) const {
+	const Entry& entry = entries[key & (entryCount - 1)];
+
+	uint64_t packed = entry.data.load(memory_order_relaxed);
+
+	if ((entry.check.load(memory_order_relaxed) ^ packed) != key || packed == 0) return false;
+
+	data = unpack(packed);
+
+	return true;
+}
+
+void TranspositionTable::store(uint64_t key, const TranspositionData& data) {
+	Entry& entry = entries[key & (entryCount - 1)];
+
+	uint64_t packed = entry.data.load(memory_order_relaxed);
+	bool samePosition = (entry.check.load(memory_order_relaxed) ^ packed) == key;
+	bool currentSearch = (packed >> 58) == generation;
+
+	// Keep deeper results of this search, they took longer to find
+	if (!samePosition && currentSearch && (int)(uint8_t)(packed >> 48) > data.depth) return;
+
+	uint64_t newPacked = pack(data, generation);
+
+	entry.data.store(newPacked, memory_order_relaxed);
+	entry.check.store(key ^ newPacked, memory_order_relaxed);
+}
+
+int TranspositionTable::getHashfull() const {
+	size_t sampled = min<size_t>(1000, entryCount);
+	int used = 0;
+
+	for (size_t i = 0; i < sampled; i++) {
+		uint64_t packed = entries[i].data.load(memory_order_relaxed);
+
+		if (packed != 0 && (packed >> 58) == generation) used++;
+	}
+
+	return (int)(used * 1000 / sampled);
+}
@@ -0,0 +1,82 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+#define TRANSPOSITION_TABLE_DEFAULT_SIZE 16 // Megabytes
+#define TRANSPOSITION_TABLE_MAX_SIZE 4096   // Megabytes, the most a GUI can ask for
+
+enum class TranspositionBound {
+	EXACT, // The score is the score of the position
+	LOWER, // The search failed high, the position scores at least this
+	UPPER  // The search failed low, the position scores at most this
+};
+
+struct TranspositionData {
+	int score;
+	int depth;
+	TranspositionBound bound;
+	uint16_t move; // Best move packed like a book move, 0 if there is none
+};
+
+/// <summary>
+/// Positions the search has already scored, shared by every search thread without locks.
+/// Each entry stores its key XORed with its data, so an entry torn by two threads writing at once doesn't match any key
+/// </summary>
+class TranspositionTable {
+	private:
+		struct Entry {
+			atomic<uint64_t> check; // The key XORed with the data
+			atomic<uint64_t> data;
+		};
+
+		unique_ptr<Entry[]> entries;
+		size_t entryCount = 0;
+
+		uint8_t generation = 0; // Entries from older searches are replaced first
+
+		static uint64_t pack(const TranspositionData& data, uint8_t generation);
+
+		static TranspositionData unpack(uint64_t data);
+
+	public:
+		TranspositionTable(int megabytes = TRANSPOSITION_TABLE_DEFAULT_SIZE);
+
+		/// <summary>
+		/// Reallocates the table, everything in it is lost
+		/// </summary>
+		/// <param name="megabytes">The size of the table, rounded down to a power of two entries</param>
+		void resize(int megabytes);
+
+		void clear();
+
+		/// <summary>
+		/// Starts a new search, so the entries of the last search get replaced before the new ones
+		/// </summary>
+		void newSearch();
+
+		/// <summary>
+		/// Looks up a position
+		/// </summary>
+		/// <param name="key">The key of the position</param>
+		/// <param name="data">Set to what was stored for the position</param>
+		/// <returns>true if the position was found</returns>
+		bool probe(uint64_t key, TranspositionData& data) const;
+
+		/// <summary>
+		/// Stores the result of searching a position, unless a deeper search of another position from this search is in its slot
+		/// </summary>
+		void store(uint64_t key, const TranspositionData& data);
+
+		/// <summary>
+		/// Gets how full the table is with entries from this search, in permille (like UCI's hashfull)
+		/// </summary>
+		int getHashfull() const;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include "TurnResolver.h"
+
+TurnResolver::~TurnResolver() { cancel(); }
+
+void TurnResolver::start(Board& board, const Move& move, int player) {
+	cancel();
+
+	done = false;
+
+	// Only the snapshot crosses over, the worker builds its own board from it
+	worker = thread(&TurnResolver::resolve, this, board.getState(), move, player);
+}
+
+void TurnResolver::resolve(GameState state, Move playerMove, int player) {
+	vector<Player> players;
+	Board board(nullptr, players); // No textures or sounds, so nothing here touches the window
+
+	board.instantAnimations = true;
+	board.setState(state); // With the random numbers, so tiles spawn the same as on the real board
+
+	board.startTurn(playerMove);
+
+	// Run the phases like Game::update does, promoting to a queen like the AI (a player choosing something else is a miss)
+	while (!board.handlingStateUpdate) {
+		while (board.hasPromotion()) board.promotePiece(board.getPromotionCell(), PieceType::QUEEN);
+
+		board.update(player);
+	}
+
+	TurnResolution result;
+
+	int nextPlayer = (player % 2) + 1;
+
+	result.resolvedState = board.getState();
+	result.checkmate = board.isInCheckmate(nextPlayer);
+	result.stalemate = board.isInStalemate(nextPlayer);
+
+	if (!result.checkmate && !result.stalemate) {
+		board.updateState();
+
+		result.nextState = board.getState();
+		result.inCheck = board.isInCheck(nextPlayer);
+		result.legalMoves = board.getAllLegalMoves(nextPlayer);
+	}
+
+	resolution = move(result);
+	done = true;
+}
+
+optional<TurnResolution> TurnResolver::finish() {
+	if (!worker.joinable()) return nullopt;
+
+	worker.join();
+
+	optional<TurnResolution> result = move(resolution);
+	resolution.reset();
+
+	return result;
+}
+
+void TurnResolver::cancel() {
+	if (worker.joinable()) worker.join();
+
+	resolution.reset();
+}
+
+bool TurnResolver::isDone() { return done; }
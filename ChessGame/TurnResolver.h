@@ -0,0 +1,77 @@
+#ifndef TURNRESOLVER_H
+#define TURNRESOLVER_H
+
+#include <thread>
+#include <atomic>
+#include <optional>
+#include <string>
+#include <vector>
+#include "board.h"
+
+using namespace std;
+
+/// <summary>
+/// What a turn ends in, worked out ahead of time on a copy of the board
+/// </summary>
+struct TurnResolution {
+	/// <summary>
+	/// The board after the move, tile effects and promotions, before the tiles update.
+	/// The resolution only counts if the real board ends up the same
+	/// </summary>
+	GameState resolvedState;
+
+	bool checkmate = false; // For the player to move next
+	bool stalemate = false;
+
+	/// <summary>
+	/// The board after the tiles updated, the position the next player moves in
+	/// </summary>
+	GameState nextState;
+
+	bool inCheck = false;
+	vector<Move> legalMoves; // Every legal move of the player to move next
+};
+
+/// <summary>
+/// Plays out a turn on a copy of the board on another thread while the real board animates it, so the end of the turn
+/// doesn't have to look for checkmate and generate the next player's moves all in one frame
+/// </summary>
+class TurnResolver {
+	private:
+		thread worker;
+		atomic<bool> done = false;
+
+		optional<TurnResolution> resolution; // Only touched by the worker until it's joined
+
+		void resolve(GameState state, Move playerMove, int player);
+
+	public:
+		TurnResolver() = default;
+		~TurnResolver();
+
+		TurnResolver(const TurnResolver&) = delete;
+		TurnResolver& operator=(const TurnResolver&) = delete;
+
+		/// <summary>
+		/// Starts resolving a turn, call it before the move is played on the board
+		/// </summary>
+		/// <param name="board">The board the move is played on, copied before this returns</param>
+		/// <param name="move">The move being played, with its flags</param>
+		/// <param name="player">The player making the move</param>
+		void start(Board& board, const Move& move, int player);
+
+		/// <summary>
+		/// Gets the resolution of the turn, waiting for the worker if it's still going
+		/// </summary>
+		/// <returns>The resolution, or nullopt if no turn was started</returns>
+		optional<TurnResolution> finish();
+
+		/// <summary>
+		/// Throws away the turn being resolved, for when the board changes some other way
+		/// </summary>
+		void cancel();
+
+		bool isDone();
+};
+
+#endif
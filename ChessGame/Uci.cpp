@@ -0,0 +1,194 @@
+#include "Uci.h"
+#include "Engine.h"
+#include "Log.h"
+#include "Tablebase.h"
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <mutex>
+
+/// <summary>
+/// Writes a line of the protocol, search threads send info while the main thread answers commands
+/// </summary>
+static void sendLine(const string& line) {
+	static mutex outputMutex;
+	lock_guard<mutex> lock(outputMutex);
+
+	fputs(line.c_str(), stdout);
+	fputc('\n', stdout);
+	fflush(stdout);
+}
+
+static string getUciScore(int score) {
+	if (isMateScore(score)) return "mate " + to_string(getMateMoves(score));
+	return "cp " + to_string(score);
+}
+
+static PieceType getUciPromotion(const string& move) {
+	if (move.size() < 5) return PieceType::QUEEN;
+
+	switch (move[4]) {
+		case 'r': return PieceType::ROOK;
+		case 'b': return PieceType::BISHOP;
+		case 'n': return PieceType::KNIGHT;
+		default: return PieceType::QUEEN;
+	}
+}
+
+/// <summary>
+/// position [startpos | fen <fen>] [moves <move>...]
+/// </summary>
+static void setUciPosition(Engine& engine, istringstream& stream) {
+	string token;
+	string fen = FEN_START_POSITION;
+
+	stream >> token;
+
+	if (token == "fen") {
+		fen = "";
+
+		while (stream >> token && token != "moves") fen += (fen.empty() ? "" : " ") + token;
+	}
+	else stream >> token; // "moves", if there are any
+
+	unique_ptr<MoveGenerator> generator;
+
+	try {
+		generator = make_unique<MoveGenerator>(fen);
+	}
+	catch (const runtime_error& exception) {
+		sendLine(string("info string ") + exception.what());
+		return;
+	}
+
+	while (stream >> token) {
+		optional<Move> move = parseUciMove(*generator, token);
+
+		if (!move) {
+			sendLine("info string Illegal move " + token);
+			break;
+		}
+
+		makeUciMove(*generator, move.value(), getUciPromotion(token));
+	}
+
+	generator->setEvaluationNoise(0); // Searches have to be repeatable to compare against other engines
+	engine.setPosition(*generator);
+}
+
+/// <summary>
+/// go [searchmoves ...] [ponder] [wtime n] [btime n] [winc n] [binc n] [movestogo n] [depth n] [nodes n] [movetime n] [infinite]
+/// </summary>
+static SearchLimits parseUciLimits(istringstream& stream) {
+	SearchLimits limits;
+	string token;
+
+	while (stream >> token) {
+		if (token == "ponder") limits.ponder = true;
+		else if (token == "infinite") limits.infinite = true;
+		else if (token == "wtime") stream >> limits.time[0];
+		else if (token == "btime") stream >> limits.time[1];
+		else if (token == "winc") stream >> limits.increment[0];
+		else if (token == "binc") stream >> limits.increment[1];
+		else if (token == "movestogo") stream >> limits.movesToGo;
+		else if (token == "depth") stream >> limits.depth;
+		else if (token == "nodes") stream >> limits.nodes;
+		else if (token == "movetime") stream >> limits.moveTime;
+	}
+
+	return limits;
+}
+
+/// <summary>
+/// setoption name <name> [value <value>]
+/// </summary>
+static void setUciOption(Engine& engine, istringstream& stream) {
+	string token;
+	string name;
+	string value;
+	string* reading = nullptr;
+
+	while (stream >> token) {
+		if (token == "name") reading = &name;
+		else if (token == "value") reading = &value;
+		else if (reading) *reading += (reading->empty() ? "" : " ") + token;
+	}
+
+	if (name == "Hash") engine.setHashSize(atoi(value.c_str()));
+	else if (name == "Threads") engine.setThreads(atoi(value.c_str()));
+	else if (name == "TablebasePath") Tablebases::get().open(value);
+	else if (name != "Ponder") sendLine("info string Unknown option " + name); // Pondering is up to the GUI
+}
+
+int runUci() {
+	// The search logs to cout, so the protocol is written straight to stdout
+	silenceGameLog();
+
+	Tablebases::get().open(TABLEBASE_PATH);
+
+	Engine engine;
+
+	MoveGenerator startPosition(FEN_START_POSITION);
+	startPosition.setEvaluationNoise(0);
+	engine.setPosition(startPosition);
+
+	engine.onInfo = [&](const SearchInfo& info) {
+		ostringstream line;
+		line << "info depth " << info.depth << " score " << getUciScore(info.score) << " nodes " << info.nodes << " nps " << info.nps
+			<< " time " << info.time << " hashfull " << info.hashfull << " pv";
+
+		MoveGenerator generator = engine.getPosition();
+
+		for (const Move& move : info.pv) {
+			line << " " << getUciMove(generator, move);
+			makeUciMove(generator, move);
+		}
+
+		sendLine(line.str());
+	};
+
+	engine.onBestMove = [&](const Move& move, optional<Move> ponderMove) {
+		MoveGenerator generator = engine.getPosition();
+		string line = "bestmove " + getUciMove(generator, move);
+
+		if (ponderMove) {
+			makeUciMove(generator, move);
+			line += " ponder " + getUciMove(generator, ponderMove.value());
+		}
+
+		sendLine(line);
+	};
+
+	string input;
+
+	while (getline(cin, input)) {
+		istringstream stream(input);
+		string command;
+		stream >> command;
+
+		if (command == "uci") {
+			sendLine("id name " UCI_ENGINE_NAME);
+			sendLine("id author " UCI_ENGINE_AUTHOR);
+			sendLine("option name Hash type spin default " + to_string(TRANSPOSITION_TABLE_DEFAULT_SIZE) + " min 1 max " + to_string(TRANSPOSITION_TABLE_MAX_SIZE));
+			sendLine("option name Threads type spin default 1 min 1 max " + to_string(ENGINE_MAX_THREADS));
+			sendLine("option name Ponder type check default false");
+			sendLine("option name TablebasePath type string default " TABLEBASE_PATH);
+			sendLine("uciok");
+		}
+		else if (command == "isready") sendLine("readyok");
+		else if (command == "ucinewgame") engine.clear();
+		else if (command == "setoption") setUciOption(engine, stream);
+		else if (command == "position") setUciPosition(engine, stream);
+		else if (command == "go") engine.go(parseUciLimits(stream));
+		else if (command == "stop") engine.stop();
+		else if (command == "ponderhit") engine.ponderHit();
+		else if (command == "quit") break;
+		else if (command == "d") sendLine(engine.getPosition().getFEN()); // Not UCI, handy for checking positions by hand
+		else if (!command.empty()) sendLine("info string Unknown command " + command);
+	}
+
+	engine.stop();
+	engine.wait();
+
+	return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef UCI_H
+#define UCI_H
+
+#define UCI_ENGINE_NAME "ChessGame"
+#define UCI_ENGINE_AUTHOR "bluesqqq"
+
+/// <summary>
+/// Runs the engine as a UCI console program on stdin and stdout, so it can be played against other engines by tournament tools.
+/// Supports uci, isready, ucinewgame, setoption (Hash, Threads, Ponder, TablebasePath), position, go, stop, ponderhit and quit
+/// </summary>
+/// <returns>The exit code of the program</returns>
+int runUci();
+
+#endif
@@ -0,0 +1,82 @@
+#include "Zobrist.h"
+#include "Random.h"
+
+/// <summary>
+/// Every random key, generated once the first time one is needed
+/// </summary>
+struct ZobristKeys {
+	uint64_t pieces[2][6][64]; // [player][piece type][cell]
+	uint64_t castling[4];
+	uint64_t enPassant[8];
+	uint64_t side;
+
+	ZobristKeys() {
+		Random random(ZOBRIST_SEED);
+
+		auto next64 = [&]() { return ((uint64_t)random.next() << 32) | random.next(); };
+
+		for (auto& player : pieces) {
+			for (auto& type : player) {
+				for (uint64_t& key : type) key = next64();
+			}
+		}
+
+		for (uint64_t& key : castling) key = next64();
+		for (uint64_t& key : enPassant) key = next64();
+
+		side = next64();
+	}
+};
+
+static const ZobristKeys& getKeys() {
+	static const ZobristKeys keys;
+	return keys;
+}
+
+uint64_t getZobristPieceKey(PieceType type, int player, Cell cell) {
+	return getKeys().pieces[player - 1][(int)type - 1][cell.rank * 8 + cell.file];
+}
+
+uint64_t getZobristCastlingKey(int castle) { return getKeys().castling[castle]; }
+
+uint64_t getZobristEnPassantKey(int file) { return getKeys().enPassant[file]; }
+
+uint64_t getZobristSideKey() { return getKeys().side; }
+
+uint64_t getZobristKey(const Position& position) {
+	uint64_t key = 0;
+
+	for (int rank = 0; rank < 8; rank++) {
+		for (int file = 0; file < 8; file++) {
+			const PositionPiece& piece = position.pieces[rank][file];
+
+			if (piece.type != PieceType::NO_PIECE) key ^= getZobristPieceKey(piece.type, piece.player, Cell(rank, file));
+		}
+	}
+
+	for (int castle = 0; castle < 4; castle++) {
+		if (position.castling[castle]) key ^= getZobristCastlingKey(castle);
+	}
+
+	if (position.enPassantableCell) {
+		Cell pawn = position.enPassantableCell.value();
+
+		// Only count it if a pawn of the side to move is next to the pawn that can be captured
+		for (int side = -1; side <= 1; side += 2) {
+			Cell neighbour(pawn.rank, pawn.file + side);
+
+			if (!neighbour.isInBounds()) continue;
+
+			const PositionPiece& piece = position.pieces[neighbour.rank][neighbour.file];
+
+			if (piece.type == PieceType::PAWN && piece.player == position.sideToMove) {
+				key ^= getZobristEnPassantKey(pawn.file);
+				break;
+			}
+		}
+	}
+
+	if (position.sideToMove == 2) key ^= getZobristSideKey();
+
+	return key;
+}
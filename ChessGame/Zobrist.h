@@ -0,0 +1,38 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+#include "Position.h"
+
+// Keys are generated from this seed, changing it makes every opening book unusable
+#define ZOBRIST_SEED 0x5A0B12157C4E55ULL
+
+/// <summary>
+/// Gets the key of a piece standing on a cell
+/// </summary>
+uint64_t getZobristPieceKey(PieceType type, int player, Cell cell);
+
+/// <summary>
+/// Gets the key of a castling right (CASTLE_WHITE_KING, CASTLE_WHITE_QUEEN, ...)
+/// </summary>
+uint64_t getZobristCastlingKey(int castle);
+
+/// <summary>
+/// Gets the key of an en passant capture being possible on a file
+/// </summary>
+uint64_t getZobristEnPassantKey(int file);
+
+/// <summary>
+/// Gets the key that is added when it's black's (player 2's) turn
+/// </summary>
+uint64_t getZobristSideKey();
+
+/// <summary>
+/// Hashes the pieces, castling rights, en passant and side to move of a position, tiles aren't included.
+/// En passant only counts when a pawn can actually capture, so the same position always has the same key
+/// </summary>
+/// <param name="position">The position to hash</param>
+/// <returns>The 64 bit key of the position</returns>
+uint64_t getZobristKey(const Position& position);
+
+#endif
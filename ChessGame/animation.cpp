@@ -1,91 +1,215 @@
 #include "animation.h"
+#include <algorithm>
+
+/************************************|
+			   CURVES
+|************************************/
+
+static constexpr CurveKeyframe INSTANT_KEYFRAMES[] = {
+	{ 0.0f, 0.0f, 0.0f, NONE }
+};
+
+static constexpr CurveKeyframe SLIDE_KEYFRAMES[] = {
+	{ 0.0f, 0.0f, 0.0f, EASE_IN_OUT },
+	{ 0.5f, 1.0f, 0.0f, NONE }
+};
+
+static constexpr CurveKeyframe PICK_AND_PLACE_KEYFRAMES[] = {
+	{ 0.0f, 0.0f, 0.0f, EASE_OUT },    // Starting Position
+	{ 0.3f, 0.0f, 2.0f, EASE_IN_OUT }, // Above Starting Position
+	{ 0.9f, 1.0f, 2.0f, EASE_IN },     // Above Ending Position
+	{ 1.2f, 1.0f, 0.0f, NONE }         // Ending Position
+};
+
+static constexpr CurveKeyframe TELEPORT_KEYFRAMES[] = {
+	{ 0.0f, 0.0f, 0.0f, EASE_IN },    // Starting Position
+	{ 0.5f, 0.0f, -1.0f, NONE },      // Below Starting Position
+	{ 0.501f, 1.0f, -1.0f, EASE_OUT }, // Below Ending Position
+	{ 2.0f, 1.0f, 0.0f, NONE }        // Ending Position
+};
+
+static constexpr AnimationCurve INSTANT_CURVE = { INSTANT_KEYFRAMES, 1 };
+static constexpr AnimationCurve SLIDE_CURVE = { SLIDE_KEYFRAMES, 2 };
+static constexpr AnimationCurve PICK_AND_PLACE_CURVE = { PICK_AND_PLACE_KEYFRAMES, 4 };
+static constexpr AnimationCurve TELEPORT_CURVE = { TELEPORT_KEYFRAMES, 4 };
 
-Keyframe::Keyframe(double time, raylib::Vector3 position, EasingType easing) : time(time), position(position), easing(easing) {
+Animation createInstantAnimation() {
+	return { &INSTANT_CURVE, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+}
 
+Animation createSlideAnimation(raylib::Vector3 start, raylib::Vector3 end) {
+	return { &SLIDE_CURVE, start, end };
 }
 
-Animation::Animation(vector<Keyframe> keyframes) : keyframes(keyframes) {
+Animation createPickAndPlaceAnimation(raylib::Vector3 start, raylib::Vector3 end) {
+	return { &PICK_AND_PLACE_CURVE, start, end };
+}
 
+Animation createTeleportAnimation(raylib::Vector3 start, raylib::Vector3 end) {
+	return { &TELEPORT_CURVE, start, end };
 }
 
-void Animation::startAnimation() {
-	startTime = GetTime();
+/************************************|
+			  TIMELINE
+|************************************/
+
+AnimationTimeline::AnimationTimeline() {
+	curves.reserve(ANIMATION_TIMELINE_CAPACITY);
+	startTimes.reserve(ANIMATION_TIMELINE_CAPACITY);
+	speeds.reserve(ANIMATION_TIMELINE_CAPACITY);
+	starts.reserve(ANIMATION_TIMELINE_CAPACITY);
+	ends.reserve(ANIMATION_TIMELINE_CAPACITY);
+	positions.reserve(ANIMATION_TIMELINE_CAPACITY);
+	cursors.reserve(ANIMATION_TIMELINE_CAPACITY);
+	activeFlags.reserve(ANIMATION_TIMELINE_CAPACITY);
+	endedFlags.reserve(ANIMATION_TIMELINE_CAPACITY);
+	generations.reserve(ANIMATION_TIMELINE_CAPACITY);
+	freeTracks.reserve(ANIMATION_TIMELINE_CAPACITY);
+
+	for (int i = 0; i < ANIMATION_TIMELINE_CAPACITY; i++) freeTracks.push_back(growTracks());
+
+	reverse(freeTracks.begin(), freeTracks.end()); // Hand out the first tracks first
 }
 
-void Animation::play(float speed) {
-	startTime = GetTime();
-	this->speed = speed;
+AnimationTimeline& AnimationTimeline::get() {
+	static AnimationTimeline timeline;
+	return timeline;
 }
 
-raylib::Vector3 Animation::getPositionAtTime(double time) {
-	// If there are no keyframes, return a zero vector
-	if (keyframes.size() == 0) return { 0.0f, 0.0f, 0.0f };
+int AnimationTimeline::growTracks() {
+	curves.push_back(nullptr);
+	startTimes.push_back(0.0);
+	speeds.push_back(1.0f);
+	starts.push_back({ 0.0f, 0.0f, 0.0f });
+	ends.push_back({ 0.0f, 0.0f, 0.0f });
+	positions.push_back({ 0.0f, 0.0f, 0.0f });
+	cursors.push_back(0);
+	activeFlags.push_back(0);
+	endedFlags.push_back(1);
+	generations.push_back(0);
+
+	return (int)curves.size() - 1;
+}
+
+bool AnimationTimeline::owns(AnimationHandle handle) const {
+	return handle.index >= 0 && handle.index < (int)curves.size() && activeFlags[handle.index] && generations[handle.index] == handle.generation;
+}
 
-	// If there is only one keyframe, return that keyframe's position
-	if (keyframes.size() == 1) return keyframes[0].position;
+void AnimationTimeline::sample(int track) {
+	const AnimationCurve& curve = *curves[track];
+	const CurveKeyframe* keyframes = curve.keyframes;
 
-	// If the time is before the first keyframe, return the first keyframe's position
-	if (time < (keyframes[0].time * speed)) return keyframes[0].position;
+	// Speed scales the keyframe times, so scale the elapsed time once instead
+	float elapsed = (float)((time - startTimes[track]) / speeds[track]);
 
-	// If the time is between two keyframes, interpolate between them
-	for (int i = 0; i < keyframes.size() - 1; i++) {
-		double thisTime = keyframes[i].time * speed;
-		double nextTime = keyframes[i + 1].time * speed;
+	raylib::Vector3 start = starts[track];
+	raylib::Vector3 travel = raylib::Vector3(ends[track]) - start;
 
-		// Check if the time is between the current keyframe and the next keyframe
-		if (time >= thisTime && time < nextTime) {
-			float timeDiff = nextTime - thisTime;
-			float timeInto = time - thisTime;
-			float ratio = timeInto / timeDiff;
+	auto keyframePosition = [&](const CurveKeyframe& keyframe) {
+		return start + travel * keyframe.progress + raylib::Vector3(0.0f, 0.0f, keyframe.lift);
+	};
 
-			ratio = easeValue(ratio, keyframes[i].easing);
+	endedFlags[track] = elapsed >= curve.getDuration();
+
+	// Before the first keyframe, or past the last one
+	if (curve.count == 1 || elapsed < keyframes[0].time) {
+		positions[track] = keyframePosition(keyframes[0]);
+		return;
+	}
 
-			return keyframes[i].position.Lerp(keyframes[i + 1].position, ratio);
-		}
+	if (endedFlags[track]) {
+		positions[track] = keyframePosition(keyframes[curve.count - 1]);
+		return;
 	}
 
-	// if the time is after the last keyframe, return the last keyframe's position
-	return keyframes[keyframes.size() - 1].position;
+	int& cursor = cursors[track];
+
+	while (cursor < curve.count - 2 && elapsed >= keyframes[cursor + 1].time) cursor++;
+
+	const CurveKeyframe& from = keyframes[cursor];
+	const CurveKeyframe& to = keyframes[cursor + 1];
+
+	float ratio = easeValue((elapsed - from.time) / (to.time - from.time), from.easing);
+
+	positions[track] = keyframePosition(from).Lerp(keyframePosition(to), ratio);
 }
 
-raylib::Vector3 Animation::getPosition() {
-	double currentTime = GetTime();
-	return getPositionAtTime(currentTime - startTime);
+void AnimationTimeline::tick() {
+	double now = GetTime();
+
+	if (clock >= 0.0) time += (now - clock) * timeScale;
+	clock = now;
+
+	for (int track = 0; track < (int)curves.size(); track++) {
+		if (activeFlags[track] && !endedFlags[track]) sample(track);
+	}
 }
 
-bool Animation::ended() {
-	double currentTime = GetTime();
-	// this here check
-	return (currentTime - startTime) >= keyframes[keyframes.size() - 1].time * speed;
+double AnimationTimeline::getTime() { return time; }
+
+void AnimationTimeline::setTimeScale(float scale) {
+	timeScale = max(0.0f, scale);
+
+	if (isInstant()) skipToEnd();
 }
 
-Animation createInstantAnimation() {
-	return Animation({
-	Keyframe(0, { 0.0f, 0.0f, 0.0f })
-		});
+float AnimationTimeline::getTimeScale() { return timeScale; }
+
+bool AnimationTimeline::isInstant() { return timeScale <= 0.0f; }
+
+void AnimationTimeline::skipToEnd() {
+	for (int track = 0; track < (int)curves.size(); track++) {
+		if (!activeFlags[track] || endedFlags[track]) continue;
+
+		startTimes[track] = time - curves[track]->getDuration() * speeds[track]; // Started exactly one duration ago
+		sample(track);
+	}
 }
 
-Animation createSlideAnimation(raylib::Vector3 start, raylib::Vector3 end) {
-	return Animation({
-		Keyframe(0, start, EASE_IN_OUT), 
-		Keyframe(0.5, end)
-	});
+AnimationHandle AnimationTimeline::play(const Animation& animation) {
+	int track;
+
+	if (freeTracks.empty()) track = growTracks();
+	else {
+		track = freeTracks.back();
+		freeTracks.pop_back();
+	}
+
+	curves[track] = animation.curve;
+	startTimes[track] = time;
+	speeds[track] = animation.speed;
+	starts[track] = animation.start;
+	ends[track] = animation.end;
+	cursors[track] = 0;
+	activeFlags[track] = 1;
+	endedFlags[track] = 0;
+
+	if (isInstant()) startTimes[track] = time - animation.curve->getDuration() * animation.speed;
+
+	sample(track); // So it can be drawn before the next tick
+
+	return { track, generations[track] };
 }
 
-Animation createPickAndPlaceAnimation(raylib::Vector3 start, raylib::Vector3 end) {
-	return Animation({
-		Keyframe(0, start, EASE_OUT), // Starting Position
-		Keyframe(0.3, start + raylib::Vector3(0, 0, 2), EASE_IN_OUT), // Above Starting Position
-		Keyframe(0.9, end + raylib::Vector3(0, 0, 2), EASE_IN), // Above Ending Position
-		Keyframe(1.2, end) // Ending Position
-	});
+void AnimationTimeline::stop(AnimationHandle handle) {
+	if (!owns(handle)) return;
+
+	activeFlags[handle.index] = 0;
+	generations[handle.index]++; // Old handles to the track don't match once it's reused
+
+	freeTracks.push_back(handle.index);
 }
 
-Animation createTeleportAnimation(raylib::Vector3 start, raylib::Vector3 end) {
-	return Animation({
-		Keyframe(0, start, EASE_IN), // Starting Position
-		Keyframe(0.5, start + raylib::Vector3(0, 0, -1)), // Above Starting Position
-		Keyframe(0.501, end + raylib::Vector3(0, 0, -1), EASE_OUT), // Above Ending Position
-		Keyframe(2, end) // Ending Position
-		});
-}
\ No newline at end of file
+raylib::Vector3 AnimationTimeline::getPosition(AnimationHandle handle) {
+	if (!owns(handle)) return { 0.0f, 0.0f, 0.0f };
+
+	return positions[handle.index];
+}
+
+bool AnimationTimeline::ended(AnimationHandle handle) {
+	if (!owns(handle)) return true;
+
+	return endedFlags[handle.index];
+}
+
+int AnimationTimeline::getActiveCount() { return (int)curves.size() - (int)freeTracks.size(); }
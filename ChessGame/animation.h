@@ -4,49 +4,155 @@
 #define ANIMATION_H
 
 #include <vector>
+#include <cstdint>
 #include "tile.h"
 #include "include/raylib-cpp.hpp"
 #include "easing.h"
 
-struct Keyframe {
-	double time;
+using namespace std;
 
-	raylib::Vector3 position;
+#define ANIMATION_TIMELINE_CAPACITY 64 // Tracks allocated up front, enough for every piece on the board to move at once
 
-	EasingType easing;
+#define ANIMATION_SPEED_COUNT 4
+static constexpr float ANIMATION_SPEEDS[ANIMATION_SPEED_COUNT] = { 1.0f, 2.0f, 4.0f, 0.0f }; // Time scales to cycle through, 0 is instant
 
-	Keyframe(double time, raylib::Vector3 position, EasingType easing = EasingType::NONE);
+/// <summary>
+/// A point of an animation curve, relative to where the animation starts and ends so the same curve works for any move
+/// </summary>
+struct CurveKeyframe {
+	float time;        // Seconds from the start of the animation
+	float progress;    // How far along from the start to the end position, 0 to 1
+	float lift;        // Height added on top of the line from the start to the end
+	EasingType easing; // Easing from this keyframe to the next
 };
 
+/// <summary>
+/// The keyframes of an animation, the presets are constant data that every animation shares
+/// </summary>
+struct AnimationCurve {
+	const CurveKeyframe* keyframes;
+	int count;
+
+	constexpr float getDuration() const { return keyframes[count - 1].time; }
+};
+
+/// <summary>
+/// A curve played from one position to another
+/// </summary>
 struct Animation {
-	/// <summary>
-	/// The time that the animation started at
-	/// </summary>
-	double startTime = 0;
+	const AnimationCurve* curve;
+
+	raylib::Vector3 start;
+	raylib::Vector3 end;
 
 	/// <summary>
 	/// The speed of the animation
 	/// </summary>
 	float speed = 1.0f;
+};
 
-    /// <summary>
-	/// The keyframes of the animation
-    /// </summary>
-    vector<Keyframe> keyframes;
-
-	Animation(vector<Keyframe> keyframes);
-
-	void startAnimation();
-
-	void play(float speed = 1.0f);
-
-	
-
-	raylib::Vector3 getPositionAtTime(double time);
+/// <summary>
+/// A track playing on the timeline, stays safe to use after the track is stopped and reused
+/// </summary>
+struct AnimationHandle {
+	int index = -1;
+	uint32_t generation = 0;
 
-	raylib::Vector3 getPosition();
+	bool isValid() const { return index >= 0; }
+};
 
-	bool ended();
+/// <summary>
+/// Plays every animation off a clock that is sampled once a frame. Tracks are kept in parallel arrays and reused,
+/// so starting and sampling animations never allocates. Only used from the main thread
+/// </summary>
+class AnimationTimeline {
+	private:
+		// Tracks, one element per track in each array
+		vector<const AnimationCurve*> curves;
+		vector<double> startTimes;
+		vector<float> speeds;
+		vector<Vector3> starts;
+		vector<Vector3> ends;
+		vector<Vector3> positions;
+		vector<int> cursors;        // Keyframe the track was last between, time only goes forward so it only moves forward
+		vector<uint8_t> activeFlags;
+		vector<uint8_t> endedFlags;
+		vector<uint32_t> generations;
+
+		vector<int> freeTracks;
+
+		double time = 0.0;  // Animation time, runs at the time scale
+		double clock = -1.0; // Wall clock at the last tick, -1 before the first
+
+		float timeScale = 1.0f;
+
+		AnimationTimeline();
+
+		/// <summary>
+		/// Adds a new track to the end of the arrays
+		/// </summary>
+		int growTracks();
+
+		bool owns(AnimationHandle handle) const;
+
+		void sample(int track);
+
+	public:
+		static AnimationTimeline& get();
+
+		/// <summary>
+		/// Samples the clock and moves every playing track to it, called once a frame before anything reads a track
+		/// </summary>
+		void tick();
+
+		/// <summary>
+		/// Gets the animation time of the frame, in seconds
+		/// </summary>
+		double getTime();
+
+		/// <summary>
+		/// Sets how fast animations play
+		/// </summary>
+		/// <param name="scale">1 for normal speed, 0 to finish every animation as soon as it starts</param>
+		void setTimeScale(float scale);
+
+		float getTimeScale();
+
+		/// <summary>
+		/// Determines if animations finish as soon as they start
+		/// </summary>
+		bool isInstant();
+
+		/// <summary>
+		/// Moves every playing track to its last keyframe
+		/// </summary>
+		void skipToEnd();
+
+		/// <summary>
+		/// Starts playing an animation from the time of the frame
+		/// </summary>
+		/// <returns>The track the animation plays on</returns>
+		AnimationHandle play(const Animation& animation);
+
+		/// <summary>
+		/// Stops a track so it can be reused, does nothing if it was already stopped
+		/// </summary>
+		void stop(AnimationHandle handle);
+
+		/// <summary>
+		/// Gets the position of a track at the time of the frame
+		/// </summary>
+		raylib::Vector3 getPosition(AnimationHandle handle);
+
+		/// <summary>
+		/// Determines if a track played to its last keyframe, stopped tracks count as ended
+		/// </summary>
+		bool ended(AnimationHandle handle);
+
+		/// <summary>
+		/// Gets the number of tracks playing
+		/// </summary>
+		int getActiveCount();
 };
 
 Animation createInstantAnimation();
@@ -57,4 +163,4 @@ Animation createPickAndPlaceAnimation(raylib::Vector3 start, raylib::Vector3 end
 
 Animation createTeleportAnimation(raylib::Vector3 start, raylib::Vector3 end);
 
-#endif
\ No newline at end of file
+#endif
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include "Theme.h"
 #include "animation.h"
+#include "Profiler.h"
 
 void Board::drawTile(RenderQueue& renderQueue, int rank, int file, TileType type) {
     TilePosition tile = tileData[type];
@@ -10,7 +11,7 @@ void Board::drawTile(RenderQueue& renderQueue, int rank, int file, TileType type
     renderQueue.addSpriteObject(SpriteObject(raylib::Vector3(rank, file, -1), atlas, source));
 }
 
-Board::Board(raylib::Texture2D* texture, vector<Player>& players) : atlas(texture), players(players) {
+Board::Board(raylib::Texture2D* texture, vector<Player>& players, SoundBank* soundBank) : atlas(texture), players(players), soundBank(soundBank) {
     // Populate with generic tiles
     for (int rank = 0; rank < 8; rank++) {
         for (int file = 0; file < 8; file++) {
@@ -51,89 +52,189 @@ Board::Board(raylib::Texture2D* texture, vector<Player>& players) : atlas(textur
     tiles[7][4]->setPiece(new King(atlas, 2));
 }
 
-void Board::draw(Theme& theme, RenderQueue& renderQueue, int player, Cell selectedCell) {
-    bool hide = false; 
+Board::~Board() {
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            delete tiles[rank][file]->removePiece();
+            delete tiles[rank][file];
+        }
+    }
+}
+
+void Board::updateHighlights(int player, Cell selectedCell) {
+    uint64_t highlights = 0; // Tiles to be highlighted, a bit for each cell
 
-    vector<Cell> highlightTiles; // List of tiles to be highlighted
+    hidePieces = false;
 
     if (isPlayable()) { // Highlight selected tiles if in play
         // If piece is selected, hide the other pieces
-        if (selectedCell.rank >= 0 && selectedCell.rank <= 7 && selectedCell.file >= 0 && selectedCell.file <= 7 && getTile(selectedCell)->hasPiece()) {
+        if (selectedCell.isInBounds() && getTile(selectedCell)->hasPiece()) {
             if (getTile(selectedCell)->getPiece()->getPlayer() == player) {
-                hide = true;
-
 				vector<Move> legalMoves = getTile(selectedCell)->getPiece()->getLegalMoves(*this);
 
 				for (Move& move : legalMoves) {
-
-					highlightTiles.push_back(move.to);
+					highlights |= 1ULL << (move.to.rank * 8 + move.to.file);
 				}
 
-                hide = true;
+                hidePieces = true;
             }
         }
     }
 
-    float time = GetTime(); // Get elapsed time
+    if (selectedCell.isInBounds()) highlights |= 1ULL << (selectedCell.rank * 8 + selectedCell.file); // Mouse is hovered
 
-    for (int rank = -1; rank <= 8; rank++) {
-        for (int file = -1; file <= 8; file++) {
+    // Highlighted tiles are drawn raised instead of baked, so the layer has to leave them out
+    if (highlights != highlightedCells) {
+        highlightedCells = highlights;
+        staticLayerDirty = true;
+    }
+}
 
-			raylib::Vector3 tilePosition = getIsoPositionAtCell(Cell(rank, file));
+bool Board::isHighlighted(int rank, int file) { return highlightedCells & (1ULL << (rank * 8 + file)); }
 
-            if (rank == -1 && file == -1) {
-                drawTile(renderQueue, rank, file, TILE_SE_CORNER);
-                continue;
-            }
-            else if (rank == -1 && file == 8) {
-                drawTile(renderQueue, rank, file, TILE_NE_CORNER);
-                continue;
-            }
-            else if (rank == 8 && file == -1) {
-                drawTile(renderQueue, rank, file, TILE_SW_CORNER);
-                continue;
-            }
-            else if (rank == 8 && file == 8) {
-                drawTile(renderQueue, rank, file, TILE_NW_CORNER);
-                continue;
-            }
-            else if (rank == -1) {
-                drawTile(renderQueue, rank, file, TILE_EAST_WALL);
-                continue;
-            }
-            else if (rank == 8) {
-                drawTile(renderQueue, rank, file, TILE_WEST_WALL);
-                continue;
-            }
-            else if (file == -1) {
-                drawTile(renderQueue, rank, file, TILE_SOUTH_WALL);
-                continue;
-            }
-            else if (file == 8) {
-                drawTile(renderQueue, rank, file, TILE_NORTH_WALL);
-                continue;
-            }
+void Board::draw(Theme& theme, RenderQueue& renderQueue) {
+    PROFILE_SCOPE("Board::draw");
 
-            Cell currentCell = Cell(rank, file); // make this whole function more representative of this
+    // Walls and base tiles come from the static layer, everything else is composited on top
+    if (staticLayer.id != 0) {
+        Rectangle source = { 0.0f, 0.0f, (float)STATIC_LAYER_WIDTH, -(float)STATIC_LAYER_HEIGHT }; // Render textures are stored upside down
+        DrawTextureRec(staticLayer.texture, source, { STATIC_LAYER_X, STATIC_LAYER_Y }, WHITE);
+    }
+
+    float time = GetTime(); // Get elapsed time
+
+    bool redrawn[10][10] = {}; // Static cells already queued again, by iso position offset by 1 for the walls
+
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            Cell currentCell = Cell(rank, file);
 
-            auto it = find(highlightTiles.begin(), highlightTiles.end(), currentCell);
+			raylib::Vector3 tilePosition = getIsoPositionAtCell(currentCell);
 
             Tile* tile = getTile(currentCell);
 
-            // Apply sine wave for a wavy effect
-            float waveOffset = max(sin(time + (rank + file) * 0.4f) * 0.2f, 0.0f);
+            if (isHighlighted(rank, file)) { // Hovered tile or possible moves on hovered piece
+                // Apply sine wave for a wavy effect
+                float waveOffset = max(sin(time + (rank + file) * 0.4f) * 0.2f, 0.0f);
 
-            if (selectedCell.rank == rank && selectedCell.file == file) { // Mouse is hovered
                 tile->draw(theme, renderQueue, tilePosition.x, tilePosition.y, waveOffset, true, false);
-            } else if (it != highlightTiles.end()) { // Possible moves on hovered piece
-                tile->draw(theme, renderQueue, tilePosition.x, tilePosition.y, waveOffset, true, false);
-            } else { // Normal rendering
-                tile->draw(theme, renderQueue, tilePosition.x, tilePosition.y, waveOffset, false, hide);
+
+                // The raised tile is sorted over everything in the static layer, so the cells in front of it are queued again to cover it like they would
+                int isoX = (int)tilePosition.x;
+                int isoY = (int)tilePosition.y;
+
+                const int frontOffsets[3][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 } };
+
+                for (const auto& offset : frontOffsets) {
+                    int frontX = isoX + offset[0];
+                    int frontY = isoY + offset[1];
+
+                    bool onBoard = frontX <= 7 && frontY <= 7;
+
+                    if (redrawn[frontX + 1][frontY + 1] || (onBoard && isHighlighted(7 - frontY, frontX))) continue;
+
+                    drawStaticCell(theme, renderQueue, frontX, frontY);
+                    redrawn[frontX + 1][frontY + 1] = true;
+                }
+            } else { // Normal rendering, the tile itself is already in the static layer
+                tile->drawPiece(renderQueue, tilePosition.x, tilePosition.y, 0.0f, hidePieces);
             }
         }
     }
 }
 
+void Board::drawStaticCell(Theme& theme, RenderQueue& renderQueue, int isoX, int isoY) {
+    if (isoX == -1 && isoY == -1) {
+        drawTile(renderQueue, isoX, isoY, TILE_SE_CORNER);
+    }
+    else if (isoX == -1 && isoY == 8) {
+        drawTile(renderQueue, isoX, isoY, TILE_NE_CORNER);
+    }
+    else if (isoX == 8 && isoY == -1) {
+        drawTile(renderQueue, isoX, isoY, TILE_SW_CORNER);
+    }
+    else if (isoX == 8 && isoY == 8) {
+        drawTile(renderQueue, isoX, isoY, TILE_NW_CORNER);
+    }
+    else if (isoX == -1) {
+        drawTile(renderQueue, isoX, isoY, TILE_EAST_WALL);
+    }
+    else if (isoX == 8) {
+        drawTile(renderQueue, isoX, isoY, TILE_WEST_WALL);
+    }
+    else if (isoY == -1) {
+        drawTile(renderQueue, isoX, isoY, TILE_SOUTH_WALL);
+    }
+    else if (isoY == 8) {
+        drawTile(renderQueue, isoX, isoY, TILE_NORTH_WALL);
+    }
+    else {
+        getTile(7 - isoY, isoX)->drawBase(theme, renderQueue, isoX, isoY, 0.0f, false);
+    }
+}
+
+void Board::renderStaticLayer(Theme& theme) {
+    PROFILE_SCOPE("Board::renderStaticLayer");
+
+    // Theme tiles changed since the last render
+    if (theme.getDefaultWhite() != staticLayerWhite || theme.getDefaultBlack() != staticLayerBlack) {
+        staticLayerWhite = theme.getDefaultWhite();
+        staticLayerBlack = theme.getDefaultBlack();
+        staticLayerDirty = true;
+    }
+
+    if (!staticLayerDirty) return;
+
+    if (staticLayer.id == 0) {
+        staticLayer = raylib::RenderTexture::Load(STATIC_LAYER_WIDTH, STATIC_LAYER_HEIGHT);
+    }
+
+    RenderQueue layerQueue;
+
+    for (int isoX = -1; isoX <= 8; isoX++) {
+        for (int isoY = -1; isoY <= 8; isoY++) {
+            bool onBoard = isoX >= 0 && isoX <= 7 && isoY >= 0 && isoY <= 7;
+
+            if (onBoard && isHighlighted(7 - isoY, isoX)) continue; // Drawn raised every frame instead
+
+            drawStaticCell(theme, layerQueue, isoX, isoY);
+        }
+    }
+
+    layerQueue.sortQueue();
+
+    // Shift the board so the top left of the static layer lands on the texture's origin
+    Camera2D layerCamera = { 0 };
+    layerCamera.offset = { -STATIC_LAYER_X, -STATIC_LAYER_Y };
+    layerCamera.zoom = 1.0f;
+
+    BeginTextureMode(staticLayer);
+    ClearBackground(BLANK);
+    BeginMode2D(layerCamera);
+    layerQueue.draw();
+    EndMode2D();
+    EndTextureMode();
+
+    staticLayerDirty = false;
+}
+
+void Board::invalidateStaticLayer() { staticLayerDirty = true; }
+
+void Board::releaseStaticLayer() {
+    staticLayer = raylib::RenderTexture(::RenderTexture{ 0 }); // Unloads the old texture
+    staticLayerDirty = true;
+}
+
+Random& Board::getRandom() { return random; }
+
+int Board::getPortalCounter() { return portalCounter; }
+
+void Board::setPortalCounter(int counter) { portalCounter = counter; }
+
+void Board::playSound(SoundEffect effect) {
+    if (soundBank) soundBank->play(effect);
+}
+
 Cell Board::getCell(Piece* piece) {
     for (int rank = 0; rank < 8; rank++) {
         for (int file = 0; file < 8; file++) {
@@ -181,6 +282,8 @@ Cell Board::getCellAtScreenPosition(raylib::Vector2 screenPosition, raylib::Came
 }
 
 void Board::update(int player) {
+    PROFILE_SCOPE("Board::update");
+
     // Update all tiles
     for (int rank = 0; rank < 8; rank++) {
         for (int file = 0; file < 8; file++) {
@@ -188,43 +291,60 @@ void Board::update(int player) {
         }
     }
 
-    double currentTime = GetTime();
+    // When animations are instant, nothing stops the phases from all finishing on this update (except a promotion being chosen)
+    bool chainPhases = !instantAnimations && AnimationTimeline::get().isInstant();
+    bool advanced;
 
-    if (handlingPlayerTurn) {
-        if (allMoveAnimationsFinished()) {
-            executeQueuedMoves();
+    do {
+        advanced = false;
 
-            applyAllTileEffects(); // Apply tile effects
+        if (handlingPlayerTurn) {
+            if (allMoveAnimationsFinished()) {
+                executeQueuedMoves();
 
-            removeConflictingMoves(); // Remove any conflicting tile moves
+                applyAllTileEffects(); // Apply tile effects
 
-            handlingPlayerTurn = false;
-            handlingTileEffects = true;
-        }
-    } else if (handlingTileEffects) {
-        if (allMoveAnimationsFinished()) {
-            executeQueuedMoves();
+                removeConflictingMoves(); // Remove any conflicting tile moves
 
-            promotePieces(player);
+                handlingPlayerTurn = false;
+                handlingTileEffects = true;
+                advanced = true;
 
-            handlingPiecePromotion = true;
-            handlingTileEffects = false;
-        }
-    } else if (handlingPiecePromotion) { // Continued unfinished promotions until all are gone
-        if (!hasPromotion()) { // No more promotions left
-            handlingStateUpdate = true;
+                if (onAnimationsFinished) onAnimationsFinished();
+            }
+        } else if (handlingTileEffects) {
+            if (allMoveAnimationsFinished()) {
+                executeQueuedMoves();
+
+                promotePieces(player);
+
+                handlingPiecePromotion = true;
+                handlingTileEffects = false;
+                advanced = true;
 
-            handlingPiecePromotion = false;
+                if (onAnimationsFinished) onAnimationsFinished();
+            }
+        } else if (handlingPiecePromotion) { // Continued unfinished promotions until all are gone
+            if (!hasPromotion()) { // No more promotions left
+                handlingStateUpdate = true;
+
+                handlingPiecePromotion = false;
+            }
         }
-    }
+    } while (chainPhases && advanced);
 }
 
 void Board::updateState() {
-    cout << "Updated board state..." << endl;
+    GAME_LOG("Updated board state..." << endl);
     // Update the state of every tile
     for (int rank = 0; rank < 8; rank++) {
         for (int file = 0; file < 8; file++) {
+            Piece* piece = tiles[rank][file]->getPiece();
+            bool wasFrozen = piece && piece->getImmobile();
+
             tiles[rank][file]->updateState(*this);
+
+            if (wasFrozen && !piece->getImmobile()) playSound(SOUND_ICE_THAW);
         }
     }
 
@@ -232,6 +352,8 @@ void Board::updateState() {
 
     spawnRandomTiles(); // Spawn random tiles;
 
+    invalidateStaticLayer(); // Lifetimes changed, so some tiles might look different
+
     handlingStateUpdate = false;
 }
 
@@ -241,7 +363,7 @@ void Board::removeExpiredTiles() {
         for (int file = 0; file < 8; file++) {
             Tile* tile = tiles[rank][file];
             if (tile->getLifetime() == 0) {
-                changeTile(rank, file, new BasicTile(atlas));
+                delete changeTile(rank, file, new BasicTile(atlas));
             }
         }
     }
@@ -255,29 +377,32 @@ void Board::queueMove(Move move) {
     //TODO: need to change the animation for things like conveyor belts / portals
     // The place to do it is here
 
-    switch (move.type) {
-        case MoveType::CONVEYOR_MOVE: {
-            cout << "CONVEYOR MOVE FOUND!" << endl;
-            raylib::Vector3 fromPos = getIsoPositionAtCell(move.from);
-            raylib::Vector3 toPos = getIsoPositionAtCell(move.to);
+    // Without an animation the move is executed on the next update
+    if (!instantAnimations) {
+        switch (move.type) {
+            case MoveType::CONVEYOR_MOVE: {
+                GAME_LOG("CONVEYOR MOVE FOUND!" << endl);
+                raylib::Vector3 fromPos = getIsoPositionAtCell(move.from);
+                raylib::Vector3 toPos = getIsoPositionAtCell(move.to);
 
-            raylib::Vector3 offset = toPos - fromPos;
+                raylib::Vector3 offset = toPos - fromPos;
 
-            animatingPiece->playAnimation(createSlideAnimation({ 0, 0, 0 }, offset));
-            break;
-        }
-        case MoveType::PORTAL_MOVE: {
-            raylib::Vector3 fromPos = getIsoPositionAtCell(move.from);
-            raylib::Vector3 toPos = getIsoPositionAtCell(move.to);
+                animatingPiece->playAnimation(createSlideAnimation({ 0, 0, 0 }, offset));
+                break;
+            }
+            case MoveType::PORTAL_MOVE: {
+                raylib::Vector3 fromPos = getIsoPositionAtCell(move.from);
+                raylib::Vector3 toPos = getIsoPositionAtCell(move.to);
 
-            raylib::Vector3 offset = toPos - fromPos;
+                raylib::Vector3 offset = toPos - fromPos;
 
-            animatingPiece->playAnimation(createTeleportAnimation({ 0, 0, 0 }, offset));
-            break;
+                animatingPiece->playAnimation(createTeleportAnimation({ 0, 0, 0 }, offset));
+                break;
+            }
+            default:
+                animatingPiece->playAnimation(animatingPiece->createMoveAnimation(*this, move.from, move.to));
+                break;
         }
-        default:
-            animatingPiece->playAnimation(animatingPiece->createMoveAnimation(*this, move.from, move.to));
-            break;
     }
 
     // It's debatable whether or not tiles that move the pieces should count as a piece move, but I'm going to say yes
@@ -286,6 +411,55 @@ void Board::queueMove(Move move) {
     queuedMoves.push_back(move); // Add the move to the queue
 }
 
+void Board::startTurn(Move move) {
+    // Since castling is the only move that moves 2 pieces at the same time, i'm just handling it here.
+    // It might be a good idea to test this with interactions though.
+
+    // Handle specific move flags
+    if (move.flag.has_value()) {
+        switch (move.flag.value()) {
+        case MoveFlag::CASTLE: { // King castling
+            GAME_LOG("Castled!" << endl);
+            int direction = (move.to.file > move.from.file) ? 1 : -1;
+
+            // Rook starts on the edge of the board depending on direction
+            int rookStartFile = (direction == 1) ? 7 : 0;
+            int rookEndFile = move.from.file + direction;
+
+            Cell rookFrom(move.from.rank, rookStartFile);
+            Cell rookTo(move.from.rank, rookEndFile);
+
+            // Create and queue a rook move
+            Move rookMove(rookFrom, rookTo, false); // or whatever animation you prefer
+            queueMove(rookMove);
+            clearEnPassantableCell();
+            break;
+        }
+        case MoveFlag::EN_PASSANTABLE: { // Pawn moving two tiles
+            GAME_LOG("Piece is en passantable!" << endl);
+            setEnPassantableCell(move.to); // Set the en passantable cell
+            break;
+        }
+        case MoveFlag::EN_PASSANT: { // Pawn taking a pawn in en passant
+            GAME_LOG("Player used en passant!" << endl);
+            break;
+        }
+        case MoveFlag::PROMOTION: { // Pawm moving to be promoted
+            GAME_LOG("Pawn is to be promoted!" << endl);
+            clearEnPassantableCell();
+            break;
+        }
+        }
+    }
+    else {
+        clearEnPassantableCell();
+    }
+
+    queueMove(move); // Queue the player's move up
+
+    handlingPlayerTurn = true;
+}
+
 void Board::removeConflictingMoves() {
     // Remove conflicting moves (moves with the same destination)
     for (auto it = queuedMoves.begin(); it != queuedMoves.end(); ++it) {
@@ -325,38 +499,168 @@ void Board::removeConflictingMoves() {
 }
 
 void Board::executeQueuedMoves() {
-	cout << "Executing queued moves" << endl;
+	GAME_LOG("Executing queued moves" << endl);
     for (auto& move : queuedMoves) {
         Piece* animatingPiece = getTile(move.from)->getPiece();
 
         if (animatingPiece) {
 			animatingPiece->removeAnimation(); // Remove the moving animation from the piece
         } else {
-            cout << "ERROR: cannot find piece at location: " << move.from.rank << ", " << move.from.file << endl;
+            GAME_LOG("ERROR: cannot find piece at location: " << move.from.rank << ", " << move.from.file << endl);
         }
 
         // If the move is en passant, remove the overtaken piece manually
         if (move.flag.has_value() && move.flag.value() == MoveFlag::EN_PASSANT) {
             Piece* overtakenPiece = getTile(getEnPassantableCell())->removePiece();
 
-            // TODO: do something with this piece here so it doesn't cause a memory leak
+            if (overtakenPiece) playSound(overtakenPiece->getPlayer() == 1 ? SOUND_PIECE_LOST : SOUND_PIECE_TAKEN);
+
+            delete overtakenPiece;
         }
 
         getTile(move.to)->queuePiece(getTile(move.from)->removePiece());
+
+        if (move.type != MoveType::PLAYER_MOVE && onTileMove) onTileMove(move);
     }
 
     // Dequeue all the pieces and complete the move
     for (int rank = 0; rank < 8; rank++) {
         for (int file = 0; file < 8; file++) {
-            tiles[rank][file]->dequeuePiece();
+            Piece* capturedPiece = tiles[rank][file]->dequeuePiece();
+
+            if (capturedPiece) playSound(capturedPiece->getPlayer() == 1 ? SOUND_PIECE_LOST : SOUND_PIECE_TAKEN);
+
+            delete capturedPiece;
         }
     }
 
     queuedMoves.clear();
 }
 
+Piece* Board::createPiece(PieceType type, int player) {
+    switch (type) {
+        case PieceType::PAWN:   return new Pawn(atlas, player);
+        case PieceType::KNIGHT: return new Knight(atlas, player);
+        case PieceType::BISHOP: return new Bishop(atlas, player);
+        case PieceType::ROOK:   return new Rook(atlas, player);
+        case PieceType::QUEEN:  return new Queen(atlas, player);
+        case PieceType::KING:   return new King(atlas, player);
+        default: throw runtime_error("Can't create a piece without a type!");
+    }
+}
+
+Tile* Board::createTile(const PositionTile& positionTile) {
+    Tile* tile = nullptr;
+
+    switch (positionTile.kind) {
+        case TileKind::BASIC:    return new BasicTile(atlas);
+        case TileKind::ICE:      tile = new IceTile(atlas); break;
+        case TileKind::BREAKING: tile = new BreakingTile(atlas); break;
+        case TileKind::CONVEYOR: tile = new ConveyorTile(atlas, positionTile.direction); break;
+        case TileKind::PORTAL:   tile = new PortalTile(atlas, positionTile.portalNumber); break;
+    }
+
+    tile->setLifetime(positionTile.lifetime);
+
+    return tile;
+}
+
+Position Board::getPosition() { return getState().toPosition(); }
+
+void Board::setPosition(const Position& position) {
+    GameState state = GameState::fromPosition(position);
+    state.setRandom(random); // Positions don't have random numbers, so keep the board's
+
+    setState(state);
+}
+
+GameState Board::getState() {
+    GameState state;
+
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            Tile* tile = tiles[rank][file];
+            PositionTile stateTile;
+
+            if (dynamic_cast<IceTile*>(tile)) {
+                stateTile.kind = TileKind::ICE;
+            } else if (dynamic_cast<BreakingTile*>(tile)) {
+                stateTile.kind = TileKind::BREAKING;
+            } else if (ConveyorTile* conveyor = dynamic_cast<ConveyorTile*>(tile)) {
+                stateTile.kind = TileKind::CONVEYOR;
+                stateTile.direction = conveyor->getDirection();
+            } else if (PortalTile* portal = dynamic_cast<PortalTile*>(tile)) {
+                stateTile.kind = TileKind::PORTAL;
+                stateTile.portalNumber = portal->getPortalNumber();
+            }
+
+            if (stateTile.kind != TileKind::BASIC) {
+                stateTile.lifetime = tile->getLifetime();
+                state.setTile(Cell(rank, file), stateTile);
+            }
+
+            Piece* piece = tile->getPiece();
+
+            if (piece) state.setPiece(Cell(rank, file), { piece->getType(), piece->getPlayer(), piece->getNumberOfMoves() > 0, piece->getFrozen() });
+        }
+    }
+
+    state.setEnPassantableCell(enPassantableCell);
+    state.setRandom(random);
+    state.portalCounter = (uint16_t)portalCounter;
+
+    return state;
+}
+
+void Board::setState(const GameState& state) {
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            setStateCell(state, Cell(rank, file));
+        }
+    }
+
+    setStateScalars(state);
+}
+
+void Board::setState(const GameState& state, const vector<Cell>& cells) {
+    for (const Cell& cell : cells) setStateCell(state, cell);
+
+    setStateScalars(state);
+}
+
+void Board::setStateCell(const GameState& state, Cell cell) {
+    PositionPiece statePiece = state.getPiece(cell);
+
+    delete tiles[cell.rank][cell.file]->removePiece();
+    delete setTile(cell.rank, cell.file, createTile(state.getTile(cell)));
+
+    if (statePiece.type == PieceType::NO_PIECE) return;
+
+    Piece* piece = createPiece(statePiece.type, statePiece.player);
+
+    if (statePiece.hasMoved) piece->move(); // Only whether it moved matters, not how many times
+    if (statePiece.frozen > 0) piece->setFrozen(statePiece.frozen);
+
+    tiles[cell.rank][cell.file]->setPiece(piece);
+}
+
+void Board::setStateScalars(const GameState& state) {
+    enPassantableCell = state.getEnPassantableCell();
+    random = state.getRandom();
+    portalCounter = state.portalCounter;
+
+    // Drop anything left over from the turn that was being played
+    queuedMoves.clear();
+    promotions = queue<Cell>();
+
+    handlingPlayerTurn = false;
+    handlingTileEffects = false;
+    handlingPiecePromotion = false;
+    handlingStateUpdate = false;
+}
+
 void Board::promotePieces(int player) {
-    cout << "Promoting pieces..." << endl;
+    GAME_LOG("Promoting pieces..." << endl);
 
     int piecesPromoted = 0;
     // Add all promotions
@@ -373,6 +677,20 @@ void Board::promotePieces(int player) {
     }
 }
 
+void Board::promotePiece(Cell cell, PieceType type) {
+    if (type == PieceType::NO_PIECE || type == PieceType::PAWN || type == PieceType::KING) {
+        throw runtime_error("Pawns can't be promoted to that piece!");
+    }
+
+    Tile* tile = getTile(cell);
+    Piece* newPiece = createPiece(type, tile->getPiece()->getPlayer());
+
+    delete tile->removePiece();
+    tile->setPiece(newPiece);
+
+    if (onPromotion) onPromotion(cell, type);
+}
+
 bool Board::hasPromotion() { return !promotions.empty(); }
 
 Cell Board::getPromotionCell() {
@@ -396,6 +714,11 @@ Tile* Board::setTile(int rank, int file, Tile* newTile) {
     Tile* oldTile = tiles[rank][file];
     tiles[rank][file] = newTile;
 
+    countTile(oldTile, -1);
+    countTile(newTile, 1);
+
+    invalidateStaticLayer();
+
     return oldTile;
 }
 
@@ -646,7 +969,7 @@ bool Board::isInStalemate(int player) {
 }
 
 void Board::spawnRandomTiles() {
-    int randSpawn = rand() % 20;
+    int randSpawn = random.nextInt(20);
 
     switch (randSpawn) {
         case 0:
@@ -678,74 +1001,84 @@ void Board::spawnRandomTiles() {
 }
 
 void Board::spawnRandomTiles(TileSpawnType type) {
+    TileSpawn spawn;
+    spawn.type = type;
+
     switch (type) {
         case TileSpawnType::PORTAL_SPAWN: {
-            Tile* spawnTileFirst;
-            Tile* spawnTileSecond;
+            spawn.first = Cell(random.nextInt(8), random.nextInt(8));
+            spawn.second = Cell(random.nextInt(8), random.nextInt(8));
 
-            raylib::Vector2 spawnPositionFirst(rand() % 8, rand() % 8);
-            raylib::Vector2 spawnPositionSecond(rand() % 8, rand() % 8);
+			// Keep trying to spawn until two empty tiles are found (that are not the same)
+            while (getTile(spawn.first)->hasPiece() || getTile(spawn.second)->hasPiece() || spawn.first == spawn.second) {
+                spawn.first = Cell(random.nextInt(8), random.nextInt(8));
+                spawn.second = Cell(random.nextInt(8), random.nextInt(8));
+            }
+            break;
+        }
 
-            spawnTileFirst = getTile(spawnPositionFirst.x, spawnPositionFirst.y);
-            spawnTileSecond = getTile(spawnPositionSecond.x, spawnPositionSecond.y);
+        case TileSpawnType::ICE_SPAWN:
+        case TileSpawnType::BREAK_SPAWN: {
+            do {
+                spawn.first = Cell(random.nextInt(8), random.nextInt(8));
+            } while (dynamic_cast<BasicTile*>(getTile(spawn.first)) == nullptr);
+            break;
+        }
 
-			// Keep trying to spawn until two empty tiles are found (that are not the same)
-            while (spawnTileFirst->hasPiece() || spawnTileSecond->hasPiece() || spawnPositionFirst == spawnPositionSecond) {
-                spawnPositionFirst = raylib::Vector2(rand() % 8, rand() % 8);
-                spawnPositionSecond = raylib::Vector2(rand() % 8, rand() % 8);
+        case TileSpawnType::CONVEYOR_ROW_SPAWN: {
+            spawn.first = Cell(random.nextInt(4) + 2, 0); // can only spawn on ranks 3 - 6
+            break;
+        }
 
-                spawnTileFirst = getTile(spawnPositionFirst.x, spawnPositionFirst.y);
-                spawnTileSecond = getTile(spawnPositionSecond.x, spawnPositionSecond.y);
-            }
+        case TileSpawnType::CONVEYOR_LOOP_SPAWN: {
+            spawn.width = random.nextInt(3) + 2;  // width of 2 - 4
+            spawn.length = random.nextInt(3) + 2; // length of 2 - 4
+
+            int x = random.nextInt(8 - spawn.width);
+            int y = random.nextInt(8 - spawn.length);
+
+            spawn.first = Cell(x, y);
+            break;
+        }
+    }
 
+    spawnTiles(spawn);
+}
+
+void Board::spawnTiles(const TileSpawn& spawn) {
+    switch (spawn.type) {
+        case TileSpawnType::PORTAL_SPAWN: {
             // Create two linked portals
-			changeTile(spawnPositionFirst.x,  spawnPositionFirst.y,  new PortalTile(atlas, portalCounter));
-            changeTile(spawnPositionSecond.x, spawnPositionSecond.y, new PortalTile(atlas, portalCounter));
+            delete changeTile(spawn.first.rank,  spawn.first.file,  new PortalTile(atlas, portalCounter));
+            delete changeTile(spawn.second.rank, spawn.second.file, new PortalTile(atlas, portalCounter));
 
             portalCounter++;
             break;
         }
 
         case TileSpawnType::ICE_SPAWN: {
-            while (true) {
-                raylib::Vector2 spawnPosition(rand() % 8, rand() % 8);
-
-                Tile* spawnTile = getTile(spawnPosition.x, spawnPosition.y);
-                if (dynamic_cast<BasicTile*>(spawnTile) != nullptr) {
-                    changeTile(spawnPosition.x, spawnPosition.y, new IceTile(atlas));
-                    return;
-                }
-            }
+            delete changeTile(spawn.first.rank, spawn.first.file, new IceTile(atlas));
             break;
         }
 
         case TileSpawnType::BREAK_SPAWN: {
-            while (true) {
-                raylib::Vector2 spawnPosition(rand() % 8, rand() % 8);
-
-                Tile* spawnTile = getTile(spawnPosition.x, spawnPosition.y);
-                if (dynamic_cast<BasicTile*>(spawnTile) != nullptr) {
-                    changeTile(spawnPosition.x, spawnPosition.y, new BreakingTile(atlas));
-                    return;
-                }
-            }
+            delete changeTile(spawn.first.rank, spawn.first.file, new BreakingTile(atlas));
             break;
         }
 
         case TileSpawnType::CONVEYOR_ROW_SPAWN: {
-            int rank = rand() % 4 + 2; // can only spawn on ranks 3 - 6
             for (int i = 0; i < 8; i++) {
-                changeTile(rank, i, new ConveyorTile(atlas, RIGHT));
+                delete changeTile(spawn.first.rank, i, new ConveyorTile(atlas, RIGHT));
             }
             break;
         }
 
         case TileSpawnType::CONVEYOR_LOOP_SPAWN: {
-            int width = rand() % 3 + 2;  // width of 2 - 4
-            int length = rand() % 3 + 2; // length of 2 - 4
+            int x = spawn.first.rank;
+            int y = spawn.first.file;
 
-            int x = rand() % (8 - width);
-            int y = rand() % (8 - width);
+            int width = spawn.width;
+            int length = spawn.length;
 
             bool clockwise = false; // rand() % 2; // Random direction
 
@@ -753,28 +1086,39 @@ void Board::spawnRandomTiles(TileSpawnType type) {
 
             // Top rank
             for (int i = cw; i < width - 1 + cw; i++) {
-                changeTile(x + i, y, new ConveyorTile(atlas, clockwise ? RIGHT : LEFT));
+                delete changeTile(x + i, y, new ConveyorTile(atlas, clockwise ? RIGHT : LEFT));
             }
 
             for (int i = cw; i < length - 1 + cw; i++) {
-                changeTile(x + width - 1, y + i, new ConveyorTile(atlas, clockwise ? UP : DOWN));
+                delete changeTile(x + width - 1, y + i, new ConveyorTile(atlas, clockwise ? UP : DOWN));
             }
 
             // Bottom rank
             for (int i = cw; i < width - 1 + cw; i++) {
-                changeTile(x + (width - 1) - i, y + (length - 1), new ConveyorTile(atlas, clockwise ? LEFT : RIGHT));
+                delete changeTile(x + (width - 1) - i, y + (length - 1), new ConveyorTile(atlas, clockwise ? LEFT : RIGHT));
             }
 
             // Left column
             for (int i = cw; i < length - 1 + cw; i++) {
-                changeTile(x, y + (length - 1) - i, new ConveyorTile(atlas, clockwise ? DOWN : UP));
+                delete changeTile(x, y + (length - 1) - i, new ConveyorTile(atlas, clockwise ? DOWN : UP));
             }
 
             break;
         }
     }
+
+    if (onTileSpawn) onTileSpawn(spawn);
 }
 
+void Board::countTile(Tile* tile, int delta) {
+    if (dynamic_cast<IceTile*>(tile)) tileCounts.ice += delta;
+    else if (dynamic_cast<ConveyorTile*>(tile)) tileCounts.conveyor += delta;
+    else if (dynamic_cast<BreakingTile*>(tile)) tileCounts.breaking += delta;
+    else if (dynamic_cast<PortalTile*>(tile)) tileCounts.portal += delta;
+}
+
+const TileCounts& Board::getTileCounts() { return tileCounts; }
+
 template <typename T>
 int Board::getTileCount() {
     int count = 0;
@@ -5,6 +5,7 @@
 #include <utility>
 #include <iostream>
 #include <optional>
+#include <cstdint>
 
 #include "tile.h"
 #include "customtiles.h"
@@ -16,8 +17,14 @@
 #include "RenderQueue.h"
 #include "Move.h"
 #include "Cell.h"
+#include "SoundBank.h"
+#include "Random.h"
+#include "Position.h"
+#include "GameState.h"
+#include "Log.h"
 
 #include <queue>
+#include <functional>
 
 using namespace std;
 
@@ -29,6 +36,29 @@ enum class TileSpawnType {
     PORTAL_SPAWN
 };
 
+/// <summary>
+/// Everything needed to place a group of tiles, so a spawn can be recorded and played back exactly
+/// </summary>
+struct TileSpawn {
+    TileSpawnType type;
+
+    Cell first;  // Tile to spawn on, the rank of a conveyor row or the corner of a conveyor loop
+    Cell second; // The linked tile of a portal spawn
+
+    int width = 0;  // Size of a conveyor loop
+    int length = 0;
+};
+
+/// <summary>
+/// Number of special tiles on the board, kept up to date as tiles are set
+/// </summary>
+struct TileCounts {
+    int ice = 0;
+    int conveyor = 0;
+    int breaking = 0;
+    int portal = 0;
+};
+
 class Board {
     private:
         Tile* tiles[8][8];
@@ -36,6 +66,8 @@ class Board {
 
         vector<Player>& players;
 
+        SoundBank* soundBank;
+
         vector<Move> queuedMoves;
 
         queue<Cell> promotions;
@@ -47,21 +79,163 @@ class Board {
 
         int portalCounter = 0;
 
+        TileCounts tileCounts;
+
+        /// <summary>
+        /// Random numbers for tile spawns, seeded by the game so a board can be replayed
+        /// </summary>
+        Random random;
+
+        /// <summary>
+        /// Adds or removes a tile from the tile counts
+        /// </summary>
+        /// <param name="tile">The tile being added or removed</param>
+        /// <param name="delta">1 if the tile was added, -1 if it was removed</param>
+        void countTile(Tile* tile, int delta);
+
+        /// <summary>
+        /// Walls, corners and base tiles pre-rendered once, since they only change between turns
+        /// </summary>
+        raylib::RenderTexture staticLayer{ ::RenderTexture{ 0 } };
+
+        /// <summary>
+        /// If the static layer needs to be rendered again before it is drawn
+        /// </summary>
+        bool staticLayerDirty = true;
+
+        /// <summary>
+        /// The theme tiles the static layer was last rendered with
+        /// </summary>
+        TileType staticLayerWhite = TILE_COUNT;
+        TileType staticLayerBlack = TILE_COUNT;
+
+        /// <summary>
+        /// Cells drawn raised this frame, a bit for each cell (rank * 8 + file). They're left out of the static layer
+        /// </summary>
+        uint64_t highlightedCells = 0;
+
+        /// <summary>
+        /// If pieces off the highlighted cells are hidden, while a piece is selected
+        /// </summary>
+        bool hidePieces = false;
+
+        // Screen space area covered by the static layer (the board plus its walls)
+        static constexpr float STATIC_LAYER_X = -5.0f * TILE_WIDTH;
+        static constexpr float STATIC_LAYER_Y = -1.0f * TILE_HEIGHT;
+        static constexpr int STATIC_LAYER_WIDTH = 10 * TILE_WIDTH;
+        static constexpr int STATIC_LAYER_HEIGHT = 11 * TILE_HEIGHT;
+
         void drawTile(RenderQueue& renderQueue, int rank, int file, TileType type);
 
+        /// <summary>
+        /// Draws what the static layer holds at an iso position, a wall or corner outside the board and the base tile on it
+        /// </summary>
+        void drawStaticCell(Theme& theme, RenderQueue& renderQueue, int isoX, int isoY);
+
+        bool isHighlighted(int rank, int file);
+
+        /// <summary>
+        /// Creates a new piece of a type
+        /// </summary>
+        Piece* createPiece(PieceType type, int player);
+
+        /// <summary>
+        /// Creates a new tile from a position's tile
+        /// </summary>
+        Tile* createTile(const PositionTile& tile);
+
+        /// <summary>
+        /// Replaces the piece and tile on a cell with the ones in a state
+        /// </summary>
+        void setStateCell(const GameState& state, Cell cell);
+
+        /// <summary>
+        /// Sets the en passant cell, random numbers and portal counter from a state, and drops the turn being played
+        /// </summary>
+        void setStateScalars(const GameState& state);
+
     public:
         bool handlingPlayerTurn = false;
         bool handlingTileEffects = false;
         bool handlingPiecePromotion = false;
         bool handlingStateUpdate = false;
 
-        Board(raylib::Texture2D* texture, vector<Player>& players);
+        /// <summary>
+        /// Skips move animations so every phase finishes on the same update, used when running without a window
+        /// </summary>
+        bool instantAnimations = false;
+
+        /// <summary>
+        /// Called whenever tiles are spawned onto the board
+        /// </summary>
+        function<void(const TileSpawn&)> onTileSpawn;
+
+        /// <summary>
+        /// Called whenever a tile moves a piece, after the move is executed
+        /// </summary>
+        function<void(const Move&)> onTileMove;
+
+        /// <summary>
+        /// Called whenever a pawn is promoted
+        /// </summary>
+        function<void(Cell, PieceType)> onPromotion;
+
+        /// <summary>
+        /// Called whenever a phase of a turn finishes animating (the player's move, then the tile effects)
+        /// </summary>
+        function<void()> onAnimationsFinished;
+
+        Board(raylib::Texture2D* texture, vector<Player>& players, SoundBank* soundBank = nullptr);
+        ~Board();
+
+        Board(const Board&) = delete;
+        Board& operator=(const Board&) = delete;
+
+        /// <summary>
+        /// Plays a sound effect through the game's sound bank, if it has one
+        /// </summary>
+        /// <param name="effect">The effect to play</param>
+        void playSound(SoundEffect effect);
+
+        /// <summary>
+        /// Gets the random number generator used for everything that happens on the board
+        /// </summary>
+        Random& getRandom();
+
+        /// <summary>
+        /// Gets the number the next pair of portals spawns with, positions don't store it
+        /// </summary>
+        int getPortalCounter();
+
+        void setPortalCounter(int counter);
 
         /************************************|
                  GAME LOOP FUNCTIONS
         |************************************/
 
-        void draw(Theme& theme, RenderQueue& renderQueue, int player, Cell selectedCell);
+        /// <summary>
+        /// Works out which cells are highlighted for the hovered cell and the selected piece's moves.
+        /// Call it before renderStaticLayer, since highlighted cells are left out of the layer
+        /// </summary>
+        void updateHighlights(int player, Cell selectedCell);
+
+        void draw(Theme& theme, RenderQueue& renderQueue);
+
+        /// <summary>
+        /// Renders the walls and base tiles into the static layer if anything about them changed.
+        /// Must be called outside of any other texture or camera mode
+        /// </summary>
+        void renderStaticLayer(Theme& theme);
+
+        /// <summary>
+        /// Marks the static layer to be rendered again before the next draw
+        /// </summary>
+        void invalidateStaticLayer();
+
+        /// <summary>
+        /// Unloads the static layer, it's rendered again if the board is drawn after. Must be called before the window closes
+        /// </summary>
+        void releaseStaticLayer();
 
         /// <summary>
         /// Update called every frame
@@ -79,6 +253,38 @@ class Board {
         /// <returns>true if the the board is playable, false if not</returns>
         bool isPlayable();
 
+        /************************************|
+                 POSITION FUNCTIONS
+        |************************************/
+
+        /// <summary>
+        /// Gets the pieces, tiles, castling rights and en passant cell of the board.
+        /// The side to move and clocks are left at their defaults, since the board doesn't know them
+        /// </summary>
+        Position getPosition();
+
+        /// <summary>
+        /// Replaces every piece and tile on the board with the ones in a position
+        /// </summary>
+        /// <param name="position">The position to set up</param>
+        void setPosition(const Position& position);
+
+        /// <summary>
+        /// Gets the pieces, tiles, en passant cell, random numbers and portal counter of the board as flat data.
+        /// The side to move and clocks are left at their defaults, since the board doesn't know them
+        /// </summary>
+        GameState getState();
+
+        /// <summary>
+        /// Replaces every piece and tile on the board with the ones in a state, and carries on its random numbers and portal counter
+        /// </summary>
+        void setState(const GameState& state);
+
+        /// <summary>
+        /// Replaces only the given cells with the ones in a state, for when the rest of the board already matches it
+        /// </summary>
+        void setState(const GameState& state, const vector<Cell>& cells);
+
         /************************************|
                  PROMOTION FUNCTIONS
         |************************************/
@@ -101,6 +307,13 @@ class Board {
         /// <returns>The cell with the pawn to be promoted</returns>
         Cell getPromotionCell();
 
+        /// <summary>
+        /// Replaces a pawn with the piece it is promoted to
+        /// </summary>
+        /// <param name="cell">The cell of the pawn</param>
+        /// <param name="type">The piece to promote to (knight, bishop, rook or queen)</param>
+        void promotePiece(Cell cell, PieceType type);
+
         /************************************|
                 EN PASSANT FUNCTIONS
         |************************************/
@@ -176,6 +389,12 @@ class Board {
         template <typename T>
         int getTileCount();
 
+        /// <summary>
+        /// Gets the number of each special tile without scanning the board
+        /// </summary>
+        /// <returns>The current tile counts</returns>
+        const TileCounts& getTileCounts();
+
         /// <summary>
         /// Replace all expired tiles on the board with basic tiles
         /// </summary>
@@ -292,13 +511,21 @@ class Board {
         /// <param name="move">The move to add to the queue</param>
         void queueMove(Move move);
 
+        /// <summary>
+        /// Starts a player's turn with their move, queuing the rook of a castle and updating the en passant cell
+        /// </summary>
+        /// <param name="move">The move the player made, with its flags</param>
+        void startTurn(Move move);
+
         void applyAllTileEffects() {
-            cout << "Applying tile effects..." << endl;
+            GAME_LOG("Applying tile effects..." << endl);
             for (int rank = 0; rank < 8; rank++) {
                 for (int file = 0; file < 8; file++) {
                     tiles[rank][file]->applyTileEffect(*this);
                 }
             }
+
+            invalidateStaticLayer(); // Tile effects can change how tiles look (e.g. cracks)
         }
 
         /// <summary>
@@ -362,19 +589,25 @@ class Board {
 
         void spawnRandomTiles(TileSpawnType type);
 
+        /// <summary>
+        /// Places the tiles of a spawn on the board
+        /// </summary>
+        /// <param name="spawn">The spawn to place</param>
+        void spawnTiles(const TileSpawn& spawn);
+
         void printBoard() {
-            cout << endl << " BOARD: " << endl;
+            GAME_LOG(endl << " BOARD: " << endl);
 
             for (int rank = 7; rank >= 0; rank--) {
                 for (int file = 0; file < 8; file++) {
 					Piece* piece = tiles[rank][file]->getPiece();
                     if (piece) {
-						cout << piece->getAlgebraicNotation() << " ";
+						GAME_LOG(piece->getAlgebraicNotation() << " ");
                     } else {
-						cout << "- ";
+						GAME_LOG("- ");
                     }
                 }
-                cout << endl;
+                GAME_LOG(endl);
             }
         }
 };
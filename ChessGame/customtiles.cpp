@@ -7,7 +7,7 @@
 
 BasicTile::BasicTile(raylib::Texture2D* texture) : Tile(), atlas(texture) {}
 
-void BasicTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) {
+void BasicTile::drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) {
     TileType tileType = ((x + y) % 2 == 0) ? theme.getDefaultWhite() : theme.getDefaultBlack();
 
     TilePosition tile = tileData[tileType];
@@ -18,17 +18,13 @@ void BasicTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float
     };
 
     renderQueue.addSpriteObject(SpriteObject(raylib::Vector3(x, y, z - 1), atlas, source, selected ? RED : WHITE));
-
-    if (currentPiece != nullptr) {
-        currentPiece->draw(renderQueue, x, y, z, hide);
-    }
 }
 
 
 
 IceTile::IceTile(raylib::Texture2D* texture) : Tile(), atlas(texture) {}
 
-void IceTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) {
+void IceTile::drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) {
     TilePosition tile = tileData[TILE_ICE];
 
     Rectangle source = {
@@ -37,16 +33,14 @@ void IceTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z
     };
 
     renderQueue.addSpriteObject(SpriteObject(raylib::Vector3(x, y, z - 1), atlas, source, selected ? RED : BLUE));
-
-    if (currentPiece != nullptr) {
-        currentPiece->draw(renderQueue, x, y, z, hide);
-    }
 }
 
 void IceTile::applyTileEffect(Board& board) {
     if (hasPiece()) {
         currentPiece->setFrozen(6);
 
+        board.playSound(SOUND_ICE_FROZEN);
+
         lifetime = 0;
     } else {
         lifetime--;
@@ -57,7 +51,7 @@ void IceTile::applyTileEffect(Board& board) {
 
 BreakingTile::BreakingTile(raylib::Texture2D* texture) : Tile(6), atlas(texture) {}
 
-void BreakingTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) {
+void BreakingTile::drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) {
     TileType tileType = ((x + y) % 2 == 0) ? theme.getDefaultWhite() : theme.getDefaultBlack();
 
     TilePosition tile = tileData[tileType];
@@ -82,17 +76,17 @@ void BreakingTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, fl
 
     renderQueue.addSpriteObject(SpriteObject(raylib::Vector3(x, y, z - 1), atlas, source, selected ? RED : WHITE));
     renderQueue.addSpriteObject(SpriteObject(raylib::Vector3(x, y, z - 1 + 0.0001f), atlas, breakTileSource, WHITE));
-
-    if (currentPiece != nullptr) {
-        currentPiece->draw(renderQueue, x, y, z, hide);
-    }
 }
 
 void BreakingTile::applyTileEffect(Board& board) {
     if (hasPiece()) {
         lifetime--;
 
-        if (lifetime == 0) removePiece();
+        if (lifetime == 0) {
+            delete removePiece();
+
+            board.playSound(SOUND_ICE_BREAK);
+        }
     }
 }
 
@@ -100,7 +94,9 @@ void BreakingTile::applyTileEffect(Board& board) {
 
 ConveyorTile::ConveyorTile(raylib::Texture2D* texture, Direction direction) : Tile(10), atlas(texture), direction(direction) {}
 
-void ConveyorTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) {
+Direction ConveyorTile::getDirection() { return direction; }
+
+void ConveyorTile::drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) {
     TileType tileType = TILE_HORIZONTAL_CONVEYOR;
 
     if (direction == UP || direction == DOWN) {
@@ -112,10 +108,6 @@ void ConveyorTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, fl
     Rectangle source = { tile.tileX * TILE_SIZE, tile.tileY * TILE_SIZE, TILE_SIZE, TILE_SIZE };
 
     renderQueue.addSpriteObject(SpriteObject(raylib::Vector3(x, y, z - 1), atlas, source, selected ? RED : WHITE));
-
-    if (currentPiece != nullptr) {
-        currentPiece->draw(renderQueue, x, y, z, hide);
-    }
 }
 
 void ConveyorTile::applyTileEffect(Board& board) {
@@ -152,7 +144,9 @@ void ConveyorTile::applyTileEffect(Board& board) {
 
 PortalTile::PortalTile(raylib::Texture2D* texture, int portalNumber) : Tile(10), atlas(texture), portalNumber(portalNumber) { }
 
-void PortalTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) {
+int PortalTile::getPortalNumber() { return portalNumber; }
+
+void PortalTile::drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) {
     TileType tileType = ((x + y) % 2 == 0) ? theme.getDefaultWhite() : theme.getDefaultBlack();
 
     TilePosition tile = tileData[tileType];
@@ -180,10 +174,6 @@ void PortalTile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, floa
 
     renderQueue.addSpriteObject(SpriteObject(raylib::Vector3(x, y, z - 1), atlas, source, selected ? RED : WHITE));
     renderQueue.addSpriteObject(SpriteObject(raylib::Vector3(x, y, z - 1 + 0.0001f), atlas, portalSource, selected ? RED : portalColor));
-
-    if (currentPiece != nullptr) {
-        currentPiece->draw(renderQueue, x, y, z, hide);
-    }
 }
 
 void PortalTile::applyTileEffect(Board& board) {
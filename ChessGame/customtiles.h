@@ -13,7 +13,7 @@ class BasicTile : public Tile {
     public:
         BasicTile(raylib::Texture2D* texture);
 
-        void draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) override;
+        void drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) override;
 };
 
 class IceTile : public Tile {
@@ -23,7 +23,7 @@ class IceTile : public Tile {
     public:
         IceTile(raylib::Texture2D* texture);
 
-        void draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) override;
+        void drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) override;
 
         void applyTileEffect(Board& board) override;
 };
@@ -35,7 +35,7 @@ class BreakingTile : public Tile {
     public:
         BreakingTile(raylib::Texture2D* texture);
 
-        void draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) override;
+        void drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) override;
 
         void applyTileEffect(Board& board) override;
 };
@@ -55,7 +55,9 @@ class ConveyorTile : public Tile {
     public:
         ConveyorTile(raylib::Texture2D* texture, Direction direction);
 
-        void draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) override;
+        Direction getDirection();
+
+        void drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) override;
 
         void applyTileEffect(Board& board) override;
 };
@@ -68,7 +70,9 @@ class PortalTile : public Tile {
     public:
         PortalTile(raylib::Texture2D* texture, int portalNumber);
 
-        void draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) override;
+        int getPortalNumber();
+
+        void drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) override;
 
         void applyTileEffect(Board& board) override;
 };
@@ -1,34 +1,32 @@
 #include "game.h"
 #include <iostream>
+#include "Profiler.h"
+#include "Log.h"
 
-Game::Game(raylib::Texture2D* texture) : board(texture, players), theme(new SkyBackground(), TILE_GRASS_LIGHT, TILE_GRASS_DARK) {
+Game::Game(raylib::Texture2D* texture, bool headless, uint64_t seed) : board(texture, players, &soundBank), theme(new SkyBackground(), TILE_GRASS_LIGHT, TILE_GRASS_DARK), headless(headless), seed(seed), searchRandom(seed, RANDOM_STREAM_SEARCH) {
 	players.push_back(Player("Player 1"));
 	players.push_back(Player("Player 2"));
 
-	// Load all the music streams
-	musicNormal   = LoadMusicStream("resources/theme1_normal.wav");
-	musicIce      = LoadMusicStream("resources/theme1_ice.wav");
-	musicBreak    = LoadMusicStream("resources/theme1_break.wav");
-	musicConveyor = LoadMusicStream("resources/theme1_conveyor.wav");
-	musicPortal   = LoadMusicStream("resources/theme1_portal.wav");
+	board.getRandom().seed(seed, RANDOM_STREAM_BOARD);
+	theme.getBackground()->seed(seed);
 
-	SetMusicVolume(musicNormal, 1.0f);
-	SetMusicVolume(musicIce, 0.0f);
-	SetMusicVolume(musicBreak, 0.0f);
-	SetMusicVolume(musicConveyor, 0.0f);
-	SetMusicVolume(musicPortal, 0.0f);
+	if (headless) {
+		board.instantAnimations = true;
+		return; // No audio to load
+	}
+
+	soundBank.load(); // Load all the sound effects once, they're played from memory afterwards
 
-	PlayMusicStream(musicNormal);
-	PlayMusicStream(musicIce);
-	PlayMusicStream(musicBreak);
-	PlayMusicStream(musicConveyor);
-	PlayMusicStream(musicPortal);
+	musicMixer.setLayerVolume(MUSIC_NORMAL, 1.0f);
+	musicMixer.start(MUSIC_STEMS); // Stems of the soundtrack, mixed into a single stream
 }
 
 void Game::draw(raylib::Texture2D* atlas) {
 	theme.drawBackground();
 
-	board.draw(theme, renderQueue, getPlayerTurn(), selectedCell);
+	board.draw(theme, renderQueue);
+
+	Profiler::get().setSpriteCount(renderQueue.numberOfSpriteObjects());
 
 	renderQueue.sortQueue();
 	renderQueue.draw();
@@ -41,8 +39,19 @@ void Game::draw(raylib::Texture2D* atlas) {
 	}
 }
 
-void Game::update(raylib::Texture2D* atlas) {
-	theme.updateBackground(); // Update the theme
+void Game::prerender() {
+	board.updateHighlights(getPlayerTurn(), selectedCell);
+	board.renderStaticLayer(theme);
+}
+
+void Game::update() {
+	PROFILE_SCOPE("Game::update");
+
+	if (!headless) {
+		theme.updateBackground(); // Update the theme
+
+		AnimationTimeline::get().tick(); // Every animation reads the clock from here this frame
+	}
 
 	// Remove finished promotion menus
 	if (promotionMenu.has_value()) {
@@ -55,11 +64,13 @@ void Game::update(raylib::Texture2D* atlas) {
 	if (board.hasPromotion() && !promotionMenu.has_value()) {
 		Cell promotionCell = board.getPromotionCell();
 
-		if (board.getPiece(promotionCell)->getPlayer() == 1) {
+		int promotingPlayer = board.getPiece(promotionCell)->getPlayer();
+
+		if (promotingPlayer == 1 && !headless) {
 			promotionMenu = PromotionMenu(promotionCell);
 		} else {
 			// TODO: actually let the AI choose the piece to promote to, if it desires to underpromote for any reason
-			board.getTile(promotionCell)->setPiece(new Queen(atlas, 2)); // Automatically promote to queen for player 2
+			board.promotePiece(promotionCell, PieceType::QUEEN); // Automatically promote to queen for the AI
 		}
 	}
 
@@ -73,58 +84,26 @@ void Game::update(raylib::Texture2D* atlas) {
 
 			// Check if the current player has made a move
 			if (currentPlayer.hasMove()) {
-				cout << endl << "Player #" << getPlayerTurn() << " has made a move!" << endl;
+				GAME_LOG(endl << "Player #" << getPlayerTurn() << " has made a move!" << endl);
 				Move playerMove = currentPlayer.getMove(); // Get the player's move
+
+				if (onPlayerMove) onPlayerMove(playerMove);
+
+				if (!headless) turnStartState = getState(); // Diffed against the end of the turn so it can be undone
 				// Can add extra failsafe handling here if needed, but not for now
 
 				Piece* piece = board.getTile(playerMove.from)->getPiece(); // Get the piece the player is moving
 
-				// Since castling is the only move that moves 2 pieces at the same time, i'm just handling it here.
-				// It might be a good idea to test this with interactions though.
-
-				// Handle specific move flags
-				if (playerMove.flag.has_value()) {
-					switch (playerMove.flag.value()) {
-					case MoveFlag::CASTLE: { // King castling
-						cout << "Castled!" << endl;
-						int direction = (playerMove.to.file > playerMove.from.file) ? 1 : -1;
-
-						// Rook starts on the edge of the board depending on direction
-						int rookStartFile = (direction == 1) ? 7 : 0;
-						int rookEndFile = playerMove.from.file + direction;
-
-						Cell rookFrom(playerMove.from.rank, rookStartFile);
-						Cell rookTo(playerMove.from.rank, rookEndFile);
-
-						// Create and queue a rook move
-						Move rookMove(rookFrom, rookTo, false); // or whatever animation you prefer
-						board.queueMove(rookMove);
-						board.clearEnPassantableCell();
-						break;
-					}
-					case MoveFlag::EN_PASSANTABLE: { // Pawn moving two tiles
-						cout << "Piece is en passantable!" << endl;
-						board.setEnPassantableCell(playerMove.to); // Set the en passantable cell
-						break;
-					}
-					case MoveFlag::EN_PASSANT: { // Pawn taking a pawn in en passant
-						cout << "Player used en passant!" << endl;
-						break;
-					}
-					case MoveFlag::PROMOTION: { // Pawm moving to be promoted
-						cout << "Pawn is to be promoted!" << endl;
-						board.clearEnPassantableCell();
-						break;
-					}
-					}
-				}
-				else {
-					board.clearEnPassantableCell();
-				}
-
-				board.queueMove(playerMove); // Queue the player's move up
-
-				board.handlingPlayerTurn = true;
+				bool capture = board.getTile(playerMove.to)->hasPiece() || playerMove.flag == MoveFlag::EN_PASSANT;
+
+				halfmoveClock = (capture || piece->getType() == PieceType::PAWN) ? 0 : halfmoveClock + 1;
+
+				if (!headless) turnResolver.start(board, playerMove, getPlayerTurn()); // Resolve the turn while it animates
+
+				legalMoves = nullopt;
+				currentPlayerInCheck = nullopt;
+
+				board.startTurn(playerMove); // Queue the player's move up
 			}
 		}
 	}
@@ -134,16 +113,38 @@ void Game::update(raylib::Texture2D* atlas) {
 }
 
 void Game::updateState() {
+	PROFILE_SCOPE("Game::updateState");
+
 	updateWaitFrames = 60;
 	queuedForUpdate = false;
 
 	currentTurn++; // Next player's turn
 
+	legalMoves = nullopt;
+	currentPlayerInCheck = nullopt;
+
+	// Use the resolution from the worker if the board ended up where it expected
+	optional<TurnResolution> resolution = turnResolver.finish();
+
+	if (resolution && resolution->resolvedState != board.getState()) {
+		GAME_LOG("Turn resolution doesn't match the board, resolving it now" << endl);
+		resolution = nullopt;
+	}
+
 	// Check if the game ended
 	int currentPlayer = getPlayerTurn();
 
-	if (board.isInCheckmate(currentPlayer) || board.isInStalemate(currentPlayer)) {
+	bool checkmate = resolution ? resolution->checkmate : board.isInCheckmate(currentPlayer);
+	bool stalemate = resolution ? resolution->stalemate : !checkmate && board.isInStalemate(currentPlayer);
+
+	if (checkmate || stalemate) {
+		if (currentPlayer == 2 && checkmate) soundBank.play(SOUND_GAME_WIN);
+
 		gameEnd = true;
+
+		recordTurnHistory();
+
+		if (onStateUpdate) onStateUpdate();
 		return;
 	}
 
@@ -161,31 +162,47 @@ void Game::updateState() {
 			}),
 		activeEvents.end()
 	);
+
+	// Tile spawns come from the same random numbers, so this only misses if an event changed the board
+	if (resolution && resolution->nextState == board.getState()) {
+		legalMoves = move(resolution->legalMoves);
+		currentPlayerInCheck = resolution->inCheck;
+	}
+
+	recordTurnHistory();
+
+	if (onStateUpdate) onStateUpdate();
+}
+
+void Game::recordTurnHistory() {
+	if (headless) return; // Nobody to undo it
+
+	undoHistory.push_back({ GameStateDiff::between(turnStartState, getState()), (bool)gameEnd });
+	redoHistory.clear(); // A new turn replaces the ones that were undone
+
+	if (undoHistory.size() > GAME_UNDO_LIMIT) undoHistory.pop_front();
 }
 
 void Game::updateMusicStreams() {
+	PROFILE_SCOPE("Game::updateMusicStreams");
 
-	int numberOfIceTiles      = board.getTileCount<IceTile>();
-	int numberOfConveyorTiles = board.getTileCount<ConveyorTile>();
-	int numberOfBreakTiles    = board.getTileCount<BreakingTile>();
-	int numberOfPortalTiles   = board.getTileCount<PortalTile>();
+	const TileCounts& tileCounts = board.getTileCounts();
+
+	int numberOfIceTiles      = tileCounts.ice;
+	int numberOfConveyorTiles = tileCounts.conveyor;
+	int numberOfBreakTiles    = tileCounts.breaking;
+	int numberOfPortalTiles   = tileCounts.portal;
 
 	float iceVolume      = Clamp((float)numberOfIceTiles / 3.0f, 0.0f, 1.0f); // Reaches max volume at 3 ice tiles
 	float conveyorVolume = Clamp((float)numberOfConveyorTiles / 8.0f, 0.0f, 1.0f); // Reaches max volume at 8 conveyor tiles
 	float breakVolume    = Clamp((float)numberOfBreakTiles / 3.0f, 0.0f, 1.0f); // Reaches max volume at 3 break tiles
 	float portalVolume   = Clamp((float)numberOfPortalTiles / 6.0f, 0.0f, 1.0f); // Reaches max volume at 6 portal tiles
 
-	SetMusicVolume(musicIce, iceVolume);
-	SetMusicVolume(musicConveyor, conveyorVolume);
-	SetMusicVolume(musicBreak, breakVolume);
-	SetMusicVolume(musicPortal, portalVolume);
-
-
-	UpdateMusicStream(musicNormal);
-	UpdateMusicStream(musicIce);
-	UpdateMusicStream(musicBreak);
-	UpdateMusicStream(musicConveyor);
-	UpdateMusicStream(musicPortal);
+	// The mixer thread picks these up and fades to them, nothing has to be streamed from here
+	musicMixer.setLayerVolume(MUSIC_ICE, iceVolume);
+	musicMixer.setLayerVolume(MUSIC_CONVEYOR, conveyorVolume);
+	musicMixer.setLayerVolume(MUSIC_BREAK, breakVolume);
+	musicMixer.setLayerVolume(MUSIC_PORTAL, portalVolume);
 }
 
 void Game::setSelectedCell(Cell cell) { selectedCell = cell; }
@@ -196,7 +213,128 @@ RenderQueue& Game::getRenderQueue() { return renderQueue; }
 
 bool Game::getGameEnd() { return gameEnd; }
 
-bool Game::playerIsInCheck(int player) { return board.isInCheck(player); }
+Position Game::getPosition() { return getState().toPosition(); }
+
+void Game::setPosition(const Position& position) {
+	GameState state = GameState::fromPosition(position);
+	state.setRandom(board.getRandom()); // Positions don't have random numbers, so keep the board's
+
+	setState(state);
+}
+
+GameState Game::getState() {
+	GameState state = board.getState();
+
+	state.sideToMove = (uint8_t)getPlayerTurn();
+	state.halfmoveClock = (uint16_t)halfmoveClock;
+	state.fullmoveNumber = (uint16_t)(currentTurn / 2 + 1);
+
+	return state;
+}
+
+void Game::setState(const GameState& state) {
+	turnResolver.cancel();
+
+	legalMoves = nullopt;
+	currentPlayerInCheck = nullopt;
+
+	board.setState(state);
+
+	currentTurn = state.getPly();
+	halfmoveClock = state.halfmoveClock;
+	gameEnd = false;
+
+	promotionMenu = nullopt;
+
+	// The turns before don't lead here anymore
+	undoHistory.clear();
+	redoHistory.clear();
+}
+
+bool Game::canUndo() { return !undoHistory.empty() && (isPlayable() || gameEnd); }
+
+bool Game::canRedo() { return !redoHistory.empty() && (isPlayable() || gameEnd); }
+
+bool Game::undo() {
+	if (!canUndo()) return false;
+
+	applyTurnHistory(undoHistory.back(), false);
+
+	redoHistory.push_back(move(undoHistory.back()));
+	undoHistory.pop_back();
+
+	return true;
+}
+
+bool Game::redo() {
+	if (!canRedo()) return false;
+
+	applyTurnHistory(redoHistory.back(), true);
+
+	undoHistory.push_back(move(redoHistory.back()));
+	redoHistory.pop_back();
+
+	return true;
+}
+
+void Game::applyTurnHistory(const TurnHistory& turn, bool forward) {
+	turnResolver.cancel();
+
+	legalMoves = nullopt;
+	currentPlayerInCheck = nullopt;
+
+	// Only the changed cells and the scalars are read from the state, so the rest of it doesn't have to be filled in from the board
+	GameState state;
+
+	if (forward) turn.diff.redo(state);
+	else turn.diff.undo(state);
+
+	board.setState(state, turn.diff.getCells());
+
+	currentTurn = state.getPly();
+	halfmoveClock = state.halfmoveClock;
+	gameEnd = forward && turn.endedGame;
+
+	promotionMenu = nullopt;
+}
+
+void Game::loadFEN(const string& fen) { setPosition(parseFEN(fen)); }
+
+string Game::getFEN(bool includeTiles) { return writeFEN(getPosition(), includeTiles); }
+
+GameOutcome Game::getOutcome() {
+	if (!gameEnd) return GameOutcome::UNFINISHED;
+
+	int loser = getPlayerTurn();
+
+	if (board.isInCheckmate(loser)) return loser == 1 ? GameOutcome::PLAYER_2_WIN : GameOutcome::PLAYER_1_WIN;
+
+	return GameOutcome::STALEMATE;
+}
+
+bool Game::playerIsInCheck(int player) {
+	if (player != getPlayerTurn()) return board.isInCheck(player);
+
+	if (!currentPlayerInCheck) currentPlayerInCheck = board.isInCheck(player);
+
+	return currentPlayerInCheck.value();
+}
+
+const vector<Move>& Game::getLegalMoves() {
+	if (!legalMoves) legalMoves = board.getAllLegalMoves(getPlayerTurn());
+
+	return legalMoves.value();
+}
+
+bool Game::isLegalMove(Cell from, Cell to) { return getLegalMove(from, to).has_value(); }
+
+optional<Move> Game::getLegalMove(Cell from, Cell to) {
+	for (const Move& move : getLegalMoves()) {
+		if (move.from == from && move.to == to) return move;
+	}
+
+	return nullopt;
+}
 
 Player& Game::getPlayer(int player) {
 	if (player <= 0 || player > players.size()) {
@@ -209,6 +347,14 @@ Player& Game::getCurrentPlayer() {
 	return getPlayer(getPlayerTurn());
 }
 
+bool Game::isHeadless() { return headless; }
+
+uint64_t Game::getSeed() { return seed; }
+
+Random& Game::getSearchRandom() { return searchRandom; }
+
+SoundBank& Game::getSoundBank() { return soundBank; }
+
 Board& Game::getBoard() {
 	return board;
 }
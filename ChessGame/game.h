@@ -7,23 +7,50 @@
 #include "RenderQueue.h"
 #include "Theme.h"
 #include "PromotionMenu.h"
+#include "SoundBank.h"
+#include "MusicMixer.h"
+#include "Random.h"
+#include "TurnResolver.h"
 #include <optional>
+#include <functional>
+#include <deque>
+
+// Turns that can be undone, the oldest are dropped past this
+#define GAME_UNDO_LIMIT 256
+
+enum class GameOutcome {
+	PLAYER_1_WIN,
+	PLAYER_2_WIN,
+	STALEMATE,
+	PLY_LIMIT, // Stopped after too many plies, counted as a draw
+	UNFINISHED // Still being played, or abandoned
+};
+
+/// <summary>
+/// A turn that can be undone or redone
+/// </summary>
+struct TurnHistory {
+	GameStateDiff diff;
+	bool endedGame;
+};
 
 class Game {
 	private:
 		vector<Player> players;
+		SoundBank soundBank;
 		Board board;
 		vector<Event*> activeEvents;
 
 		int currentTurn = 0;
 
+		/// <summary>
+		/// Plies since the last capture or pawn move, only kept for FEN
+		/// </summary>
+		int halfmoveClock = 0;
+
 		int gameEnd = false;
 
-		raylib::Music musicNormal;
-		raylib::Music musicIce;
-		raylib::Music musicBreak;
-		raylib::Music musicConveyor;
-		raylib::Music musicPortal;
+		MusicMixer musicMixer;
 
 		RenderQueue renderQueue;
 
@@ -33,8 +60,68 @@ class Game {
 
 		optional<PromotionMenu> promotionMenu = nullopt;
 
+		/// <summary>
+		/// Running without a window or audio device, both players are AI and animations are skipped
+		/// </summary>
+		bool headless = false;
+
+		/// <summary>
+		/// The seed everything random in the game comes from
+		/// </summary>
+		uint64_t seed;
+
+		/// <summary>
+		/// Random numbers for the AI, each search takes its own seed from here
+		/// </summary>
+		Random searchRandom;
+
+		/// <summary>
+		/// Works out the end of each turn while its animations play, skipped when headless since turns don't animate
+		/// </summary>
+		TurnResolver turnResolver;
+
+		/// <summary>
+		/// Legal moves and check of the player to move, worked out once per turn
+		/// </summary>
+		optional<vector<Move>> legalMoves;
+		optional<bool> currentPlayerInCheck;
+
+		/// <summary>
+		/// Turns that were played and undone, newest at the back. Only kept when there's a player to undo them
+		/// </summary>
+		deque<TurnHistory> undoHistory;
+		vector<TurnHistory> redoHistory;
+
+		/// <summary>
+		/// The state when the turn being played started, diffed against the state it ends in
+		/// </summary>
+		GameState turnStartState;
+
+		/// <summary>
+		/// Applies a turn's diff backwards or forwards, only touching the cells it changed
+		/// </summary>
+		void applyTurnHistory(const TurnHistory& turn, bool forward);
+
+		/// <summary>
+		/// Diffs the turn that just ended against the state it started in, and adds it to the undo history
+		/// </summary>
+		void recordTurnHistory();
+
 	public:
-		Game(raylib::Texture2D* texture);
+		Game(raylib::Texture2D* texture, bool headless = false, uint64_t seed = Random::createSeed());
+
+		Game(const Game&) = delete;
+		Game& operator=(const Game&) = delete;
+
+		/// <summary>
+		/// Called whenever a player's move is taken to be played
+		/// </summary>
+		function<void(const Move&)> onPlayerMove;
+
+		/// <summary>
+		/// Called at the end of every turn, once it's the next player's turn or the game ended
+		/// </summary>
+		function<void()> onStateUpdate;
 
 		int updateWaitFrames = 60;
 		bool queuedForUpdate = false;
@@ -45,19 +132,33 @@ class Game {
 
 		void draw(raylib::Texture2D* atlas);
 
+		/// <summary>
+		/// Renders anything that has to be drawn off-screen, called before drawing begins
+		/// </summary>
+		void prerender();
+
 		/// <summary>
 		/// Update called every frame
 		/// </summary>
-		void update(raylib::Texture2D* atlas);
+		void update();
 
 		void updateState();
 
+		/// <summary>
+		/// Sets the volume of each music layer from the tiles on the board
+		/// </summary>
 		void updateMusicStreams();
 
 		void setSelectedCell(Cell cell);
 
 		bool isPlayable();
 
+		bool isHeadless();
+
+		uint64_t getSeed();
+
+		Random& getSearchRandom();
+
 		/// <summary>
 		/// Gets the render queue used for drawing the game
 		/// </summary>
@@ -70,6 +171,74 @@ class Game {
 		/// <returns>true if the game has ended, false if not</returns>
 		bool getGameEnd();
 
+		/// <summary>
+		/// Gets how the game ended
+		/// </summary>
+		/// <returns>The winner or a stalemate, UNFINISHED if the game hasn't ended</returns>
+		GameOutcome getOutcome();
+
+		/************************************|
+				 POSITION FUNCTIONS
+		|************************************/
+
+		/// <summary>
+		/// Gets the whole position of the game, including the side to move and clocks
+		/// </summary>
+		Position getPosition();
+
+		/// <summary>
+		/// Sets up the game from a position, the game continues from there
+		/// </summary>
+		void setPosition(const Position& position);
+
+		/// <summary>
+		/// Gets the whole state of the game as flat data, with the board's random numbers so it plays out the same from a copy
+		/// </summary>
+		GameState getState();
+
+		/// <summary>
+		/// Sets up the game from a state, dropping anything that was animating
+		/// </summary>
+		void setState(const GameState& state);
+
+		/************************************|
+				   UNDO FUNCTIONS
+		|************************************/
+
+		/// <summary>
+		/// If there's a turn to undo, and no turn being played that it would cut off
+		/// </summary>
+		bool canUndo();
+
+		/// <summary>
+		/// If there's an undone turn to play again
+		/// </summary>
+		bool canRedo();
+
+		/// <summary>
+		/// Takes back the last turn, the board jumps straight back to how it was before it
+		/// </summary>
+		/// <returns>true if a turn was undone</returns>
+		bool undo();
+
+		/// <summary>
+		/// Plays the last undone turn again, ending up exactly where it did the first time
+		/// </summary>
+		/// <returns>true if a turn was redone</returns>
+		bool redo();
+
+		/// <summary>
+		/// Sets up the game from a FEN, throws a runtime_error if the FEN is malformed
+		/// </summary>
+		/// <param name="fen">A standard FEN, or one with the extended tile fields</param>
+		void loadFEN(const string& fen);
+
+		/// <summary>
+		/// Gets the position of the game as FEN
+		/// </summary>
+		/// <param name="includeTiles">Adds the tile and frozen fields, leave out for FEN other programs can read</param>
+		string getFEN(bool includeTiles = true);
+
 		/************************************|
 				  PLAYER FUNCTIONS
 		|************************************/
@@ -87,6 +256,22 @@ class Game {
 		/// <returns>true if the player is in check, false if not</returns>
 		bool playerIsInCheck(int player);
 
+		/// <summary>
+		/// Gets every legal move of the player to move, they're only generated once a turn
+		/// </summary>
+		const vector<Move>& getLegalMoves();
+
+		/// <summary>
+		/// Checks if the player to move can move a piece from one cell to another
+		/// </summary>
+		bool isLegalMove(Cell from, Cell to);
+
+		/// <summary>
+		/// Gets the legal move from one cell to another, with its flags
+		/// </summary>
+		/// <returns>The move, or nullopt if it isn't legal</returns>
+		optional<Move> getLegalMove(Cell from, Cell to);
+
 		/// <summary>
 		/// Gets a player with their number
 		/// </summary>
@@ -109,6 +294,12 @@ class Game {
 		/// </summary>
 		/// <returns>A reference to the board in play</returns>
 		Board& getBoard();
+
+		/// <summary>
+		/// Gets the sound bank holding every sound effect
+		/// </summary>
+		/// <returns>A reference to the sound bank</returns>
+		SoundBank& getSoundBank();
 };
 
 #endif
\ No newline at end of file
@@ -6,11 +6,11 @@ Piece::Piece(raylib::Texture2D* texture, int player, PieceType pieceType) : atla
 
 }
 
-Piece::~Piece() {}
+Piece::~Piece() { removeAnimation(); }
 
 void Piece::draw(RenderQueue& renderQueue, float x, float y, float z, bool hidden) {
 	if (hasAnimation()) {
-		setOffset(animation->getPosition());
+		setOffset(AnimationTimeline::get().getPosition(animation));
     }
     else {
 		setOffset({ 0.0f, 0.0f, 0.0f });
@@ -32,23 +32,28 @@ void Piece::drawIcon(int x, int y) {
 }
 
 bool Piece::hasAnimation() {
-    return animation.has_value();
+    return animation.isValid();
 }
 
 void Piece::playAnimation(Animation anim) {
-    animation = anim;
-    animation.value().play();
+    removeAnimation();
+    animation = AnimationTimeline::get().play(anim);
 }
 
 bool Piece::animationFinished() {
     if (!hasAnimation()) return true;
 
-    if (animation->ended()) return true;
+    if (AnimationTimeline::get().ended(animation)) return true;
 
     return false;
 }
 
-void Piece::removeAnimation() { animation.reset(); }
+void Piece::removeAnimation() {
+    if (!hasAnimation()) return; // Pieces on boards without animations never touch the timeline
+
+    AnimationTimeline::get().stop(animation);
+    animation = AnimationHandle();
+}
 
 void Piece::setOffset(raylib::Vector3 offset) {
 	this->offset = offset;
@@ -141,6 +146,8 @@ void Piece::setFrozen(int frozenTurns) {
     frozen = frozenTurns;
 }
 
+int Piece::getFrozen() { return frozen; }
+
 bool Piece::getImmobile() {
     return frozen > 0;
 }
@@ -33,7 +33,7 @@ class Piece {
 
         PieceType pieceType;
 
-        optional<Animation> animation;
+        AnimationHandle animation; // Track on the animation timeline, invalid when the piece isn't animating
 
     public:
         Piece(raylib::Texture2D* texture, int player, PieceType pieceName);
@@ -152,6 +152,12 @@ class Piece {
         /// <param name="frozenTurns">The number of turns to freeze the piece for</param>
         void setFrozen(int frozenTurns);
 
+        /// <summary>
+        /// Gets the number of turns the piece stays frozen for
+        /// </summary>
+        /// <returns>The number of frozen turns left, 0 if the piece isn't frozen</returns>
+        int getFrozen();
+
         /// <summary>
         /// Determines if the piece is immobile
         /// </summary>
@@ -4,6 +4,17 @@
 
 Tile::Tile(int lifetime) : lifetime(lifetime) { }
 
+void Tile::draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) {
+    drawBase(theme, renderQueue, x, y, z, selected);
+    drawPiece(renderQueue, x, y, z, hide);
+}
+
+void Tile::drawPiece(RenderQueue& renderQueue, int x, int y, float z, bool hide) {
+    if (currentPiece != nullptr) {
+        currentPiece->draw(renderQueue, x, y, z, hide);
+    }
+}
+
 void Tile::update() {
 	if (currentPiece) {
 		currentPiece->update();
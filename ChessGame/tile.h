@@ -23,7 +23,20 @@ class Tile {
                  GAME LOOP FUNCTIONS
         |************************************/
 
-        virtual void draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide) = 0;
+        /// <summary>
+        /// Draws the tile and the piece on it
+        /// </summary>
+        void draw(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected, bool hide);
+
+        /// <summary>
+        /// Draws only the tile itself, without the piece on it
+        /// </summary>
+        virtual void drawBase(Theme& theme, RenderQueue& renderQueue, int x, int y, float z, bool selected) = 0;
+
+        /// <summary>
+        /// Draws only the piece on the tile, if there is one
+        /// </summary>
+        void drawPiece(RenderQueue& renderQueue, int x, int y, float z, bool hide);
 
         /// <summary>
         /// Update called every frame